@@ -0,0 +1,608 @@
+#include "src/audioBuffer.hpp"
+#include "src/compactAudioBuffer.hpp"
+#include "src/denormals.hpp"
+#include "src/expression.hpp"
+#include "src/fixedAudioBuffer.hpp"
+#include "src/kernels.hpp"
+#include "src/parallel.hpp"
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/* Benchmarks for the AudioBuffer hot paths. Build in Release mode, then run:
+
+	benchmarks [--filter <text>] [--json <file>] [--min-time <ms>]
+	           [--repeats <n>] [--seconds <n>]
+
+Each case is run until it takes at least 'min-time', then the best of
+'repeats' runs is reported as nanoseconds per frame and GB/s. The latter counts
+the bytes the operation reads and writes, not the actual memory traffic. Pass
+'--json -' to print JSON results on stdout. */
+
+using namespace mcl;
+
+namespace
+{
+constexpr int BLOCK_SIZES[]  = {32, 64, 128, 256, 512, 1024, 2048, 4096};
+constexpr int SAMPLE_RATE    = 48000;
+constexpr int STREAM_BLOCK   = 512;
+constexpr int UNALIGNED      = 3; // Offset in frames that breaks SIMD alignment
+constexpr int SAMPLE_SIZE    = sizeof(float);
+constexpr int LAYOUTS[][2]   = {{1, 1}, {1, 2}, {2, 2}, {2, 1}}; // {src, dest} channels
+constexpr int OFFSETS[][2]   = {{0, 0}, {0, UNALIGNED}, {UNALIGNED, 0}, {UNALIGNED, UNALIGNED}};
+constexpr int CHANNELS[]     = {1, 2};
+
+/* Options
+Command line settings. */
+
+struct Options
+{
+	std::string filter;
+	std::string jsonPath;
+	double      minTime  = 0.01; // Seconds
+	int         repeats  = 3;
+	int         seconds  = 60; // Length of the long sample
+	bool        showHelp = false;
+};
+
+/* Result
+Outcome of a single benchmark. */
+
+struct Result
+{
+	std::string name;
+	int         frames;
+	int         channels;
+	long        iterations;
+	double      nsPerFrame;
+	double      gbPerSec;
+};
+
+/* -------------------------------------------------------------------------- */
+
+const char* getIsaName(kernels::Isa isa)
+{
+	switch (isa)
+	{
+	case kernels::Isa::SCALAR:
+		return "scalar";
+	case kernels::Isa::SSE2:
+		return "sse2";
+	case kernels::Isa::AVX2:
+		return "avx2";
+	case kernels::Isa::NEON:
+		return "neon";
+	}
+	return "unknown";
+}
+
+/* -------------------------------------------------------------------------- */
+
+/* fill
+Fills the buffer with deterministic, non-silent data in [-1.0, 1.0]. */
+
+void fill(AudioBuffer& b)
+{
+	b.forEachSample([](float& v, int i) {
+		v = static_cast<float>((i * 37 + 11) % 101) / 50.0f - 1.0f;
+	});
+}
+
+/* -------------------------------------------------------------------------- */
+
+/* Runner
+Times benchmark cases and collects their results. */
+
+class Runner
+{
+public:
+	explicit Runner(const Options& options)
+	: m_options(options)
+	, m_report(options.jsonPath == "-" ? stderr : stdout) // Keep stdout clean for JSON
+	{
+		std::fprintf(m_report, "isa: %s\n", getIsaName(kernels::getBestIsa()));
+	}
+
+	/* run
+	Times 'f', which processes 'frames' frames of 'channels' channels per call,
+	reading and writing 'bytesPerFrame' bytes for each frame. */
+
+	template <typename F>
+	void run(const std::string& name, int frames, int channels, double bytesPerFrame, F&& f)
+	{
+		if (!m_options.filter.empty() && name.find(m_options.filter) == std::string::npos)
+			return;
+
+		/* Find out how many iterations fill the minimum time, then keep the
+		best out of a few runs. */
+
+		long   iterations = 1;
+		double elapsed    = measure(f, iterations);
+		while (elapsed < m_options.minTime)
+		{
+			iterations *= 2;
+			elapsed = measure(f, iterations);
+		}
+		for (int i = 1; i < m_options.repeats; i++)
+			elapsed = std::min(elapsed, measure(f, iterations));
+
+		const double seconds = elapsed / iterations;
+		const Result result{name, frames, channels, iterations,
+		    seconds * 1e9 / frames, bytesPerFrame * frames / seconds / 1e9};
+
+		std::fprintf(m_report, "%-44s %8d frames %9.3f ns/frame %8.2f GB/s\n", result.name.c_str(),
+		    result.frames, result.nsPerFrame, result.gbPerSec);
+		m_results.push_back(result);
+	}
+
+	/* writeJson
+	Writes all results collected so far as JSON. */
+
+	void writeJson(std::ostream& out) const
+	{
+		out << "{\n";
+		out << "  \"isa\": \"" << getIsaName(kernels::getBestIsa()) << "\",\n";
+		out << "  \"results\": [\n";
+		for (std::size_t i = 0; i < m_results.size(); i++)
+		{
+			const Result& r = m_results[i];
+			out << "    {\"name\": \"" << r.name << "\", \"frames\": " << r.frames
+			    << ", \"channels\": " << r.channels << ", \"iterations\": " << r.iterations
+			    << ", \"ns_per_frame\": " << r.nsPerFrame << ", \"gb_per_s\": " << r.gbPerSec
+			    << (i + 1 < m_results.size() ? "},\n" : "}\n");
+		}
+		out << "  ]\n";
+		out << "}\n";
+	}
+
+private:
+	template <typename F>
+	static double measure(F& f, long iterations)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		for (long i = 0; i < iterations; i++)
+			f(i);
+		const auto end = std::chrono::steady_clock::now();
+		return std::chrono::duration<double>(end - start).count();
+	}
+
+	const Options&      m_options;
+	std::FILE*          m_report;
+	std::vector<Result> m_results;
+};
+
+/* -------------------------------------------------------------------------- */
+
+/* Prevents the compiler from optimizing away results nobody looks at. */
+
+volatile float sink;
+
+/* -------------------------------------------------------------------------- */
+
+/* benchCopy
+AudioBuffer::sum() and set() for every channel layout and combination of
+aligned/unaligned source and destination offsets. */
+
+void benchCopy(Runner& runner, int frames)
+{
+	for (const auto& layout : LAYOUTS)
+	{
+		const int srcChannels  = layout[0];
+		const int destChannels = layout[1];
+
+		AudioBuffer src(frames + UNALIGNED, srcChannels);
+		AudioBuffer dest(frames + UNALIGNED, destChannels);
+		fill(src);
+		fill(dest);
+
+		for (const auto& offset : OFFSETS)
+		{
+			const std::string suffix = " " + std::to_string(srcChannels) + ">" + std::to_string(destChannels) +
+			                           " src+" + std::to_string(offset[0]) + " dest+" + std::to_string(offset[1]);
+
+			runner.run("sum" + suffix, frames, destChannels, (srcChannels + destChannels * 2) * SAMPLE_SIZE, [&](long i) {
+				dest.sum(src, frames, offset[0], offset[1], i & 1 ? 0.5f : -0.5f);
+			});
+			runner.run("set" + suffix, frames, destChannels, (srcChannels + destChannels) * SAMPLE_SIZE, [&](long) {
+				dest.set(src, frames, offset[0], offset[1], 0.5f);
+			});
+		}
+	}
+}
+
+/* -------------------------------------------------------------------------- */
+
+/* benchInPlace
+Operations working on a single buffer: gain, peak, clear and iteration. */
+
+void benchInPlace(Runner& runner, const std::string& prefix, AudioBuffer& buffer)
+{
+	const int         frames   = buffer.countFrames();
+	const int         channels = buffer.countChannels();
+	const double      size     = channels * SAMPLE_SIZE;
+	const std::string suffix   = " " + std::to_string(channels) + "ch";
+
+	fill(buffer);
+
+	runner.run(prefix + "applyGain" + suffix, frames, channels, size * 2, [&](long i) {
+		buffer.applyGain(i & 1 ? 2.0f : 0.5f);
+	});
+	runner.run(prefix + "getPeak" + suffix, frames, channels, size, [&](long) {
+		sink = buffer.getPeak(0);
+	});
+	runner.run(prefix + "forEachFrame" + suffix, frames, channels, size * 2, [&](long) {
+		buffer.forEachFrame([channels](float* frame, int) {
+			for (int ch = 0; ch < channels; ch++)
+				frame[ch] = frame[ch] * 0.5f + 0.25f;
+		});
+	});
+	runner.run(prefix + "forEachFrame std::function" + suffix, frames, channels, size * 2, [&](long) {
+		buffer.forEachFrame(std::function<void(float*, int)>([channels](float* frame, int) {
+			for (int ch = 0; ch < channels; ch++)
+				frame[ch] = frame[ch] * 0.5f + 0.25f;
+		}));
+	});
+	runner.run(prefix + "forEachSample" + suffix, frames, channels, size * 2, [&](long) {
+		buffer.forEachSample([](float& v, int) { v = v * 0.5f + 0.25f; });
+	});
+	runner.run(prefix + "forEachSample std::function" + suffix, frames, channels, size * 2, [&](long) {
+		buffer.forEachSample(std::function<void(float&, int)>([](float& v, int) { v = v * 0.5f + 0.25f; }));
+	});
+
+	/* clear() is O(1) on silent buffers: asking for a writable view marks the
+	buffer as dirty again, so that every iteration does the actual work. */
+
+	runner.run(prefix + "clear" + suffix, frames, channels, size, [&](long) {
+		buffer.view();
+		buffer.clear();
+	});
+	runner.run(prefix + "clear silent" + suffix, frames, channels, size, [&](long) {
+		buffer.clear();
+	});
+}
+
+/* -------------------------------------------------------------------------- */
+
+/* benchStrip
+A channel strip (set with gain and pan, fader, send, meter) done with separate
+calls and as a single fused expression. */
+
+void benchStrip(Runner& runner, int frames)
+{
+	AudioBuffer src(frames, 2), send(frames, 1), dest(frames, 2);
+	fill(src);
+	fill(send);
+
+	const AudioBuffer::Pan pan   = {1.0f, 0.7f};
+	const double           bytes = (2 + 1 + 2) * SAMPLE_SIZE;
+
+	runner.run("strip separate", frames, 2, bytes, [&](long) {
+		dest.set(src, 0.5f, pan);
+		dest.applyGain(0.8f);
+		dest.sum(send.view(), 0.3f);
+		sink = dest.getPeak(0) + dest.getPeak(1);
+	});
+	runner.run("strip fused", frames, 2, bytes, [&](long) {
+		std::array<float, 2> peaks;
+		assign(dest, expression::Term(std::as_const(src).view(), 0.5f, pan) * 0.8f + std::as_const(send).view() * 0.3f, peaks);
+		sink = peaks[0] + peaks[1];
+	});
+}
+
+/* -------------------------------------------------------------------------- */
+
+/* benchFade
+Equal-power fades through the cached curve tables, against the usual per-frame
+loop calling std::sin(). */
+
+void benchFade(Runner& runner, int frames)
+{
+	AudioBuffer a(frames, 2), b(frames, 2), dest(frames, 2);
+	fill(a);
+	fill(b);
+
+	/* Fades work on a fresh copy, or repeated runs would decay into 
+	denormals. */
+
+	runner.run("fadeOut forEachFrame", frames, 2, 3 * 2 * SAMPLE_SIZE, [&](long) {
+		dest.set(a, 1.0f);
+		dest.forEachFrame([frames](float* frame, int i) {
+			const float g = std::sin((1.0f - static_cast<float>(i) / frames) * 1.5707963f);
+			frame[0] *= g;
+			frame[1] *= g;
+		});
+	});
+	runner.run("fadeOut", frames, 2, 3 * 2 * SAMPLE_SIZE, [&](long) {
+		dest.set(a, 1.0f);
+		dest.fadeOut(FadeCurve::EQUAL_POWER);
+	});
+	runner.run("crossfade", frames, 2, 3 * 2 * SAMPLE_SIZE, [&](long) {
+		dest.crossfade(a.view(), b.view(), FadeCurve::EQUAL_POWER);
+	});
+}
+
+/* -------------------------------------------------------------------------- */
+
+/* benchDenormals
+The end of a release tail, mixed and attenuated: samples decay through the 
+subnormal range. Runs without protection, with both protection modes and on 
+a normal-range signal for reference. */
+
+void benchDenormals(Runner& runner, int frames)
+{
+	AudioBuffer tail(frames, 2), normal(frames, 2), dest(frames, 2);
+	tail.forEachFrame([](float* frame, int i) {
+		frame[0] = frame[1] = FLT_MIN * std::pow(0.9f, static_cast<float>(i % 64));
+	});
+	normal.forEachFrame([](float* frame, int i) {
+		frame[0] = frame[1] = std::pow(0.9f, static_cast<float>(i % 64));
+	});
+
+	const double bytes = (2 + 2 + 4 + 2 + 2 + 2) * SAMPLE_SIZE;
+
+	auto chain = [&dest](const AudioBuffer& src) {
+		dest.set(src, 0.5f);
+		dest.sum(src, 0.7f);
+		dest.applyGain(0.5f);
+	};
+
+	runner.run("decay unprotected", frames, 2, bytes, [&](long) {
+		chain(tail);
+	});
+	runner.run("decay flush hardware", frames, 2, bytes, [&](long) {
+		const denormals::ScopedFlushToZero guard(denormals::Mode::HARDWARE);
+		chain(tail);
+	});
+	runner.run("decay flush software", frames, 2, bytes, [&](long) {
+		const denormals::ScopedFlushToZero guard(denormals::Mode::SOFTWARE);
+		chain(tail);
+	});
+	runner.run("decay normal range", frames, 2, bytes, [&](long) {
+		chain(normal);
+	});
+}
+
+/* -------------------------------------------------------------------------- */
+
+/* benchFixed
+Stereo block processing on FixedAudioBuffer, to compare against the dynamic 
+AudioBuffer cases of the same size. */
+
+template <int Frames>
+void benchFixed(Runner& runner)
+{
+	FixedAudioBuffer<Frames, 2> src, dest;
+	FixedAudioBuffer<Frames, 1> mono;
+	for (int i = 0; i < Frames * 2; i++)
+		src[0][i] = static_cast<float>((i * 37 + 11) % 101) / 50.0f - 1.0f;
+	for (int i = 0; i < Frames; i++)
+		mono[i][0] = src[0][i];
+
+	runner.run("fixed sum 2>2", Frames, 2, 6 * SAMPLE_SIZE, [&](long i) {
+		dest.sum(src, i % 2 ? 0.5f : -0.5f);
+	});
+	runner.run("fixed set 1>2", Frames, 2, 3 * SAMPLE_SIZE, [&](long) {
+		dest.set(mono, 0.5f);
+	});
+	runner.run("fixed applyGain 2", Frames, 2, 4 * SAMPLE_SIZE, [&](long i) {
+		dest.applyGain(i % 2 ? 0.5f : 2.0f);
+	});
+	runner.run("fixed clear 2", Frames, 2, 2 * SAMPLE_SIZE, [&](long) {
+		dest.clear();
+	});
+	sink = dest.getPeak(0);
+}
+
+/* -------------------------------------------------------------------------- */
+
+/* benchParallel
+Offline operations on the long sample, split across a thread pool. Compare 
+with the "sample" in-place cases for the speedup. */
+
+void benchParallel(Runner& runner, parallel::ThreadPool& pool, AudioBuffer& sample)
+{
+	const int             frames   = sample.countFrames();
+	const int             channels = sample.countChannels();
+	const double          size     = channels * SAMPLE_SIZE;
+	const std::string     suffix   = " " + std::to_string(channels) + "ch x" + std::to_string(pool.countWorkers() + 1);
+	const AudioBufferView view     = sample.view();
+
+	AudioBuffer dest(frames, channels);
+
+	runner.run("parallel applyGain" + suffix, frames, channels, size * 2, [&](long i) {
+		parallel::applyGain(pool, view, i & 1 ? 2.0f : 0.5f);
+	});
+	runner.run("parallel getPeak" + suffix, frames, channels, size, [&](long) {
+		sink = parallel::getPeak(pool, view, 0);
+	});
+	runner.run("parallel analyze" + suffix, frames, channels, size, [&](long) {
+		std::array<ChannelStats, AudioBuffer::MAX_CHANS> stats;
+		parallel::analyze(pool, view, stats);
+		sink = stats[0].rms;
+	});
+	runner.run("parallel sum" + suffix, frames, channels, size * 3, [&](long i) {
+		parallel::sum(pool, dest, view, i & 1 ? 0.5f : -0.5f);
+	});
+}
+
+/* -------------------------------------------------------------------------- */
+
+/* benchWaveform
+Redrawing the waveform of a long sample, WAVEFORM_COLUMNS min/max pairs on the
+first channel, by scanning it or through a peak pyramid; then the cost of 
+bringing the pyramid up to date after a single-block edit, and after writing 
+every frame through operator []. */
+
+constexpr int WAVEFORM_COLUMNS = 1000;
+
+void benchWaveform(Runner& runner, const AudioBuffer& sample)
+{
+	const int         frames   = sample.countFrames();
+	const int         channels = sample.countChannels();
+	const std::string suffix   = " " + std::to_string(channels) + "ch";
+
+	AudioBuffer cached(sample);
+	cached.setPeakPyramid(true);
+	sink = cached.getPeak(0); // First build
+
+	auto draw = [frames](const AudioBuffer& b) {
+		float sum = 0.0f;
+		for (int col = 0; col < WAVEFORM_COLUMNS; col++)
+		{
+			const PeakRange range = b.getPeakRange(0, static_cast<long>(frames) * col / WAVEFORM_COLUMNS,
+			    static_cast<long>(frames) * (col + 1) / WAVEFORM_COLUMNS);
+			sum += range.max - range.min;
+		}
+		sink = sum;
+	};
+
+	runner.run("waveform scan" + suffix, frames, channels, channels * SAMPLE_SIZE, [&](long) {
+		draw(sample);
+	});
+	runner.run("waveform pyramid" + suffix, frames, channels, channels * SAMPLE_SIZE, [&](long) {
+		draw(cached);
+	});
+	runner.run("waveform pyramid edit" + suffix, frames, channels, channels * SAMPLE_SIZE, [&](long i) {
+		cached.applyGain(i & 1 ? 2.0f : 0.5f, (frames / 2) * channels, (frames / 2 + 256) * channels);
+		draw(cached);
+	});
+	runner.run("waveform pyramid operator[]" + suffix, frames, channels, channels * SAMPLE_SIZE * 2, [&](long i) {
+		const float gain = i & 1 ? 2.0f : 0.5f;
+		for (int k = 0; k < frames; k++)
+			cached[k][0] *= gain;
+		draw(cached);
+	});
+}
+
+/* -------------------------------------------------------------------------- */
+
+/* benchStream
+Plays a long sample block by block onto a small buffer, as a voice would:
+data is streamed from main memory rather than cache. */
+
+void benchStream(Runner& runner, const AudioBuffer& sample, int destChannels)
+{
+	const int   frames      = sample.countFrames();
+	const int   srcChannels = sample.countChannels();
+	AudioBuffer block(STREAM_BLOCK, destChannels);
+
+	const std::string name = "stream sum " + std::to_string(srcChannels) + ">" + std::to_string(destChannels) +
+	                         " " + std::to_string(STREAM_BLOCK) + "-frame blocks";
+
+	runner.run(name, frames, destChannels, (srcChannels + destChannels * 2) * SAMPLE_SIZE, [&](long) {
+		for (int f = 0; f < frames; f += STREAM_BLOCK)
+			block.sum(sample, STREAM_BLOCK, f, 0, 0.5f);
+		sink = std::as_const(block)[0][0];
+	});
+
+	/* Same, streaming from 16-bit storage: half the bytes to read. */
+
+	for (CompactFormat format : {CompactFormat::INT16, CompactFormat::FLOAT16})
+	{
+		const CompactAudioBuffer     compact(sample.view(), format);
+		const CompactAudioBufferView view = compact.view();
+		const std::string            type = format == CompactFormat::INT16 ? "int16" : "float16";
+
+		runner.run("stream sum " + type + " " + name.substr(11), frames, destChannels, (srcChannels / 2.0 + destChannels * 2) * SAMPLE_SIZE, [&](long) {
+			for (int f = 0; f < frames; f += STREAM_BLOCK)
+				block.sum(view.slice(f, std::min(STREAM_BLOCK, frames - f)), 0.5f);
+			sink = std::as_const(block)[0][0];
+		});
+	}
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool parse(int argc, char** argv, Options& options)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string arg  = argv[i];
+		const bool        more = i + 1 < argc;
+		if (arg == "--filter" && more)
+			options.filter = argv[++i];
+		else if (arg == "--json" && more)
+			options.jsonPath = argv[++i];
+		else if (arg == "--min-time" && more)
+			options.minTime = std::stod(argv[++i]) / 1000.0;
+		else if (arg == "--repeats" && more)
+			options.repeats = std::max(1, std::stoi(argv[++i]));
+		else if (arg == "--seconds" && more)
+			options.seconds = std::max(1, std::stoi(argv[++i]));
+		else if (arg == "--help")
+			options.showHelp = true;
+		else
+			return false;
+	}
+	return true;
+}
+} // namespace
+
+/* -------------------------------------------------------------------------- */
+
+int main(int argc, char** argv)
+{
+	Options options;
+	if (!parse(argc, argv, options) || options.showHelp)
+	{
+		std::printf("usage: benchmarks [--filter <text>] [--json <file>|-] [--min-time <ms>] "
+		            "[--repeats <n>] [--seconds <n>]\n");
+		return options.showHelp ? 0 : 1;
+	}
+
+	Runner runner(options);
+
+	for (int frames : BLOCK_SIZES)
+	{
+		benchCopy(runner, frames);
+		benchStrip(runner, frames);
+		benchFade(runner, frames);
+		benchDenormals(runner, frames);
+		for (int channels : CHANNELS)
+		{
+			AudioBuffer buffer(frames, channels);
+			benchInPlace(runner, "", buffer);
+		}
+	}
+
+	parallel::ThreadPool pool;
+
+	benchFixed<32>(runner);
+	benchFixed<128>(runner);
+	benchFixed<512>(runner);
+
+	for (int channels : CHANNELS)
+	{
+		AudioBuffer sample(options.seconds * SAMPLE_RATE, channels);
+		fill(sample);
+		for (int destChannels : CHANNELS)
+			benchStream(runner, sample, destChannels);
+		benchInPlace(runner, "sample ", sample);
+		benchParallel(runner, pool, sample);
+		benchWaveform(runner, sample);
+	}
+
+	if (options.jsonPath == "-")
+	{
+		runner.writeJson(std::cout);
+	}
+	else if (!options.jsonPath.empty())
+	{
+		std::ofstream file(options.jsonPath);
+		runner.writeJson(file);
+		if (!file)
+		{
+			std::fprintf(stderr, "unable to write %s\n", options.jsonPath.c_str());
+			return 1;
+		}
+	}
+	return 0;
+}
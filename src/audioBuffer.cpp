@@ -25,25 +25,67 @@
  * -------------------------------------------------------------------------- */
 
 #include "audioBuffer.hpp"
+#include "compactAudioBuffer.hpp"
+#include "denormals.hpp"
+#include "instrumentation.hpp"
+#include "kernels.hpp"
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cmath>
+#include <utility>
 
 namespace mcl
 {
+/* SharedStorage
+Memory shared among several buffers. Blocks whose last reference is gone are
+pushed onto a lock-free list ('retired'), to be freed later by 
+AudioBuffer::reclaimShared(). Only reclaimShared() pops from the list and it 
+takes the whole of it at once, so pushing is ABA-free. */
+
+struct AudioBuffer::SharedStorage
+{
+	static void retire(SharedStorage* s)
+	{
+		s->next = retired.load(std::memory_order_relaxed);
+		while (!retired.compare_exchange_weak(s->next, s, std::memory_order_release, std::memory_order_relaxed))
+			;
+	}
+
+	static void release(SharedStorage* s)
+	{
+		if (s->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			retire(s);
+	}
+
+	static inline std::atomic<SharedStorage*> retired = nullptr;
+
+	float*           data; // Nullptr if taken over by its last holder
+	std::atomic<int> refs;
+	SharedStorage*   next;
+};
+
+/* -------------------------------------------------------------------------- */
+
 AudioBuffer::AudioBuffer()
 : m_data(nullptr)
 , m_size(0)
 , m_channels(0)
+, m_capacity(0)
 , m_viewing(false)
+, m_dirtyBegin(0)
+, m_dirtyEnd(0)
+, m_shared(nullptr)
+, m_peaks(nullptr)
 {
 }
 
 /* -------------------------------------------------------------------------- */
 
-AudioBuffer::AudioBuffer(int size, int channels)
+AudioBuffer::AudioBuffer(int size, int channels, Init init)
 : AudioBuffer()
 {
-	alloc(size, channels);
+	alloc(size, channels, init);
 }
 
 /* -------------------------------------------------------------------------- */
@@ -52,14 +94,20 @@ AudioBuffer::AudioBuffer(float* data, int size, int channels)
 : m_data(data)
 , m_size(size)
 , m_channels(channels)
+, m_capacity(0)
 , m_viewing(true)
+, m_dirtyBegin(0)
+, m_dirtyEnd(size)
+, m_shared(nullptr)
+, m_peaks(nullptr)
 {
-	assert(channels <= NUM_CHANS);
+	assert(channels <= MAX_CHANS);
 }
 
 /* -------------------------------------------------------------------------- */
 
 AudioBuffer::AudioBuffer(const AudioBuffer& o)
+: AudioBuffer()
 {
 	copy(o);
 }
@@ -67,6 +115,7 @@ AudioBuffer::AudioBuffer(const AudioBuffer& o)
 /* -------------------------------------------------------------------------- */
 
 AudioBuffer::AudioBuffer(AudioBuffer&& o) noexcept
+: AudioBuffer()
 {
 	move(std::move(o));
 }
@@ -100,22 +149,74 @@ AudioBuffer& AudioBuffer::operator=(AudioBuffer&& o) noexcept
 
 /* -------------------------------------------------------------------------- */
 
-float* AudioBuffer::operator[](int offset) const
+float* AudioBuffer::operator[](int offset)
+{
+	markDirty(0, m_size);
+	return const_cast<float*>(std::as_const(*this)[offset]);
+}
+
+const float* AudioBuffer::operator[](int offset) const
 {
 	assert(m_data != nullptr);
-	assert(offset < m_size);
+	assert(offset >= 0 && offset < m_size);
 	return m_data.get() + (offset * m_channels);
 }
 
 /* -------------------------------------------------------------------------- */
 
+float* AudioBuffer::getData()
+{
+	markDirty(0, m_size);
+	return m_data.get();
+}
+
+const float* AudioBuffer::getData() const { return m_data.get(); }
+int          AudioBuffer::getStride() const { return m_channels; }
+
+/* -------------------------------------------------------------------------- */
+
+AudioBufferView AudioBuffer::view()
+{
+	markDirty(0, m_size);
+	return rawView();
+}
+
+AudioBufferView AudioBuffer::view() const { return rawView(); }
+
+AudioBufferView AudioBuffer::view(int start, int count)
+{
+	const AudioBufferView out = rawView().slice(start, count);
+	markDirty(start, start + out.countFrames());
+	return out;
+}
+
+AudioBuffer::operator AudioBufferView() { return view(); }
+AudioBuffer::operator AudioBufferView() const { return view(); }
+
+AudioBufferView AudioBuffer::rawView() const
+{
+	return AudioBufferView(m_data.get(), m_size, m_channels);
+}
+
+/* -------------------------------------------------------------------------- */
+
 void AudioBuffer::clear(int a, int b)
 {
 	if (m_data == nullptr)
 		return;
 	if (b == -1)
 		b = m_size;
-	std::fill_n(m_data.get() + (a * m_channels), (b - a) * m_channels, 0.0);
+
+	/* Frames outside the dirty range are 0.0f already. */
+
+	const int start = std::max(a, m_dirtyBegin);
+	const int end   = std::min(b, m_dirtyEnd);
+	if (start < end)
+	{
+		detach();
+		rawView().slice(start, end - start).clear();
+	}
+	markClean(a, b);
 }
 
 /* -------------------------------------------------------------------------- */
@@ -123,10 +224,20 @@ void AudioBuffer::clear(int a, int b)
 int  AudioBuffer::countFrames() const { return m_size; }
 int  AudioBuffer::countSamples() const { return m_size * m_channels; }
 int  AudioBuffer::countChannels() const { return m_channels; }
+int  AudioBuffer::getCapacity() const { return m_capacity; }
 bool AudioBuffer::isAllocd() const { return m_data != nullptr; }
 
 /* -------------------------------------------------------------------------- */
 
+bool AudioBuffer::isSilent(int a, int b) const
+{
+	if (b == -1)
+		b = m_size;
+	return a >= b || b <= m_dirtyBegin || a >= m_dirtyEnd;
+}
+
+/* -------------------------------------------------------------------------- */
+
 float AudioBuffer::getPeak(int channel, int a, int b) const
 {
 	assert(channel < m_channels);
@@ -137,37 +248,166 @@ float AudioBuffer::getPeak(int channel, int a, int b) const
 	if (b == -1)
 		b = countFrames();
 
-	float peak = 0.0f;
-	for (int i = a; i < b; i++)
-		peak = std::max(peak, (*this)[i][channel]);
-	return peak;
+	if (m_peaks != nullptr)
+	{
+		const PeakRange range = getPeakRange(channel, a, b);
+		return std::max(std::fabs(range.min), std::fabs(range.max));
+	}
+
+	/* The peak of a silent range is 0.0f: only scan the dirty part. */
+
+	a = std::max(a, m_dirtyBegin);
+	b = std::min(b, m_dirtyEnd);
+	if (a >= b)
+		return 0.0f;
+
+	return rawView().slice(a, b - a).getPeak(channel);
 }
 
 /* -------------------------------------------------------------------------- */
 
-void AudioBuffer::alloc(int size, int channels)
+PeakRange AudioBuffer::getPeakRange(int channel, int a, int b) const
 {
-	assert(channels <= NUM_CHANS);
+	assert(channel < m_channels);
+	assert(a >= 0);
+	assert(b == -1 || a < b);
+	assert(b == -1 || b <= countFrames());
 
-	free();
-	m_size     = size;
-	m_channels = channels;
-	m_data     = std::make_unique<float[]>(m_size * m_channels);
-	clear();
+	if (b == -1)
+		b = countFrames();
+
+	if (m_peaks != nullptr)
+	{
+		m_peaks->update(rawView());
+		return m_peaks->getRange(rawView(), channel, a, b);
+	}
+
+	/* Only scan the dirty part. Silent frames left out still count as 0.0f. */
+
+	const int start = std::max(a, m_dirtyBegin);
+	const int end   = std::min(b, m_dirtyEnd);
+	if (start >= end)
+		return {};
+
+	ChannelStats stats;
+	rawView().slice(start, end - start).channel(channel).analyze({&stats, 1});
+
+	if (start > a || end < b)
+		return {std::min(stats.min, 0.0f), std::max(stats.max, 0.0f)};
+	return {stats.min, stats.max};
+}
+
+/* -------------------------------------------------------------------------- */
+
+void AudioBuffer::setPeakPyramid(bool enabled)
+{
+	if (!enabled)
+		m_peaks.reset();
+	else if (m_peaks == nullptr)
+		m_peaks = std::make_unique<PeakPyramid>();
+}
+
+bool AudioBuffer::hasPeakPyramid() const { return m_peaks != nullptr; }
+
+/* -------------------------------------------------------------------------- */
+
+void AudioBuffer::analyze(std::span<ChannelStats> stats, float clipThreshold) const
+{
+	if (isSilent())
+	{
+		assert(stats.size() >= static_cast<std::size_t>(m_channels));
+		std::fill_n(stats.begin(), m_channels, ChannelStats{});
+		return;
+	}
+	rawView().analyze(stats, clipThreshold);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void AudioBuffer::alloc(int size, int channels, Init init)
+{
+	assert(channels <= MAX_CHANS);
+
+	/* Reuse the current memory block if it's big enough. */
+
+	if (m_viewing || m_shared != nullptr || size * channels > m_capacity)
+	{
+		MCL_INSTRUMENT_SCOPE(instrumentation::Operation::ALLOC, size, memory::padSamples(size * channels) * sizeof(float));
+
+		free();
+		m_data.reset(memory::allocAligned(size * channels));
+		m_capacity = static_cast<int>(memory::padSamples(size * channels));
+	}
+
+	m_size       = size;
+	m_channels   = channels;
+	m_dirtyBegin = 0;
+	m_dirtyEnd   = size; // Content is unknown until cleared
+	invalidatePeaks(0, size);
+	if (init == Init::ZERO)
+		clear();
+}
+
+/* -------------------------------------------------------------------------- */
+
+void AudioBuffer::reserve(int size, int channels)
+{
+	assert(channels <= MAX_CHANS);
+
+	if (!m_viewing && size * channels <= m_capacity)
+		return;
+	reallocate(size * channels);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void AudioBuffer::resize(int size, Init init)
+{
+	assert(m_channels > 0);
+	assert(size >= 0);
+
+	if (m_viewing || size * m_channels > m_capacity)
+		reallocate(size * m_channels);
+
+	const int oldSize = m_size;
+	m_size            = size;
+	if (size < oldSize)
+	{
+		markClean(size, oldSize);
+		return;
+	}
+	markDirty(oldSize, size); // New frames hold garbage until cleared
+	if (init == Init::ZERO)
+		clear(oldSize, size);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void AudioBuffer::shrinkToFit()
+{
+	if (m_viewing || m_shared != nullptr || m_data == nullptr)
+		return;
+	if (static_cast<int>(memory::padSamples(countSamples())) < m_capacity)
+		reallocate(countSamples());
 }
 
 /* -------------------------------------------------------------------------- */
 
 void AudioBuffer::free()
 {
-	if (m_viewing)
-		m_data.release();
-	else
-		m_data.reset();
+	releaseData();
 
-	m_size     = 0;
-	m_channels = 0;
-	m_viewing  = false;
+	m_size       = 0;
+	m_channels   = 0;
+	m_capacity   = 0;
+	m_viewing    = false;
+	m_dirtyBegin = 0;
+	m_dirtyEnd   = 0;
+
+	/* The pyramid stays attached, but describes no signal anymore. */
+
+	if (m_peaks != nullptr)
+		*m_peaks = PeakPyramid();
 }
 
 /* -------------------------------------------------------------------------- */
@@ -194,39 +434,128 @@ void AudioBuffer::set(const AudioBuffer& b, float gain, Pan pan)
 	copyData<Operation::SET>(b, -1, 0, 0, gain, pan);
 }
 
+void AudioBuffer::sum(AudioBufferView b, float gain, Pan pan)
+{
+	assert(m_data != nullptr);
+	markDirty(0, std::min(m_size, b.countFrames()));
+	rawView().sum(b, gain, pan);
+}
+
+void AudioBuffer::set(AudioBufferView b, float gain, Pan pan)
+{
+	assert(m_data != nullptr);
+	markDirty(0, std::min(m_size, b.countFrames()));
+	rawView().set(b, gain, pan);
+}
+
+void AudioBuffer::sum(AudioBufferView b, const ChannelMatrix& matrix, float gain, Pan pan)
+{
+	assert(m_data != nullptr);
+	markDirty(0, std::min(m_size, b.countFrames()));
+	rawView().sum(b, matrix, gain, pan);
+}
+
+void AudioBuffer::set(AudioBufferView b, const ChannelMatrix& matrix, float gain, Pan pan)
+{
+	assert(m_data != nullptr);
+	markDirty(0, std::min(m_size, b.countFrames()));
+	rawView().set(b, matrix, gain, pan);
+}
+
+double AudioBuffer::sum(AudioBufferView b, double pos, double step, Interpolation interp, float gain, Pan pan)
+{
+	assert(m_data != nullptr);
+	markDirty(0, m_size);
+	return rawView().sum(b, pos, step, interp, gain, pan);
+}
+
+double AudioBuffer::set(AudioBufferView b, double pos, double step, Interpolation interp, float gain, Pan pan)
+{
+	assert(m_data != nullptr);
+	markDirty(0, m_size);
+	return rawView().set(b, pos, step, interp, gain, pan);
+}
+
+void AudioBuffer::sum(CompactAudioBufferView b, float gain, Pan pan)
+{
+	assert(m_data != nullptr);
+	markDirty(0, std::min(m_size, b.countFrames()));
+	rawView().sum(b, gain, pan);
+}
+
+void AudioBuffer::set(CompactAudioBufferView b, float gain, Pan pan)
+{
+	assert(m_data != nullptr);
+	markDirty(0, std::min(m_size, b.countFrames()));
+	rawView().set(b, gain, pan);
+}
+
+void AudioBuffer::sum(std::span<const MixSource> sources)
+{
+	assert(m_data != nullptr);
+	for (const MixSource& source : sources)
+		markDirty(source.destOffset, std::min(m_size, source.destOffset + source.src.countFrames()));
+	rawView().sum(sources);
+}
+
+void AudioBuffer::sum(AudioBufferView b, Ramp<float> gain, Ramp<Pan> pan)
+{
+	assert(m_data != nullptr);
+	markDirty(0, std::min(m_size, b.countFrames()));
+	rawView().sum(b, gain, pan);
+}
+
+void AudioBuffer::set(AudioBufferView b, Ramp<float> gain, Ramp<Pan> pan)
+{
+	assert(m_data != nullptr);
+	markDirty(0, std::min(m_size, b.countFrames()));
+	rawView().set(b, gain, pan);
+}
+
 /* -------------------------------------------------------------------------- */
 
 template <AudioBuffer::Operation O>
 void AudioBuffer::copyData(const AudioBuffer& b, int framesToCopy,
     int srcOffset, int destOffset, float gain, Pan pan)
 {
-	const int  srcChannels  = b.countChannels();
-	const int  destChannels = countChannels();
-	const bool sameChannels = srcChannels == destChannels;
-
 	assert(m_data != nullptr);
 	assert(destOffset >= 0 && destOffset < m_size);
-	assert(srcChannels <= destChannels);
+	assert(srcOffset >= 0);
 
-	/* Make sure the amount of frames to copy lies within the current buffer 
-	size. */
+	/* Make sure the amount of frames to copy lies within both the current 
+	buffer size and the source buffer size. */
 
 	framesToCopy = framesToCopy == -1 ? b.countFrames() : framesToCopy;
 	framesToCopy = std::min(framesToCopy, m_size - destOffset);
+	framesToCopy = std::min(framesToCopy, b.countFrames() - srcOffset);
+
+	if (framesToCopy <= 0)
+		return;
 
-	/* Case 1) source has less channels than this one: brutally spread source's
-	channel 0 over this one (TODO - maybe mixdown source channels first?)
-	   Case 2) source has same amount of channels: copy them 1:1. */
+	/* Only the dirty part of the source needs processing, in frames relative 
+	to the start of the copy. Outside of it the source is 0.0f: nothing to 
+	merge, or just something to clear. */
 
-	for (int destF = 0, srcF = srcOffset; destF < framesToCopy && destF < b.countFrames(); destF++, srcF++)
+	const int start = std::clamp(b.m_dirtyBegin - srcOffset, 0, framesToCopy);
+	const int end   = std::clamp(b.m_dirtyEnd - srcOffset, start, framesToCopy);
+
+	if (start < end)
+	{
+		markDirty(destOffset + start, destOffset + end);
+
+		const AudioBufferView dest = rawView().slice(destOffset + start, end - start);
+		const AudioBufferView src  = b.rawView().slice(srcOffset + start, end - start);
+
+		if constexpr (O == Operation::SUM)
+			dest.sum(src, gain, pan);
+		else
+			dest.set(src, gain, pan);
+	}
+
+	if constexpr (O == Operation::SET)
 	{
-		for (int ch = 0; ch < destChannels; ch++)
-		{
-			if constexpr (O == Operation::SUM)
-				sum(destF + destOffset, ch, b[srcF][sameChannels ? ch : 0] * gain * pan[ch]);
-			else
-				set(destF + destOffset, ch, b[srcF][sameChannels ? ch : 0] * gain * pan[ch]);
-		}
+		clear(destOffset, destOffset + start);
+		clear(destOffset + end, destOffset + framesToCopy);
 	}
 }
 
@@ -243,68 +572,349 @@ void AudioBuffer::applyGain(float g, int a, int b)
 		assert(a < b);
 	}
 
-	for (int i = a; i < b; i++)
+	if (m_data == nullptr)
+		return;
+
+	/* Silent samples stay silent whatever the gain: only the dirty range needs
+	processing. */
+
+	const int start = std::max(a, m_dirtyBegin * m_channels);
+	const int end   = std::min(b, m_dirtyEnd * m_channels);
+	if (start < end)
+	{
+		detach();
+		invalidatePeaks(start / m_channels, (end + m_channels - 1) / m_channels);
+	}
+
+	MCL_INSTRUMENT_SCOPE(instrumentation::Operation::APPLY_GAIN, std::max(end - start, 0) / m_channels,
+	    std::max(end - start, 0) * sizeof(float));
+
+	if (g == 0.0f)
+	{
+		if (start < end)
+			std::fill(m_data.get() + start, m_data.get() + end, 0.0f);
+		markClean((a + m_channels - 1) / m_channels, b / m_channels); // Whole frames only
+		return;
+	}
+
+	for (int i = start; i < end; i++)
 		m_data.get()[i] *= g;
+
+	if (start < end && denormals::isSoftwareFlushEnabled())
+		kernels::getTable().flushDenormals(m_data.get() + start, end - start);
+}
+
+void AudioBuffer::applyGain(Ramp<float> gain)
+{
+	detach();
+	invalidatePeaks(0, m_size);
+	rawView().applyGain(gain);
 }
 
 /* -------------------------------------------------------------------------- */
 
-void AudioBuffer::sum(int f, int channel, float val) { (*this)[f][channel] += val; }
-void AudioBuffer::set(int f, int channel, float val) { (*this)[f][channel] = val; }
+void AudioBuffer::fadeIn(FadeCurve curve, int length, int offset)
+{
+	detach();
+	invalidatePeaks(0, m_size);
+	rawView().fadeIn(curve, length, offset);
+}
+
+void AudioBuffer::fadeOut(FadeCurve curve, int length, int offset)
+{
+	detach();
+	invalidatePeaks(0, m_size);
+	rawView().fadeOut(curve, length, offset);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void AudioBuffer::crossfade(AudioBufferView from, AudioBufferView to, FadeCurve curve, int length, int offset)
+{
+	assert(m_data != nullptr);
+	markDirty(0, std::min({m_size, from.countFrames(), to.countFrames()}));
+	rawView().crossfade(from, to, curve, length, offset);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void AudioBuffer::flushDenormals()
+{
+	detach();
+	invalidatePeaks(0, m_size);
+	rawView().flushDenormals();
+}
+
+/* -------------------------------------------------------------------------- */
+
+void AudioBuffer::setFromPcm(const void* src, PcmFormat format, int frames, int channels)
+{
+	assert(m_data != nullptr);
+	markDirty(0, std::min(m_size, frames));
+	rawView().setFromPcm(src, format, frames, channels);
+}
+
+void AudioBuffer::writeToPcm(void* dest, PcmFormat format, Dither* dither) const
+{
+	assert(m_data != nullptr);
+	rawView().writeToPcm(dest, format, dither);
+}
 
 /* -------------------------------------------------------------------------- */
 
 void AudioBuffer::move(AudioBuffer&& o)
 {
-	assert(o.countChannels() <= NUM_CHANS);
+	assert(o.countChannels() <= MAX_CHANS);
 
-	m_data     = std::move(o.m_data);
-	m_size     = o.m_size;
-	m_channels = o.m_channels;
-	m_viewing  = o.m_viewing;
+	free();
 
-	o.m_data     = nullptr;
-	o.m_size     = 0;
-	o.m_channels = 0;
-	o.m_viewing  = false;
+	m_data       = std::move(o.m_data);
+	m_size       = o.m_size;
+	m_channels   = o.m_channels;
+	m_capacity   = o.m_capacity;
+	m_viewing    = o.m_viewing;
+	m_dirtyBegin = o.m_dirtyBegin;
+	m_dirtyEnd   = o.m_dirtyEnd;
+	m_shared     = o.m_shared;
+	m_peaks      = std::move(o.m_peaks);
+
+	o.m_data       = nullptr;
+	o.m_size       = 0;
+	o.m_channels   = 0;
+	o.m_capacity   = 0;
+	o.m_viewing    = false;
+	o.m_dirtyBegin = 0;
+	o.m_dirtyEnd   = 0;
+	o.m_shared     = nullptr;
 }
 
 /* -------------------------------------------------------------------------- */
 
 void AudioBuffer::copy(const AudioBuffer& o)
 {
-	m_data     = std::make_unique<float[]>(o.m_size * o.m_channels);
-	m_size     = o.m_size;
-	m_channels = o.m_channels;
-	m_viewing  = o.m_viewing;
+	/* Whatever 'o' is, the copy owns its memory: it's never a viewing buffer.
+	The current memory block is reused if it's big enough. */
+
+	m_peaks = o.m_peaks != nullptr ? std::make_unique<PeakPyramid>(*o.m_peaks) : nullptr;
+
+	if (o.m_data == nullptr)
+	{
+		free();
+		return;
+	}
+
+	/* Shared storage is referenced, not copied. The reference to the new block
+	is taken before letting go of the current one, in case they are the same. */
+
+	if (o.m_shared != nullptr)
+	{
+		o.m_shared->refs.fetch_add(1, std::memory_order_relaxed);
+		releaseData();
+
+		m_data.reset(o.m_data.get());
+		m_shared     = o.m_shared;
+		m_size       = o.m_size;
+		m_channels   = o.m_channels;
+		m_capacity   = o.m_capacity;
+		m_viewing    = false;
+		m_dirtyBegin = o.m_dirtyBegin;
+		m_dirtyEnd   = o.m_dirtyEnd;
+		return;
+	}
+
+	if (m_viewing || m_shared != nullptr || o.countSamples() > m_capacity)
+	{
+		MCL_INSTRUMENT_SCOPE(instrumentation::Operation::ALLOC, o.m_size, memory::padSamples(o.countSamples()) * sizeof(float));
+
+		free();
+		m_data.reset(memory::allocAligned(o.countSamples()));
+		m_capacity = static_cast<int>(memory::padSamples(o.countSamples()));
+	}
+
+	m_size       = o.m_size;
+	m_channels   = o.m_channels;
+	m_dirtyBegin = o.m_dirtyBegin;
+	m_dirtyEnd   = o.m_dirtyEnd;
+
+	MCL_INSTRUMENT_SCOPE(instrumentation::Operation::COPY, o.m_size, o.countSamples() * sizeof(float));
 
 	std::copy(o.m_data.get(), o.m_data.get() + (o.m_size * o.m_channels), m_data.get());
 }
 
 /* -------------------------------------------------------------------------- */
 
+void AudioBuffer::reallocate(int capacity)
+{
+	const int samplesToKeep = std::min(countSamples(), capacity);
+
+	std::unique_ptr<float[], memory::AlignedDeleter> data;
+	{
+		MCL_INSTRUMENT_SCOPE(instrumentation::Operation::ALLOC, m_size, memory::padSamples(capacity) * sizeof(float));
+		data.reset(memory::allocAligned(capacity));
+	}
+	if (m_data != nullptr)
+	{
+		MCL_INSTRUMENT_SCOPE(instrumentation::Operation::COPY, m_size, samplesToKeep * sizeof(float));
+		std::copy(m_data.get(), m_data.get() + samplesToKeep, data.get());
+	}
+
+	releaseData();
+
+	m_data     = std::move(data);
+	m_capacity = static_cast<int>(memory::padSamples(capacity));
+	m_viewing  = false;
+}
+
+/* -------------------------------------------------------------------------- */
+
 void AudioBuffer::forEachFrame(std::function<void(float*, int)> f)
 {
-	for (int i = 0; i < countFrames(); i++)
-		f((*this)[i], i);
+	markDirty(0, m_size);
+
+	float* data = m_data.get();
+	for (int i = 0; i < m_size; i++, data += m_channels)
+		f(data, i);
 }
 
 /* -------------------------------------------------------------------------- */
 
 void AudioBuffer::forEachChannel(int frame, std::function<void(float&, int)> f)
 {
-	assert(frame < m_size);
+	assert(frame >= 0 && frame < m_size);
 
-	for (int i = 0; i < countChannels(); i++)
-		f((*this)[frame][i], i);
+	markDirty(frame, frame + 1);
+
+	float* data = m_data.get() + (frame * m_channels);
+	for (int i = 0; i < m_channels; i++)
+		f(data[i], i);
 }
 
 /* -------------------------------------------------------------------------- */
 
 void AudioBuffer::forEachSample(std::function<void(float&, int)> f)
 {
-	for (int i = 0; i < countSamples(); i++)
-		f(m_data.get()[i], i);
+	markDirty(0, m_size);
+
+	float*    data    = m_data.get();
+	const int samples = countSamples();
+	for (int i = 0; i < samples; i++)
+		f(data[i], i);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void AudioBuffer::markDirty(int a, int b)
+{
+	if (a >= b)
+		return;
+
+	detach();
+	invalidatePeaks(a, b);
+
+	if (m_dirtyBegin >= m_dirtyEnd)
+	{
+		m_dirtyBegin = a;
+		m_dirtyEnd   = b;
+		return;
+	}
+	m_dirtyBegin = std::min(m_dirtyBegin, a);
+	m_dirtyEnd   = std::max(m_dirtyEnd, b);
+}
+
+void AudioBuffer::markClean(int a, int b)
+{
+	invalidatePeaks(a, b);
+
+	if (m_viewing || a >= b)
+		return;
+
+	/* Shrink the range from either end. */
+
+	if (a <= m_dirtyBegin)
+		m_dirtyBegin = std::max(m_dirtyBegin, b);
+	if (b >= m_dirtyEnd)
+		m_dirtyEnd = std::min(m_dirtyEnd, a);
+	if (m_dirtyBegin >= m_dirtyEnd)
+		m_dirtyBegin = m_dirtyEnd = 0;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void AudioBuffer::invalidatePeaks(int a, int b)
+{
+	if (m_peaks != nullptr)
+		m_peaks->invalidate(a, b);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void AudioBuffer::makeShared()
+{
+	assert(m_data != nullptr);
+	assert(!m_viewing);
+
+	if (m_shared == nullptr)
+		m_shared = new SharedStorage{m_data.get(), 1, nullptr};
+}
+
+bool AudioBuffer::isShared() const { return m_shared != nullptr; }
+
+/* -------------------------------------------------------------------------- */
+
+int AudioBuffer::reclaimShared()
+{
+	SharedStorage* s     = SharedStorage::retired.exchange(nullptr, std::memory_order_acquire);
+	int            count = 0;
+	while (s != nullptr)
+	{
+		SharedStorage* next = s->next;
+		memory::freeAligned(s->data);
+		delete s;
+		s = next;
+		count++;
+	}
+	return count;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void AudioBuffer::detach()
+{
+	if (m_shared == nullptr)
+		return;
+
+	/* The last holder can just take the memory over. Nobody else can grab a 
+	new reference in the meantime, as that requires a holder. */
+
+	if (m_shared->refs.load(std::memory_order_acquire) == 1)
+	{
+		m_shared->data = nullptr;
+		SharedStorage::retire(m_shared);
+		m_shared = nullptr;
+		return;
+	}
+
+	reallocate(countSamples());
+}
+
+/* -------------------------------------------------------------------------- */
+
+void AudioBuffer::releaseData()
+{
+	if (m_viewing)
+	{
+		m_data.release();
+	}
+	else if (m_shared != nullptr)
+	{
+		m_data.release();
+		SharedStorage::release(m_shared);
+		m_shared = nullptr;
+	}
+	else
+	{
+		m_data.reset();
+	}
 }
 
 /* -------------------------------------------------------------------------- */
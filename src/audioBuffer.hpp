@@ -27,23 +27,54 @@
 #ifndef MONOCASUAL_AUDIO_BUFFER_H
 #define MONOCASUAL_AUDIO_BUFFER_H
 
+#include "audioBufferView.hpp"
+#include "memory.hpp"
+#include "peakPyramid.hpp"
+#include <algorithm>
 #include <array>
+#include <cassert>
+#include <concepts>
 #include <functional>
 #include <memory>
+#include <span>
 
 namespace mcl
 {
 /* AudioBuffer
-A class that holds a buffer filled with audio data. NOTE: currently it only
-supports 2 channels (stereo). Give it a mono stream and it will convert it to
-stereo. Give it a multichannel stream and it will throw an assertion. */
+A class that holds a buffer filled with audio data. It supports up to 
+MAX_CHANS interleaved channels, with specialized code paths for mono and 
+stereo. Give it a mono stream and it will spread it over all channels.
+
+The buffer keeps track of the range of frames that may hold non-zero samples
+(the 'dirty' range), so that clearing a silent buffer or mixing from it costs
+next to nothing. Writes through pointers and views handed out by non-const
+methods conservatively mark the whole buffer as dirty, but only when they are
+handed out: don't keep writing through them after clear() or set(). Viewing
+buffers are always considered dirty, as their data is owned by someone else.
+
+Samples can also be shared among copies of the same buffer, see makeShared(). 
+The same rule applies: pointers and views must be taken after the last copy 
+has been made, or they might write onto samples other buffers are using. */
 
 class AudioBuffer
 {
 public:
-	static constexpr int NUM_CHANS = 2;
+	static constexpr int MAX_CHANS = AudioBufferView::MAX_CHANS;
+
+	using Pan = AudioBufferView::Pan;
+
+	static constexpr Pan UNITY_PAN = AudioBufferView::UNITY_PAN;
 
-	using Pan = std::array<float, NUM_CHANS>;
+	/* Init
+	How to initialize freshly allocated memory: fill it with 0.0f's or leave it
+	as it is. UNINITIALIZED is meant for callers that are going to overwrite
+	every sample straight away. */
+
+	enum class Init
+	{
+		ZERO,
+		UNINITIALIZED
+	};
 
 	/* AudioBuffer (1)
 	Creates an empty (and invalid) audio buffer. */
@@ -51,13 +82,15 @@ public:
 	AudioBuffer();
 
 	/* AudioBuffer (2)
-	Creates an audio buffer and allocates memory for size * channels frames. */
+	Creates an audio buffer and allocates memory for size * channels frames. 
+	See alloc() below. */
 
-	AudioBuffer(int size, int channels);
+	AudioBuffer(int size, int channels, Init init = Init::ZERO);
 
 	/* AudioBuffer (3)
 	Creates an audio buffer out of a raw pointer. AudioBuffer created this way
-	is instructed not to free the owned data on destruction. */
+	is instructed not to free the owned data on destruction. Prefer 
+	AudioBufferView for non-owning access to external data. */
 
 	AudioBuffer(float* data, int size, int channels);
 
@@ -95,52 +128,267 @@ public:
 				... buffer[k][i] ...
 
 	Also note that buffer[0] will give you a pointer to the whole internal data
-	array. */
+	array. The non-const version marks the whole buffer as dirty and detaches it
+	from shared storage; the const one is read-only, as the data might be shared
+	with other buffers.
+
+	The non-const version is expensive: every call validates 'offset', detaches,
+	invalidates the peak pyramid and widens the dirty range to the whole buffer,
+	so even a single written frame makes the buffer non-silent. Loops writing 
+	many frames should take a view once, view(start, count) to dirty only the 
+	frames written, then walk it with AudioBufferView::getFrameUnchecked(). */
+
+	float*       operator[](int offset);
+	const float* operator[](int offset) const;
+
+	/* getData
+	Returns a pointer to the first sample, nullptr if the buffer is not 
+	allocated. The non-const version marks the whole buffer as dirty, like 
+	view(). */
+
+	float*       getData();
+	const float* getData() const;
+
+	/* getStride
+	Distance between two consecutive frames, in samples. Always equal to 
+	countChannels(), since buffers are interleaved and packed. */
+
+	int getStride() const;
+
+	/* getFrameUnchecked
+	Read-only version of operator [], without any check. 'offset' MUST lie 
+	within [0, countFrames()). To write, get a view() first and use 
+	AudioBufferView::getFrameUnchecked(). */
 
-	float* operator[](int offset) const;
+	const float* getFrameUnchecked(int offset) const;
+
+	/* view, operator AudioBufferView
+	Returns a non-owning view over the whole buffer. Views must not outlive the
+	buffer, nor survive a call to alloc() or free(). The non-const versions 
+	mark the whole buffer as dirty: use a const reference to the buffer to get
+	a view meant for reading only. */
+
+	AudioBufferView view();
+	AudioBufferView view() const;
+
+	/* view (range)
+	Returns a writable view over 'count' frames starting at frame 'start', 
+	marking only those as dirty. If 'count' is -1 the view extends to the end 
+	of the buffer. Meant for writing a block of frames at once. */
+
+	AudioBufferView view(int start, int count = -1);
+
+	operator AudioBufferView();
+	operator AudioBufferView() const;
 
 	int  countFrames() const;
 	int  countSamples() const;
 	int  countChannels() const;
 	bool isAllocd() const;
 
+	/* isSilent
+	Returns whether frames in range [a, b) are known to be 0.0f. It only looks
+	at the dirty range, never at the actual samples: a buffer full of zeros 
+	written by hand is not reported as silent. If 'b' is -1 the range ends at
+	the last frame. */
+
+	bool isSilent(int a = 0, int b = -1) const;
+
+	/* getCapacity
+	Returns how many samples the buffer can hold without allocating new 
+	memory. Viewing buffers have no capacity of their own. */
+
+	int getCapacity() const;
+
 	/* getPeak
-	Returns the highest value from the specified channel. */
+	Returns the highest absolute value from the specified channel. Silent 
+	ranges are not scanned. If the buffer has a peak pyramid, long ranges are
+	not scanned either: see setPeakPyramid(). */
 
 	float getPeak(int channel, int a = 0, int b = -1) const;
 
-	void alloc(int size, int channels);
+	/* getPeakRange
+	Returns the lowest and highest value from the specified channel in frames
+	[a, b), e.g. for drawing a waveform column. Same scanning rules as 
+	getPeak(). */
+
+	PeakRange getPeakRange(int channel, int a = 0, int b = -1) const;
+
+	/* setPeakPyramid, hasPeakPyramid
+	Attach a PeakPyramid to the buffer, or remove it. Writes made through the 
+	buffer methods invalidate the frames they touch, and the next getPeak() or
+	getPeakRange() rebuilds them: only writes through pointers or views taken 
+	before that call go unnoticed. Copies and moves take the pyramid along. Off
+	by default; getPeak() and getPeakRange() are not thread-safe with it on. */
+
+	void setPeakPyramid(bool enabled);
+	bool hasPeakPyramid() const;
+
+	/* analyze
+	Computes the statistics of every channel in one pass. See 
+	AudioBufferView::analyze(). Silent buffers are not scanned. */
+
+	void analyze(std::span<ChannelStats> stats, float clipThreshold = 1.0f) const;
+
+	/* alloc
+	Allocates memory for size * channels frames, discarding any previous data.
+	The current memory block is reused if its capacity is enough. Memory is 
+	aligned to memory::ALIGNMENT and padded to a whole number of cache lines. */
+
+	void alloc(int size, int channels, Init init = Init::ZERO);
+
+	/* free
+	Releases the memory and resets the buffer to an empty state. A peak pyramid
+	stays attached, empty. */
+
 	void free();
 
+	/* reserve
+	Makes sure the buffer can hold 'size' frames of 'channels' channels without
+	allocating new memory. Current content and size are kept. */
+
+	void reserve(int size, int channels);
+
+	/* resize
+	Changes the size to 'size' frames, keeping the current channels and content.
+	Memory is reallocated only if the capacity is not enough, new frames are
+	initialized according to 'init'. The buffer MUST be allocated. */
+
+	void resize(int size, Init init = Init::ZERO);
+
+	/* shrinkToFit
+	Releases unused capacity, reallocating to fit the current size. Shared 
+	buffers are left untouched. */
+
+	void shrinkToFit();
+
+	/* makeShared
+	Turns the memory of this buffer into immutable, reference-counted storage:
+	from now on copies share the same samples instead of duplicating them. The
+	first write to a buffer whose storage is shared (with sum(), set(), clear()
+	and so on, or by asking for a non-const pointer or view) makes a private 
+	copy of it (copy-on-write), which allocates memory unless the buffer is the
+	last holder. The buffer MUST be allocated and not viewing. */
+
+	void makeShared();
+
+	/* isShared
+	Returns whether the buffer holds shared storage, see makeShared(). */
+
+	bool isShared() const;
+
+	/* reclaimShared
+	Shared storage is never freed by the last buffer releasing it. It's queued
+	instead, so that shared buffers can be destroyed on the audio thread without
+	touching the memory allocator. Call this function periodically from a non
+	realtime thread to free the queue. Returns the number of blocks freed. */
+
+	static int reclaimShared();
+
 	/* sum, set (1)
 	Merges (sum) or copies (set) 'framesToCopy' frames of buffer 'b' onto this 
 	one. If 'framesToCopy' is -1 the whole buffer will be copied. If 'b' has 
-	less channels than this one, they will be spread over the current ones. 
-	Buffer 'b' MUST NOT contain more channels than this one. */
+	a different amount of channels, it is converted as described in 
+	AudioBufferView::sum(). Only the dirty range of 'b' is processed: summing
+	a silent buffer is a no-op, setting from it is a clear(). */
 
 	void sum(const AudioBuffer& b, int framesToCopy = -1, int srcOffset = 0,
-	    int destOffset = 0, float gain = 1.0f, Pan pan = {1.0f, 1.0f});
+	    int destOffset = 0, float gain = 1.0f, Pan pan = UNITY_PAN);
 	void set(const AudioBuffer& b, int framesToCopy = -1, int srcOffset = 0,
-	    int destOffset = 0, float gain = 1.0f, Pan pan = {1.0f, 1.0f});
+	    int destOffset = 0, float gain = 1.0f, Pan pan = UNITY_PAN);
 
 	/* sum, set (2)
 	Same as sum, set (1) without boundaries or offsets: it just copies as much
 	as possibile. */
 
-	void sum(const AudioBuffer& b, float gain = 1.0f, Pan pan = {1.0f, 1.0f});
-	void set(const AudioBuffer& b, float gain = 1.0f, Pan pan = {1.0f, 1.0f});
+	void sum(const AudioBuffer& b, float gain = 1.0f, Pan pan = UNITY_PAN);
+	void set(const AudioBuffer& b, float gain = 1.0f, Pan pan = UNITY_PAN);
+
+	/* sum, set (3)
+	Same as sum, set (2) with a view as source. Use AudioBufferView::slice() to
+	pick a sub-range of the source, and view().slice() to pick one of the 
+	destination. */
+
+	void sum(AudioBufferView b, float gain = 1.0f, Pan pan = UNITY_PAN);
+	void set(AudioBufferView b, float gain = 1.0f, Pan pan = UNITY_PAN);
+
+	/* sum (4)
+	Merges multiple sources in a single pass. See 
+	AudioBufferView::sum(std::span<const MixSource>). */
+
+	void sum(std::span<const MixSource> sources);
+
+	/* sum, set (5)
+	Same as sum, set (3) with gain and pan moving linearly across the processed
+	frames. See AudioBufferView::sum(AudioBufferView, Ramp<float>, Ramp<Pan>). */
+
+	void sum(AudioBufferView b, Ramp<float> gain, Ramp<Pan> pan = {UNITY_PAN, UNITY_PAN});
+	void set(AudioBufferView b, Ramp<float> gain, Ramp<Pan> pan = {UNITY_PAN, UNITY_PAN});
+
+	/* sum, set (6)
+	Same as sum, set (3) with a custom channel conversion. See 
+	AudioBufferView::sum(AudioBufferView, const ChannelMatrix&, float, Pan). */
+
+	void sum(AudioBufferView b, const ChannelMatrix& matrix, float gain = 1.0f, Pan pan = UNITY_PAN);
+	void set(AudioBufferView b, const ChannelMatrix& matrix, float gain = 1.0f, Pan pan = UNITY_PAN);
+
+	/* sum, set (7)
+	Same as sum, set (3) reading 'b' at a fractional rate, starting from 
+	position 'pos' and advancing by 'step' frames per frame. Returns the 
+	position to start the next block from. See AudioBufferView::sum(
+	AudioBufferView, double, double, Interpolation, float, Pan). */
+
+	double sum(AudioBufferView b, double pos, double step, Interpolation interp = Interpolation::LINEAR,
+	    float gain = 1.0f, Pan pan = UNITY_PAN);
+	double set(AudioBufferView b, double pos, double step, Interpolation interp = Interpolation::LINEAR,
+	    float gain = 1.0f, Pan pan = UNITY_PAN);
+
+	/* sum, set (8)
+	Same as sum, set (3) with compact 16-bit samples as source. See 
+	CompactAudioBuffer. */
+
+	void sum(CompactAudioBufferView b, float gain = 1.0f, Pan pan = UNITY_PAN);
+	void set(CompactAudioBufferView b, float gain = 1.0f, Pan pan = UNITY_PAN);
 
 	/* clear
 	Clears the internal data by setting all bytes to 0.0f. Optional parameters
-	'a' and 'b' set the range. */
+	'a' and 'b' set the range. Frames already known to be silent are skipped,
+	so clearing a silent buffer is cheap. */
 
 	void clear(int a = 0, int b = -1);
 
 	/* applyGain
-	Applies gain 'g' to buffer. Optional parameters	'a' and 'b' set the range.*/
+	Applies gain 'g' to buffer. Optional parameters	'a' and 'b' set the range, 
+	in samples. A gain of 0.0f clears the range. */
 
 	void applyGain(float g, int a = 0, int b = -1);
 
+	/* setFromPcm, writeToPcm
+	Conversions from and to PCM data. See AudioBufferView::setFromPcm() and 
+	AudioBufferView::writeToPcm(). */
+
+	void setFromPcm(const void* src, PcmFormat format, int frames, int channels);
+	void writeToPcm(void* dest, PcmFormat format, Dither* dither = nullptr) const;
+
+	/* applyGain (ramp)
+	Applies a gain moving linearly from gain.start to gain.end across the whole
+	buffer. Use view().slice() to pick a range. */
+
+	void applyGain(Ramp<float> gain);
+
+	/* fadeIn, fadeOut, crossfade
+	Fades across the whole buffer. See AudioBufferView::fadeIn(), 
+	AudioBufferView::fadeOut() and AudioBufferView::crossfade(). */
+
+	void fadeIn(FadeCurve curve, int length = -1, int offset = 0);
+	void fadeOut(FadeCurve curve, int length = -1, int offset = 0);
+	void crossfade(AudioBufferView from, AudioBufferView to, FadeCurve curve, int length = -1, int offset = 0);
+
+	/* flushDenormals
+	Replaces subnormal samples with zeros. See AudioBufferView::flushDenormals(). */
+
+	void flushDenormals();
+
 	/* forEachFrame
 	Applies a function to each frame in the audio buffer. */
 
@@ -156,6 +404,33 @@ public:
 
 	void forEachSample(std::function<void(float& /*value*/, int /*numSample*/)>);
 
+	/* forEachFrame, forEachChannel, forEachSample (templated)
+	Same as above, but accept any callable. The callable is invoked directly, 
+	so it can be inlined (and vectorized) by the compiler. Prefer these in DSP
+	loops: the std::function versions are kept for binary compatibility. */
+
+	template <typename F>
+	    requires std::invocable<F&, float*, int>
+	void forEachFrame(F&& f);
+
+	template <typename F>
+	    requires std::invocable<F&, float&, int>
+	void forEachChannel(int frame, F&& f);
+
+	template <typename F>
+	    requires std::invocable<F&, float&, int>
+	void forEachSample(F&& f);
+
+	/* forEachBlock
+	Splits the buffer into blocks of at most 'blockSize' frames and hands each 
+	one to the callable as a contiguous span of interleaved samples, along with
+	the index of its first frame. If 'blockSize' is -1 the whole buffer is 
+	passed in one go. */
+
+	template <typename F>
+	    requires std::invocable<F&, std::span<float>, int>
+	void forEachBlock(int blockSize, F&& f);
+
 private:
 	enum class Operation
 	{
@@ -166,18 +441,133 @@ private:
 	template <Operation O = Operation::SET>
 	void copyData(const AudioBuffer& b, int framesToCopy = -1,
 	    int srcOffset = 0, int destOffset = 0, float gain = 1.0f,
-	    Pan pan = {1.0f, 1.0f});
+	    Pan pan = UNITY_PAN);
 
 	void move(AudioBuffer&& o);
 	void copy(const AudioBuffer& o);
-	void sum(int f, int channel, float val);
-	void set(int f, int channel, float val);
 
-	std::unique_ptr<float[]> m_data;
-	int                      m_size;
-	int                      m_channels;
-	bool                     m_viewing;
+	/* reallocate
+	Moves content into a new memory block of 'capacity' samples. */
+
+	void reallocate(int capacity);
+
+	/* rawView
+	Same as the const view(), for internal use in non-const methods: it doesn't
+	touch the dirty range. */
+
+	AudioBufferView rawView() const;
+
+	/* markDirty, markClean
+	Update the dirty range before frames in range [a, b) are written to (dirty)
+	or after they have been set to 0.0f (clean). The range is a single span of
+	frames, so cleaning a hole in the middle of it has no effect. markDirty() 
+	also calls detach(). */
+
+	void markDirty(int a, int b);
+	void markClean(int a, int b);
+
+	/* invalidatePeaks
+	Tells the peak pyramid, if any, that frames in range [a, b) have changed.
+	Called by markDirty() and markClean(), and by in-place operations that 
+	don't go through them. */
+
+	void invalidatePeaks(int a, int b);
+
+	/* SharedStorage
+	Reference-counted memory block of shared buffers (see audioBuffer.cpp). */
+
+	struct SharedStorage;
+
+	/* detach
+	Gives the buffer memory of its own if its storage is shared: call it before
+	any write. */
+
+	void detach();
+
+	/* releaseData
+	Lets go of the current memory, according to who owns it. */
+
+	void releaseData();
+
+	std::unique_ptr<float[], memory::AlignedDeleter> m_data;
+	int                                              m_size;
+	int                                              m_channels;
+	int                                              m_capacity;
+	bool                                             m_viewing;
+	int                                              m_dirtyBegin;
+	int                                              m_dirtyEnd;
+	SharedStorage*                                   m_shared;
+	std::unique_ptr<PeakPyramid>                     m_peaks;
 };
+
+/* -------------------------------------------------------------------------- */
+
+inline const float* AudioBuffer::getFrameUnchecked(int offset) const
+{
+	return m_data.get() + (offset * m_channels);
+}
+
+/* -------------------------------------------------------------------------- */
+
+template <typename F>
+    requires std::invocable<F&, float*, int>
+void AudioBuffer::forEachFrame(F&& f)
+{
+	markDirty(0, m_size);
+
+	float* data = m_data.get();
+	for (int i = 0; i < m_size; i++, data += m_channels)
+		f(data, i);
+}
+
+/* -------------------------------------------------------------------------- */
+
+template <typename F>
+    requires std::invocable<F&, float&, int>
+void AudioBuffer::forEachChannel(int frame, F&& f)
+{
+	assert(frame >= 0 && frame < m_size);
+
+	markDirty(frame, frame + 1);
+
+	float* data = m_data.get() + (frame * m_channels);
+	for (int i = 0; i < m_channels; i++)
+		f(data[i], i);
+}
+
+/* -------------------------------------------------------------------------- */
+
+template <typename F>
+    requires std::invocable<F&, float&, int>
+void AudioBuffer::forEachSample(F&& f)
+{
+	markDirty(0, m_size);
+
+	float*    data    = m_data.get();
+	const int samples = countSamples();
+	for (int i = 0; i < samples; i++)
+		f(data[i], i);
+}
+
+/* -------------------------------------------------------------------------- */
+
+template <typename F>
+    requires std::invocable<F&, std::span<float>, int>
+void AudioBuffer::forEachBlock(int blockSize, F&& f)
+{
+	assert(blockSize == -1 || blockSize > 0);
+
+	if (blockSize == -1)
+		blockSize = std::max(m_size, 1);
+
+	markDirty(0, m_size);
+
+	for (int i = 0; i < m_size; i += blockSize)
+	{
+		const int frames = std::min(blockSize, m_size - i);
+		f(std::span<float>(m_data.get() + (i * m_channels), frames * m_channels), i);
+	}
+}
 } // namespace mcl
 
 #endif
\ No newline at end of file
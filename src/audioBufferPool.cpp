@@ -0,0 +1,201 @@
+/* -----------------------------------------------------------------------------
+ *
+ * AudioBuffer
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2021 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of AudioBuffer.
+ *
+ * AudioBuffer is free software: you can redistribute it and/or modify it under 
+ * the terms of the GNU General Public License as published by the Free Software 
+ * Foundation, either version 3 of the License, or (at your option) any later 
+ * version.
+ *
+ * AudioBuffer is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS 
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more 
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with 
+ * AudioBuffer. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+#include "audioBufferPool.hpp"
+#include <algorithm>
+#include <cassert>
+
+namespace mcl
+{
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free);
+
+/* -------------------------------------------------------------------------- */
+
+AudioBufferPool::Lease::Lease()
+: m_pool(nullptr)
+, m_slot(-1)
+{
+}
+
+/* -------------------------------------------------------------------------- */
+
+AudioBufferPool::Lease::Lease(AudioBufferPool& pool, int slot)
+: m_pool(&pool)
+, m_slot(slot)
+{
+}
+
+/* -------------------------------------------------------------------------- */
+
+AudioBufferPool::Lease::Lease(Lease&& o) noexcept
+: m_pool(o.m_pool)
+, m_slot(o.m_slot)
+{
+	o.m_pool = nullptr;
+	o.m_slot = -1;
+}
+
+/* -------------------------------------------------------------------------- */
+
+AudioBufferPool::Lease::~Lease()
+{
+	release();
+}
+
+/* -------------------------------------------------------------------------- */
+
+AudioBufferPool::Lease& AudioBufferPool::Lease::operator=(Lease&& o) noexcept
+{
+	if (this == &o)
+		return *this;
+	release();
+	m_pool   = o.m_pool;
+	m_slot   = o.m_slot;
+	o.m_pool = nullptr;
+	o.m_slot = -1;
+	return *this;
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool AudioBufferPool::Lease::isValid() const { return m_pool != nullptr; }
+
+/* -------------------------------------------------------------------------- */
+
+AudioBufferView AudioBufferPool::Lease::view() const
+{
+	if (!isValid())
+		return {};
+	return AudioBufferView(m_pool->getSlot(m_slot), m_pool->m_size, m_pool->m_channels);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void AudioBufferPool::Lease::release()
+{
+	if (!isValid())
+		return;
+	m_pool->giveBack(m_slot);
+	m_pool = nullptr;
+	m_slot = -1;
+}
+
+/* -------------------------------------------------------------------------- */
+
+AudioBufferPool::AudioBufferPool(int numBuffers, int size, int channels)
+: m_numBuffers(numBuffers)
+, m_size(size)
+, m_channels(channels)
+, m_slotSamples(static_cast<int>(memory::padSamples(size * channels)))
+{
+	assert(numBuffers > 0);
+	assert(size > 0);
+	assert(channels > 0 && channels <= AudioBuffer::MAX_CHANS);
+
+	/* Each slot starts on its own cache line, thanks to the padding. */
+
+	m_slab.reset(memory::allocAligned(static_cast<std::size_t>(m_slotSamples) * numBuffers));
+	m_next = std::make_unique<std::atomic<std::uint32_t>[]>(numBuffers);
+
+	for (int i = 0; i < numBuffers; i++)
+		m_next[i].store(i + 1 < numBuffers ? i + 1 : NO_SLOT, std::memory_order_relaxed);
+	m_head.store(pack(0, 0));
+	m_available.store(numBuffers);
+}
+
+/* -------------------------------------------------------------------------- */
+
+AudioBufferPool::~AudioBufferPool()
+{
+	assert(countAvailable() == m_numBuffers); // Some leases outlived the pool
+}
+
+/* -------------------------------------------------------------------------- */
+
+int AudioBufferPool::countBuffers() const { return m_numBuffers; }
+int AudioBufferPool::countFrames() const { return m_size; }
+int AudioBufferPool::countChannels() const { return m_channels; }
+int AudioBufferPool::countAvailable() const { return m_available.load(std::memory_order_relaxed); }
+
+/* -------------------------------------------------------------------------- */
+
+AudioBufferPool::Lease AudioBufferPool::acquire(AudioBuffer::Init init)
+{
+	std::uint64_t head = m_head.load(std::memory_order_acquire);
+	std::uint32_t slot;
+
+	do
+	{
+		slot = static_cast<std::uint32_t>(head);
+		if (slot == NO_SLOT)
+			return {};
+		const std::uint32_t next = m_next[slot].load(std::memory_order_relaxed);
+		const std::uint32_t tag  = static_cast<std::uint32_t>(head >> 32) + 1;
+		if (m_head.compare_exchange_weak(head, pack(next, tag), std::memory_order_acquire, std::memory_order_acquire))
+			break;
+	} while (true);
+
+	m_available.fetch_sub(1, std::memory_order_relaxed);
+
+	Lease lease(*this, static_cast<int>(slot));
+	if (init == AudioBuffer::Init::ZERO)
+		lease.view().clear();
+	return lease;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void AudioBufferPool::giveBack(int slot)
+{
+	assert(slot >= 0 && slot < m_numBuffers);
+
+	std::uint64_t head = m_head.load(std::memory_order_relaxed);
+	std::uint64_t newHead;
+
+	do
+	{
+		m_next[slot].store(static_cast<std::uint32_t>(head), std::memory_order_relaxed);
+		const std::uint32_t tag = static_cast<std::uint32_t>(head >> 32) + 1;
+		newHead                 = pack(static_cast<std::uint32_t>(slot), tag);
+	} while (!m_head.compare_exchange_weak(head, newHead, std::memory_order_release, std::memory_order_relaxed));
+
+	m_available.fetch_add(1, std::memory_order_relaxed);
+}
+
+/* -------------------------------------------------------------------------- */
+
+std::uint64_t AudioBufferPool::pack(std::uint32_t slot, std::uint32_t tag)
+{
+	return (static_cast<std::uint64_t>(tag) << 32) | slot;
+}
+
+/* -------------------------------------------------------------------------- */
+
+float* AudioBufferPool::getSlot(int slot) const
+{
+	return m_slab.get() + (static_cast<std::size_t>(slot) * m_slotSamples);
+}
+} // namespace mcl
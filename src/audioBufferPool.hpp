@@ -0,0 +1,137 @@
+/* -----------------------------------------------------------------------------
+ *
+ * AudioBuffer
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2021 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of AudioBuffer.
+ *
+ * AudioBuffer is free software: you can redistribute it and/or modify it under 
+ * the terms of the GNU General Public License as published by the Free Software 
+ * Foundation, either version 3 of the License, or (at your option) any later 
+ * version.
+ *
+ * AudioBuffer is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS 
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more 
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with 
+ * AudioBuffer. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+#ifndef MONOCASUAL_AUDIO_BUFFER_POOL_H
+#define MONOCASUAL_AUDIO_BUFFER_POOL_H
+
+#include "audioBuffer.hpp"
+#include "audioBufferView.hpp"
+#include "memory.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace mcl
+{
+/* AudioBufferPool
+A fixed set of equally sized buffers, carved out of a single aligned memory
+slab allocated on construction. Buffers are handed out as RAII leases: the
+buffer goes back to the pool when the lease is destroyed. Acquiring and 
+releasing are lock-free and never allocate, so they can be performed from the
+audio thread. The pool MUST outlive all of its leases. */
+
+class AudioBufferPool
+{
+public:
+	/* Lease
+	Move-only handle to a buffer borrowed from the pool. An invalid lease (i.e.
+	default-constructed, moved-from or returned by an exhausted pool) holds no 
+	buffer. */
+
+	class Lease
+	{
+	public:
+		Lease();
+		Lease(const Lease&) = delete;
+		Lease(Lease&& o) noexcept;
+		~Lease();
+
+		Lease& operator=(const Lease&) = delete;
+		Lease& operator=(Lease&& o) noexcept;
+
+		bool isValid() const;
+
+		/* view
+		Returns a view over the leased buffer. It must not outlive the lease. */
+
+		AudioBufferView view() const;
+
+		/* release
+		Gives the buffer back to the pool before the lease is destroyed. */
+
+		void release();
+
+	private:
+		friend class AudioBufferPool;
+
+		Lease(AudioBufferPool& pool, int slot);
+
+		AudioBufferPool* m_pool;
+		int              m_slot;
+	};
+
+	/* AudioBufferPool
+	Preallocates 'numBuffers' buffers of 'size' frames and 'channels' channels
+	each. */
+
+	AudioBufferPool(int numBuffers, int size, int channels);
+	AudioBufferPool(const AudioBufferPool&) = delete;
+	~AudioBufferPool();
+
+	AudioBufferPool& operator=(const AudioBufferPool&) = delete;
+
+	int countBuffers() const;
+	int countFrames() const;
+	int countChannels() const;
+
+	/* countAvailable
+	Returns how many buffers can be acquired right now. The value might be
+	outdated as soon as it's returned, if other threads are using the pool. */
+
+	int countAvailable() const;
+
+	/* acquire
+	Borrows a buffer from the pool. Returns an invalid lease if the pool is 
+	exhausted. Memory is initialized according to 'init'. */
+
+	Lease acquire(AudioBuffer::Init init = AudioBuffer::Init::ZERO);
+
+private:
+	/* Free list
+	Lock-free stack of available slots. The head packs a slot index (lower 32
+	bits) and a tag (upper 32 bits), bumped on every change to prevent the ABA
+	problem. */
+
+	static constexpr std::uint32_t NO_SLOT = 0xFFFFFFFF;
+
+	static std::uint64_t pack(std::uint32_t slot, std::uint32_t tag);
+
+	void giveBack(int slot);
+
+	float* getSlot(int slot) const;
+
+	std::unique_ptr<float[], memory::AlignedDeleter> m_slab;
+	std::unique_ptr<std::atomic<std::uint32_t>[]>    m_next;
+	std::atomic<std::uint64_t>                       m_head;
+	std::atomic<int>                                 m_available;
+	int                                              m_numBuffers;
+	int                                              m_size;
+	int                                              m_channels;
+	int                                              m_slotSamples;
+};
+} // namespace mcl
+
+#endif
@@ -0,0 +1,1086 @@
+/* -----------------------------------------------------------------------------
+ *
+ * AudioBuffer
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2021 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of AudioBuffer.
+ *
+ * AudioBuffer is free software: you can redistribute it and/or modify it under 
+ * the terms of the GNU General Public License as published by the Free Software 
+ * Foundation, either version 3 of the License, or (at your option) any later 
+ * version.
+ *
+ * AudioBuffer is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS 
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more 
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with 
+ * AudioBuffer. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+#include "audioBufferView.hpp"
+#include "compactAudioBuffer.hpp"
+#include "denormals.hpp"
+#include "instrumentation.hpp"
+#include "kernels.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <numbers>
+#include <type_traits>
+
+namespace mcl
+{
+static_assert(std::is_trivially_copyable_v<AudioBufferView>);
+
+namespace
+{
+/* ConstantGains, RampGains
+Per-channel gains for AudioBufferView::copyData(), i.e. gain * pan[ch]. at()
+returns the gain of channel 'ch' at frame 'frame'. */
+
+struct ConstantGains
+{
+	std::array<float, AudioBufferView::MAX_CHANS> gain;
+
+	float at(int ch, int /*frame*/) const { return gain[ch]; }
+};
+
+struct RampGains
+{
+	std::array<float, AudioBufferView::MAX_CHANS> start;
+	std::array<float, AudioBufferView::MAX_CHANS> step;
+
+	float at(int ch, int frame) const { return start[ch] + static_cast<float>(frame) * step[ch]; }
+};
+
+/* -------------------------------------------------------------------------- */
+
+/* CurveTable
+A fade curve sampled at CURVE_POINTS + 1 evenly spaced points from 0.0 to 1.0.
+Tables are computed on first use and shared by all fades. */
+
+constexpr int CURVE_POINTS = 1024;
+
+using CurveTable = std::array<float, CURVE_POINTS + 1>;
+
+const CurveTable& getCurveTable(FadeCurve curve)
+{
+	static const std::array<CurveTable, 3> tables = [] {
+		std::array<CurveTable, 3> out;
+		for (int i = 0; i <= CURVE_POINTS; i++)
+		{
+			const double t = static_cast<double>(i) / CURVE_POINTS;
+			out[0][i]      = static_cast<float>(t);
+			out[1][i]      = static_cast<float>(std::sin(t * std::numbers::pi / 2));
+			out[2][i]      = static_cast<float>((std::pow(1000.0, t) - 1.0) / 999.0);
+		}
+		return out;
+	}();
+
+	return tables[static_cast<int>(curve)];
+}
+
+/* getCurveValue
+Returns the value of a curve at frame 'frame' of a fade, where 'scale' is the
+amount of table points per frame. Interpolates linearly between table points;
+positions past the end of the fade return the last point. */
+
+float getCurveValue(const CurveTable& table, int frame, float scale, bool out)
+{
+	float pos = std::min(frame * scale, static_cast<float>(CURVE_POINTS));
+	if (out)
+		pos = CURVE_POINTS - pos;
+
+	const int i = std::min(static_cast<int>(pos), CURVE_POINTS - 1);
+	return table[i] + (table[i + 1] - table[i]) * (pos - i);
+}
+
+/* fillEnvelope
+Writes the gains of 'frames' frames starting at frame 'offset' of a fade onto
+'env', one per frame. Long fades look the curve up once every 'grid' frames, 
+which is no more than a table segment, and fill the frames in between with 
+straight lines. The grid is aligned to the start of the fade, so that a fade 
+split over multiple blocks is the same as a single one. */
+
+void fillEnvelope(float* env, const CurveTable& table, int frames, int length, int offset, bool out)
+{
+	const int   grid  = std::max(1, length / CURVE_POINTS);
+	const float scale = static_cast<float>(CURVE_POINTS) / length;
+
+	if (grid == 1)
+	{
+		for (int i = 0; i < frames; i++)
+			env[i] = getCurveValue(table, offset + i, scale, out);
+		return;
+	}
+
+	int   frame = offset - offset % grid;
+	float a     = getCurveValue(table, frame, scale, out);
+
+	for (; frame < offset + frames; frame += grid)
+	{
+		const float b     = getCurveValue(table, frame + grid, scale, out);
+		const float step  = (b - a) / grid;
+		const int   first = std::max(frame, offset);
+		const int   last  = std::min(frame + grid, offset + frames);
+
+		for (int f = first; f < last; f++)
+			env[f - offset] = a + step * (f - frame);
+		a = b;
+	}
+}
+
+/* spreadEnvelope
+Copies each of the 'frames' gains of 'env' onto 'channels' consecutive 
+samples of 'dest'. */
+
+void spreadEnvelope(float* dest, const float* env, int frames, int channels)
+{
+	if (channels == 2)
+	{
+		for (int i = 0; i < frames; i++)
+			dest[i * 2] = dest[i * 2 + 1] = env[i];
+		return;
+	}
+
+	for (int i = 0; i < frames; i++)
+		for (int ch = 0; ch < channels; ch++)
+			dest[i * channels + ch] = env[i];
+}
+
+/* -------------------------------------------------------------------------- */
+
+/* flushIfEnabled
+Flushes denormals out of 'view' if the calling thread asked for it, see 
+denormals::ScopedFlushToZero. */
+
+void flushIfEnabled(const AudioBufferView& view)
+{
+	if (denormals::isSoftwareFlushEnabled())
+		view.flushDenormals();
+}
+
+/* -------------------------------------------------------------------------- */
+
+ConstantGains makeGains(float gain, AudioBufferView::Pan pan)
+{
+	ConstantGains out;
+	for (int ch = 0; ch < AudioBufferView::MAX_CHANS; ch++)
+		out.gain[ch] = gain * pan[ch];
+	return out;
+}
+
+RampGains makeGains(Ramp<float> gain, Ramp<AudioBufferView::Pan> pan, int frames)
+{
+	RampGains out;
+	for (int ch = 0; ch < AudioBufferView::MAX_CHANS; ch++)
+	{
+		out.start[ch] = gain.start * pan.start[ch];
+		out.step[ch]  = frames > 0 ? (gain.end * pan.end[ch] - out.start[ch]) / frames : 0.0f;
+	}
+	return out;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void decodePcm(float* dest, const void* src, PcmFormat format, int samples)
+{
+	const kernels::Table& k = kernels::getTable();
+
+	switch (format)
+	{
+	case PcmFormat::INT16:
+		return k.decodeInt16(dest, src, samples);
+	case PcmFormat::INT24:
+		return k.decodeInt24(dest, src, samples);
+	case PcmFormat::INT32:
+		return k.decodeInt32(dest, src, samples);
+	case PcmFormat::FLOAT32:
+		std::copy_n(static_cast<const float*>(src), samples, dest);
+		return;
+	case PcmFormat::FLOAT64:
+		return k.decodeFloat64(dest, src, samples);
+	}
+}
+
+void encodePcm(void* dest, const float* src, PcmFormat format, int samples, Dither* dither)
+{
+	const kernels::Table& k = kernels::getTable();
+
+	std::uint32_t  noState[kernels::DITHER_LANES] = {};
+	const float    amount                         = dither != nullptr ? dither->getAmount() : 0.0f;
+	std::uint32_t* state                          = dither != nullptr ? dither->getState() : noState;
+
+	switch (format)
+	{
+	case PcmFormat::INT16:
+		return k.encodeInt16(dest, src, samples, amount, state);
+	case PcmFormat::INT24:
+		return k.encodeInt24(dest, src, samples, amount, state);
+	case PcmFormat::INT32:
+		return k.encodeInt32(dest, src, samples, amount, state);
+	case PcmFormat::FLOAT32:
+		std::copy_n(src, samples, static_cast<float*>(dest));
+		return;
+	case PcmFormat::FLOAT64:
+		return k.encodeFloat64(dest, src, samples, amount, state);
+	}
+}
+} // namespace
+
+/* -------------------------------------------------------------------------- */
+
+AudioBufferView::AudioBufferView()
+: m_data(nullptr)
+, m_frames(0)
+, m_channels(0)
+, m_stride(0)
+{
+}
+
+/* -------------------------------------------------------------------------- */
+
+AudioBufferView::AudioBufferView(float* data, int frames, int channels, int stride)
+: m_data(data)
+, m_frames(frames)
+, m_channels(channels)
+, m_stride(stride == -1 ? channels : stride)
+{
+	assert(frames >= 0);
+	assert(channels <= MAX_CHANS);
+	assert(m_stride >= channels);
+	assert(data != nullptr || frames == 0);
+}
+
+/* -------------------------------------------------------------------------- */
+
+float* AudioBufferView::operator[](int offset) const
+{
+	assert(m_data != nullptr);
+	assert(offset >= 0 && offset < m_frames);
+	return m_data + (offset * m_stride);
+}
+
+/* -------------------------------------------------------------------------- */
+
+float* AudioBufferView::getData() const { return m_data; }
+int    AudioBufferView::countFrames() const { return m_frames; }
+int    AudioBufferView::countChannels() const { return m_channels; }
+int    AudioBufferView::getStride() const { return m_stride; }
+bool   AudioBufferView::isEmpty() const { return m_frames == 0; }
+bool   AudioBufferView::isContiguous() const { return m_stride == m_channels; }
+
+/* -------------------------------------------------------------------------- */
+
+AudioBufferView AudioBufferView::slice(int start, int count) const
+{
+	if (count == -1)
+		count = m_frames - start;
+
+	assert(start >= 0 && count >= 0);
+	assert(start + count <= m_frames);
+
+	if (count == 0)
+		return AudioBufferView(m_data, 0, m_channels, m_stride);
+	return AudioBufferView(m_data + (start * m_stride), count, m_channels, m_stride);
+}
+
+/* -------------------------------------------------------------------------- */
+
+AudioBufferView AudioBufferView::channel(int ch) const
+{
+	assert(ch >= 0 && ch < m_channels);
+
+	return AudioBufferView(m_data + ch, m_frames, 1, m_stride);
+}
+
+/* -------------------------------------------------------------------------- */
+
+float AudioBufferView::getPeak(int channel) const
+{
+	assert(channel < m_channels);
+
+	const float* data = m_data + channel;
+	float        peak = 0.0f;
+	for (int i = 0; i < m_frames; i++, data += m_stride)
+		peak = std::max(peak, std::fabs(*data));
+	return peak;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void AudioBufferView::analyze(std::span<ChannelStats> stats, float clipThreshold) const
+{
+	assert(stats.size() >= static_cast<std::size_t>(m_channels));
+
+	std::array<kernels::Stats, MAX_CHANS> raw;
+
+	if (isContiguous())
+	{
+		kernels::getTable().analyze(m_data, m_frames, m_channels, clipThreshold, raw.data());
+	}
+	else
+	{
+		raw.fill({FLT_MAX, -FLT_MAX, 0.0, 0});
+		for (int i = 0; i < m_frames; i++)
+		{
+			const float* frame = m_data + (i * m_stride);
+			for (int ch = 0; ch < m_channels; ch++)
+			{
+				const float v = frame[ch];
+				raw[ch].min   = std::min(raw[ch].min, v);
+				raw[ch].max   = std::max(raw[ch].max, v);
+				raw[ch].sumSquares += static_cast<double>(v) * v;
+				raw[ch].clipped += std::fabs(v) > clipThreshold ? 1 : 0;
+			}
+		}
+	}
+
+	for (int ch = 0; ch < m_channels; ch++)
+	{
+		if (m_frames == 0)
+		{
+			stats[ch] = {};
+			continue;
+		}
+		stats[ch].min        = raw[ch].min;
+		stats[ch].max        = raw[ch].max;
+		stats[ch].peak       = std::max(std::fabs(raw[ch].min), std::fabs(raw[ch].max));
+		stats[ch].sumSquares = raw[ch].sumSquares;
+		stats[ch].rms        = static_cast<float>(std::sqrt(raw[ch].sumSquares / m_frames));
+		stats[ch].clipped    = raw[ch].clipped;
+	}
+}
+
+/* -------------------------------------------------------------------------- */
+
+void AudioBufferView::sum(AudioBufferView src, float gain, Pan pan) const
+{
+	copyData<Operation::SUM>(src, makeGains(gain, pan));
+}
+
+void AudioBufferView::set(AudioBufferView src, float gain, Pan pan) const
+{
+	copyData<Operation::SET>(src, makeGains(gain, pan));
+}
+
+void AudioBufferView::sum(AudioBufferView src, const ChannelMatrix& matrix, float gain, Pan pan) const
+{
+	copyData<Operation::SUM>(src, matrix, makeGains(gain, pan));
+}
+
+void AudioBufferView::set(AudioBufferView src, const ChannelMatrix& matrix, float gain, Pan pan) const
+{
+	copyData<Operation::SET>(src, matrix, makeGains(gain, pan));
+}
+
+void AudioBufferView::sum(AudioBufferView src, Ramp<float> gain, Ramp<Pan> pan) const
+{
+	const int frames = std::min(m_frames, src.countFrames());
+	copyData<Operation::SUM>(src, makeGains(gain, pan, frames));
+}
+
+void AudioBufferView::set(AudioBufferView src, Ramp<float> gain, Ramp<Pan> pan) const
+{
+	const int frames = std::min(m_frames, src.countFrames());
+	copyData<Operation::SET>(src, makeGains(gain, pan, frames));
+}
+
+/* -------------------------------------------------------------------------- */
+
+double AudioBufferView::sum(AudioBufferView src, double pos, double step, Interpolation interp, float gain, Pan pan) const
+{
+	return resample<Operation::SUM>(src, pos, step, interp, gain, pan);
+}
+
+double AudioBufferView::set(AudioBufferView src, double pos, double step, Interpolation interp, float gain, Pan pan) const
+{
+	return resample<Operation::SET>(src, pos, step, interp, gain, pan);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void AudioBufferView::sum(CompactAudioBufferView src, float gain, Pan pan) const
+{
+	copyCompact<Operation::SUM>(src, gain, pan);
+}
+
+void AudioBufferView::set(CompactAudioBufferView src, float gain, Pan pan) const
+{
+	copyCompact<Operation::SET>(src, gain, pan);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void AudioBufferView::sum(std::span<const MixSource> sources) const
+{
+	for (int tile = 0; tile < m_frames; tile += MIX_TILE_FRAMES)
+	{
+		const int tileEnd = std::min(tile + MIX_TILE_FRAMES, m_frames);
+
+		for (const MixSource& source : sources)
+		{
+			assert(source.destOffset >= 0);
+
+			/* Portion of the source that overlaps the current tile. */
+
+			const int start = std::max(tile, source.destOffset);
+			const int end   = std::min(tileEnd, source.destOffset + source.src.countFrames());
+			if (start >= end)
+				continue;
+
+			slice(start, end - start).sum(source.src.slice(start - source.destOffset, end - start), source.gain, source.pan);
+		}
+	}
+}
+
+/* -------------------------------------------------------------------------- */
+
+void AudioBufferView::clear() const
+{
+	MCL_INSTRUMENT_SCOPE(instrumentation::Operation::CLEAR, m_frames, m_frames * m_channels * sizeof(float));
+
+	if (isContiguous())
+	{
+		std::fill_n(m_data, m_frames * m_channels, 0.0f);
+		return;
+	}
+	for (int i = 0; i < m_frames; i++)
+		std::fill_n(m_data + (i * m_stride), m_channels, 0.0f);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void AudioBufferView::applyGain(float g) const
+{
+	MCL_INSTRUMENT_SCOPE(instrumentation::Operation::APPLY_GAIN, m_frames, m_frames * m_channels * sizeof(float));
+
+	if (isContiguous())
+	{
+		const int samples = m_frames * m_channels;
+		for (int i = 0; i < samples; i++)
+			m_data[i] *= g;
+	}
+	else
+	{
+		for (int i = 0; i < m_frames; i++)
+			for (int ch = 0; ch < m_channels; ch++)
+				m_data[i * m_stride + ch] *= g;
+	}
+
+	flushIfEnabled(*this);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void AudioBufferView::applyGain(Ramp<float> gain) const
+{
+	MCL_INSTRUMENT_SCOPE(instrumentation::Operation::APPLY_GAIN, m_frames, m_frames * m_channels * sizeof(float));
+
+	/* In-place copy onto itself: each sample is read before being written. 
+	Counted as APPLY_GAIN only, not as MIX too. */
+
+	copyRaw<Operation::SET>(*this, makeGains(gain, {UNITY_PAN, UNITY_PAN}, m_frames));
+	flushIfEnabled(*this);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void AudioBufferView::fadeIn(FadeCurve curve, int length, int offset) const
+{
+	applyFade(curve, length, offset, false);
+	flushIfEnabled(*this);
+}
+
+void AudioBufferView::fadeOut(FadeCurve curve, int length, int offset) const
+{
+	applyFade(curve, length, offset, true);
+	flushIfEnabled(*this);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void AudioBufferView::crossfade(AudioBufferView from, AudioBufferView to, FadeCurve curve, int length, int offset) const
+{
+	assert(from.countChannels() == m_channels);
+	assert(to.countChannels() == m_channels);
+	assert(offset >= 0);
+
+	const int frames = std::min({m_frames, from.countFrames(), to.countFrames()});
+	if (length == -1)
+		length = frames;
+	if (frames == 0)
+		return;
+
+	assert(length > 0);
+
+	MCL_INSTRUMENT_SCOPE(instrumentation::Operation::MIX, frames, frames * m_channels * sizeof(float));
+
+	const CurveTable& table      = getCurveTable(curve);
+	const bool        packed     = isContiguous() && from.isContiguous() && to.isContiguous();
+	const int         tileFrames = PCM_TILE_SAMPLES / m_channels;
+	const int         fromStride = from.getStride();
+	const int         toStride   = to.getStride();
+
+	float gainsFrom[PCM_TILE_SAMPLES], gainsTo[PCM_TILE_SAMPLES];
+	float envFrom[PCM_TILE_SAMPLES], envTo[PCM_TILE_SAMPLES];
+
+	for (int f = 0; f < frames; f += tileFrames)
+	{
+		const int count = std::min(tileFrames, frames - f);
+		fillEnvelope(gainsFrom, table, count, length, offset + f, true);
+		fillEnvelope(gainsTo, table, count, length, offset + f, false);
+
+		if (packed)
+		{
+			const float* a = gainsFrom;
+			const float* b = gainsTo;
+			if (m_channels > 1)
+			{
+				spreadEnvelope(envFrom, gainsFrom, count, m_channels);
+				spreadEnvelope(envTo, gainsTo, count, m_channels);
+				a = envFrom;
+				b = envTo;
+			}
+			kernels::getTable().crossfade(getFrameUnchecked(f), from.getFrameUnchecked(f),
+			    to.getFrameUnchecked(f), count * m_channels, a, b);
+			continue;
+		}
+
+		float*       d = getFrameUnchecked(f);
+		const float* a = from.getFrameUnchecked(f);
+		const float* b = to.getFrameUnchecked(f);
+		for (int i = 0; i < count; i++, d += m_stride, a += fromStride, b += toStride)
+			for (int ch = 0; ch < m_channels; ch++)
+				d[ch] = a[ch] * gainsFrom[i] + b[ch] * gainsTo[i];
+	}
+
+	flushIfEnabled(slice(0, frames));
+}
+
+/* -------------------------------------------------------------------------- */
+
+void AudioBufferView::flushDenormals() const
+{
+	if (isContiguous())
+	{
+		kernels::getTable().flushDenormals(m_data, m_frames * m_channels);
+		return;
+	}
+	for (int i = 0; i < m_frames; i++)
+		kernels::getTable().flushDenormals(m_data + (i * m_stride), m_channels);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void AudioBufferView::setFromPcm(const void* src, PcmFormat format, int frames, int channels) const
+{
+	assert(channels > 0 && channels <= MAX_CHANS);
+
+	frames = std::min(frames, m_frames);
+
+	if (channels == m_channels && isContiguous())
+	{
+		decodePcm(m_data, src, format, frames * channels);
+		return;
+	}
+
+	/* Decode chunks onto a scratch area, then let set() adapt them to strides
+	and channel layout. */
+
+	float     tile[PCM_TILE_SAMPLES];
+	const int tileFrames = PCM_TILE_SAMPLES / channels;
+	const int frameSize  = getPcmSampleSize(format) * channels;
+
+	for (int f = 0; f < frames; f += tileFrames)
+	{
+		const int count = std::min(tileFrames, frames - f);
+		decodePcm(tile, static_cast<const char*>(src) + f * frameSize, format, count * channels);
+		slice(f, count).set(AudioBufferView(tile, count, channels));
+	}
+}
+
+/* -------------------------------------------------------------------------- */
+
+void AudioBufferView::writeToPcm(void* dest, PcmFormat format, Dither* dither) const
+{
+	if (isContiguous())
+	{
+		encodePcm(dest, m_data, format, m_frames * m_channels, dither);
+		return;
+	}
+
+	float     tile[PCM_TILE_SAMPLES];
+	const int tileFrames = PCM_TILE_SAMPLES / m_channels;
+	const int frameSize  = getPcmSampleSize(format) * m_channels;
+
+	for (int f = 0; f < m_frames; f += tileFrames)
+	{
+		const int count = std::min(tileFrames, m_frames - f);
+		AudioBufferView(tile, count, m_channels).set(slice(f, count));
+		encodePcm(static_cast<char*>(dest) + f * frameSize, tile, format, count * m_channels, dither);
+	}
+}
+
+/* -------------------------------------------------------------------------- */
+
+template <AudioBufferView::Operation O, typename G>
+void AudioBufferView::copyData(AudioBufferView src, const G& gains) const
+{
+	const int frames = std::min(m_frames, src.countFrames());
+
+	if (frames == 0)
+		return;
+
+	MCL_INSTRUMENT_SCOPE(instrumentation::Operation::MIX, frames, frames * m_channels * sizeof(float));
+
+	copyRaw<O>(src, gains);
+	flushIfEnabled(slice(0, frames));
+}
+
+/* -------------------------------------------------------------------------- */
+
+template <AudioBufferView::Operation O, typename G>
+void AudioBufferView::copyRaw(AudioBufferView src, const G& gains) const
+{
+	const int srcChannels  = src.countChannels();
+	const int destChannels = countChannels();
+	const int frames       = std::min(m_frames, src.countFrames());
+
+	if (frames == 0)
+		return;
+
+	/* Pick the right channel layout once, so that the inner loop doesn't have
+	to check it for every frame. */
+
+	if (srcChannels == 1 && destChannels == 1)
+		copyFrames<O, 1, 1>(m_data, m_stride, src.m_data, src.m_stride, frames, gains);
+	else if (srcChannels == 1 && destChannels == 2)
+		copyFrames<O, 1, 2>(m_data, m_stride, src.m_data, src.m_stride, frames, gains);
+	else if (srcChannels == 2 && destChannels == 2)
+		copyFrames<O, 2, 2>(m_data, m_stride, src.m_data, src.m_stride, frames, gains);
+	else if (srcChannels == 1 || srcChannels == destChannels)
+		copyFrames<O>(m_data, m_stride, destChannels, src.m_data, src.m_stride, srcChannels, frames, gains);
+	else
+		mixFrames<O>(m_data, m_stride, destChannels, src.m_data, src.m_stride, srcChannels, frames,
+		    ChannelMatrix::getDefault(srcChannels, destChannels), gains);
+}
+
+/* -------------------------------------------------------------------------- */
+
+template <AudioBufferView::Operation O, typename G>
+void AudioBufferView::copyData(AudioBufferView src, const ChannelMatrix& matrix, const G& gains) const
+{
+	const int frames = std::min(m_frames, src.countFrames());
+
+	assert(matrix.countSrcChannels() == src.countChannels());
+	assert(matrix.countDestChannels() == countChannels());
+
+	if (frames == 0)
+		return;
+
+	MCL_INSTRUMENT_SCOPE(instrumentation::Operation::MIX, frames, frames * m_channels * sizeof(float));
+
+	mixFrames<O>(m_data, m_stride, m_channels, src.m_data, src.m_stride, src.m_channels, frames, matrix, gains);
+
+	flushIfEnabled(slice(0, frames));
+}
+
+/* -------------------------------------------------------------------------- */
+
+template <AudioBufferView::Operation O, int SrcChannels, int DestChannels, typename G>
+void AudioBufferView::copyFrames(float* dest, int destStride, const float* src,
+    int srcStride, int frames, const G& gains)
+{
+	static_assert(SrcChannels <= DestChannels);
+
+	/* Fast path: packed stereo destination. Hand the job over to the 
+	vectorized kernels, picked at runtime according to the CPU capabilities. */
+
+	if constexpr (DestChannels == 2)
+	{
+		if (destStride == DestChannels && srcStride == SrcChannels)
+		{
+			const kernels::Table& k = kernels::getTable();
+
+			if constexpr (std::is_same_v<G, RampGains>)
+			{
+				const auto kernel = O == Operation::SUM
+				                        ? (SrcChannels == 2 ? k.sumStereoRamp : k.sumMonoRamp)
+				                        : (SrcChannels == 2 ? k.setStereoRamp : k.setMonoRamp);
+				kernel(dest, src, frames, gains.start[0], gains.start[1], gains.step[0], gains.step[1]);
+			}
+			else
+			{
+				const auto kernel = O == Operation::SUM
+				                        ? (SrcChannels == 2 ? k.sumStereo : k.sumMono)
+				                        : (SrcChannels == 2 ? k.setStereo : k.setMono);
+				kernel(dest, src, frames, gains.gain[0], gains.gain[1]);
+			}
+			return;
+		}
+	}
+
+	/* Case 1) mono source: spread it over all channels.
+	   Case 2) source has same amount of channels: copy them 1:1. */
+
+	for (int f = 0; f < frames; f++, dest += destStride, src += srcStride)
+	{
+		for (int ch = 0; ch < DestChannels; ch++)
+		{
+			const float val = src[SrcChannels == DestChannels ? ch : 0] * gains.at(ch, f);
+			if constexpr (O == Operation::SUM)
+				dest[ch] += val;
+			else
+				dest[ch] = val;
+		}
+	}
+}
+
+/* -------------------------------------------------------------------------- */
+
+template <AudioBufferView::Operation O, typename G>
+void AudioBufferView::copyFrames(float* dest, int destStride, int destChannels,
+    const float* src, int srcStride, int srcChannels, int frames, const G& gains)
+{
+	/* Same rules as the specialized version: a mono source is spread over all
+	channels, otherwise channels are copied 1:1. */
+
+	assert(srcChannels == 1 || srcChannels == destChannels);
+
+	const int srcStep = srcChannels == 1 ? 0 : 1;
+
+	for (int f = 0; f < frames; f++, dest += destStride, src += srcStride)
+	{
+		for (int ch = 0; ch < destChannels; ch++)
+		{
+			const float val = src[ch * srcStep] * gains.at(ch, f);
+			if constexpr (O == Operation::SUM)
+				dest[ch] += val;
+			else
+				dest[ch] = val;
+		}
+	}
+}
+/* -------------------------------------------------------------------------- */
+
+template <AudioBufferView::Operation O, typename G>
+void AudioBufferView::mixFrames(float* dest, int destStride, int destChannels,
+    const float* src, int srcStride, int srcChannels, int frames,
+    const ChannelMatrix& matrix, const G& gains)
+{
+	/* Fast path: packed stereo to mono with constant gains, the typical 
+	mono-compatibility fold. Hand it over to the vectorized kernels. */
+
+	if constexpr (std::is_same_v<G, ConstantGains>)
+	{
+		if (srcChannels == 2 && destChannels == 1 && srcStride == 2 && destStride == 1)
+		{
+			const kernels::Table& k      = kernels::getTable();
+			const auto            kernel = O == Operation::SUM ? k.sumDownmix : k.setDownmix;
+			kernel(dest, src, frames, matrix.get(0, 0) * gains.gain[0], matrix.get(0, 1) * gains.gain[0]);
+			return;
+		}
+	}
+
+	const float* rows[MAX_CHANS];
+	for (int ch = 0; ch < destChannels; ch++)
+		rows[ch] = matrix.getRow(ch);
+
+	for (int f = 0; f < frames; f++, dest += destStride, src += srcStride)
+	{
+		for (int ch = 0; ch < destChannels; ch++)
+		{
+			float mix = 0.0f;
+			for (int s = 0; s < srcChannels; s++)
+				mix += src[s] * rows[ch][s];
+
+			const float val = mix * gains.at(ch, f);
+			if constexpr (O == Operation::SUM)
+				dest[ch] += val;
+			else
+				dest[ch] = val;
+		}
+	}
+}
+
+/* -------------------------------------------------------------------------- */
+
+void AudioBufferView::applyFade(FadeCurve curve, int length, int offset, bool out) const
+{
+	assert(offset >= 0);
+
+	if (length == -1)
+		length = m_frames;
+	if (m_frames == 0)
+		return;
+
+	assert(length > 0);
+
+	/* Beyond the end of the fade gains are constant: nothing to do for fade-
+	ins, silence for fade-outs. */
+
+	const int frames = std::clamp(length - offset, 0, m_frames);
+	if (out && frames < m_frames)
+		slice(frames).clear();
+	if (frames == 0)
+		return;
+
+	MCL_INSTRUMENT_SCOPE(instrumentation::Operation::APPLY_GAIN, frames, frames * m_channels * sizeof(float));
+
+	const CurveTable& table      = getCurveTable(curve);
+	const int         tileFrames = PCM_TILE_SAMPLES / m_channels;
+
+	float gains[PCM_TILE_SAMPLES], env[PCM_TILE_SAMPLES];
+
+	for (int f = 0; f < frames; f += tileFrames)
+	{
+		const int count = std::min(tileFrames, frames - f);
+		fillEnvelope(gains, table, count, length, offset + f, out);
+
+		if (isContiguous())
+		{
+			if (m_channels > 1)
+				spreadEnvelope(env, gains, count, m_channels);
+			float* data = getFrameUnchecked(f);
+			kernels::getTable().applyEnvelope(data, data, count * m_channels, m_channels > 1 ? env : gains);
+			continue;
+		}
+
+		float* frame = getFrameUnchecked(f);
+		for (int i = 0; i < count; i++, frame += m_stride)
+			for (int ch = 0; ch < m_channels; ch++)
+				frame[ch] *= gains[i];
+	}
+}
+
+/* -------------------------------------------------------------------------- */
+
+template <AudioBufferView::Operation O>
+void AudioBufferView::copyCompact(CompactAudioBufferView src, float gain, const Pan& pan) const
+{
+	const int frames   = std::min(m_frames, src.countFrames());
+	const int channels = src.countChannels();
+	if (frames == 0)
+		return;
+
+	/* Int16 scaling is folded into the gains, so that kernels only deal with
+	raw integers. */
+
+	const kernels::Table& k     = kernels::getTable();
+	const bool            half  = src.getFormat() == CompactFormat::FLOAT16;
+	const float           scale = half ? 1.0f : src.getScale() / CompactAudioBufferView::INT16_RANGE;
+	const auto*           data  = src.getData();
+
+	auto decode = [&](float* dest, const std::uint16_t* in, int samples, float gainEven, float gainOdd, bool sum) {
+		if (half)
+			(sum ? k.sumHalf : k.setHalf)(dest, in, samples, gainEven, gainOdd);
+		else
+			(sum ? k.sumInt16 : k.setInt16)(dest, reinterpret_cast<const std::int16_t*>(in), samples, gainEven, gainOdd);
+	};
+
+	/* Matching layouts onto packed frames: decode straight into this view. 
+	The kernels alternate two gains, which fits mono, stereo, and any layout 
+	with the same gain on every channel. */
+
+	const ConstantGains gains   = makeGains(gain * scale, pan);
+	const bool          uniform = std::all_of(gains.gain.begin(), gains.gain.begin() + channels, [&](float g) { return g == gains.gain[0]; });
+
+	MCL_INSTRUMENT_SCOPE(instrumentation::Operation::MIX, frames, frames * m_channels * sizeof(float));
+
+	if (channels == m_channels && isContiguous() && (channels <= 2 || uniform))
+	{
+		decode(m_data, data, frames * channels, gains.gain[0], gains.gain[channels == 1 ? 0 : 1], O == Operation::SUM);
+		flushIfEnabled(slice(0, frames));
+		return;
+	}
+
+	/* Otherwise decode chunks onto a scratch area, then let sum() or set() 
+	apply gains and convert the channels. */
+
+	float               tile[PCM_TILE_SAMPLES];
+	const int           tileFrames = PCM_TILE_SAMPLES / channels;
+	const ConstantGains tileGains  = makeGains(gain, pan);
+
+	for (int f = 0; f < frames; f += tileFrames)
+	{
+		const int count = std::min(tileFrames, frames - f);
+		decode(tile, data + f * channels, count * channels, scale, scale, false);
+		slice(f, count).copyRaw<O>(AudioBufferView(tile, count, channels), tileGains);
+	}
+
+	flushIfEnabled(slice(0, frames));
+}
+
+/* -------------------------------------------------------------------------- */
+
+template <AudioBufferView::Operation O>
+double AudioBufferView::resample(AudioBufferView src, double pos, double step, Interpolation interp,
+    float gain, Pan pan) const
+{
+	assert(step > 0.0);
+	assert(pos >= 0.0);
+
+	const int srcFrames = src.countFrames();
+
+	/* Amount of frames whose position falls within the source. The estimate 
+	is then fixed against the exact positions the kernels will compute. */
+
+	int frames = 0;
+	if (pos < srcFrames)
+	{
+		const double estimate = std::ceil((srcFrames - pos) / step);
+		frames                = static_cast<int>(std::min(estimate, static_cast<double>(m_frames)));
+		while (frames > 0 && pos + (frames - 1) * step >= srcFrames)
+			frames--;
+		while (frames < m_frames && pos + frames * step < srcFrames)
+			frames++;
+	}
+
+	if (frames == 0)
+		return pos;
+
+	MCL_INSTRUMENT_SCOPE(instrumentation::Operation::MIX, frames, frames * m_channels * sizeof(float));
+
+	const kernels::Table& k        = kernels::getTable();
+	const auto            kernel   = interp == Interpolation::HERMITE ? k.resampleHermite : k.resampleLinear;
+	const int             channels = src.countChannels();
+
+	/* Plain set() with matching layouts: interpolate straight into this view. */
+
+	if (O == Operation::SET && channels == m_channels && isContiguous() && gain == 1.0f && pan == UNITY_PAN)
+	{
+		kernel(m_data, src.m_data, srcFrames, src.m_stride, channels, frames, pos, step);
+		flushIfEnabled(slice(0, frames));
+		return pos + frames * step;
+	}
+
+	/* Otherwise interpolate chunks onto a scratch area, then let sum() or set()
+	apply gains and convert the channels. */
+
+	float               tile[PCM_TILE_SAMPLES];
+	const int           tileFrames = PCM_TILE_SAMPLES / channels;
+	const ConstantGains gains      = makeGains(gain, pan);
+
+	for (int f = 0; f < frames; f += tileFrames)
+	{
+		const int count = std::min(tileFrames, frames - f);
+		kernel(tile, src.m_data, srcFrames, src.m_stride, channels, count, pos + f * step, step);
+		slice(f, count).copyRaw<O>(AudioBufferView(tile, count, channels), gains);
+	}
+
+	/* Denormals are flushed once, over everything written. */
+
+	flushIfEnabled(slice(0, frames));
+	return pos + frames * step;
+}
+
+/* -------------------------------------------------------------------------- */
+
+ChannelMatrix::ChannelMatrix()
+: m_coeffs{}
+, m_srcChannels(0)
+, m_destChannels(0)
+{
+}
+
+/* -------------------------------------------------------------------------- */
+
+ChannelMatrix ChannelMatrix::makeZero(int srcChannels, int destChannels)
+{
+	assert(srcChannels > 0 && srcChannels <= MAX_CHANS);
+	assert(destChannels > 0 && destChannels <= MAX_CHANS);
+
+	ChannelMatrix m;
+	m.m_srcChannels  = srcChannels;
+	m.m_destChannels = destChannels;
+	return m;
+}
+
+/* -------------------------------------------------------------------------- */
+
+ChannelMatrix ChannelMatrix::makeDefault(int srcChannels, int destChannels)
+{
+	ChannelMatrix m = makeZero(srcChannels, destChannels);
+
+	if (srcChannels == 1)
+	{
+		for (int d = 0; d < destChannels; d++)
+			m.set(d, 0, 1.0f);
+		return m;
+	}
+
+	for (int s = 0; s < srcChannels; s++)
+	{
+		const int d     = s % destChannels;
+		const int count = (srcChannels - d + destChannels - 1) / destChannels; // Sources landing on 'd'
+		m.set(d, s, 1.0f / count);
+	}
+	return m;
+}
+
+/* -------------------------------------------------------------------------- */
+
+const ChannelMatrix& ChannelMatrix::getDefault(int srcChannels, int destChannels)
+{
+	assert(srcChannels > 0 && srcChannels <= MAX_CHANS);
+	assert(destChannels > 0 && destChannels <= MAX_CHANS);
+
+	/* One slot per pair, filled on first use. Threads racing on an empty slot
+	all build the matrix, only one gets published. Matrices live until the 
+	program exits. */
+
+	static std::array<std::atomic<const ChannelMatrix*>, MAX_CHANS * MAX_CHANS> cache{};
+
+	std::atomic<const ChannelMatrix*>& slot   = cache[(srcChannels - 1) * MAX_CHANS + (destChannels - 1)];
+	const ChannelMatrix*               matrix = slot.load(std::memory_order_acquire);
+	if (matrix != nullptr)
+		return *matrix;
+
+	const ChannelMatrix* built = new ChannelMatrix(makeDefault(srcChannels, destChannels));
+	if (slot.compare_exchange_strong(matrix, built, std::memory_order_acq_rel, std::memory_order_acquire))
+		return *built;
+	delete built;
+	return *matrix;
+}
+
+/* -------------------------------------------------------------------------- */
+
+const float* ChannelMatrix::getRow(int dest) const
+{
+	assert(dest >= 0 && dest < m_destChannels);
+	return m_coeffs.data() + (dest * MAX_CHANS);
+}
+
+/* -------------------------------------------------------------------------- */
+
+float ChannelMatrix::get(int dest, int src) const
+{
+	assert(dest >= 0 && dest < m_destChannels);
+	assert(src >= 0 && src < m_srcChannels);
+	return m_coeffs[dest * MAX_CHANS + src];
+}
+
+/* -------------------------------------------------------------------------- */
+
+void ChannelMatrix::set(int dest, int src, float value)
+{
+	assert(dest >= 0 && dest < m_destChannels);
+	assert(src >= 0 && src < m_srcChannels);
+	m_coeffs[dest * MAX_CHANS + src] = value;
+}
+
+/* -------------------------------------------------------------------------- */
+
+int ChannelMatrix::countSrcChannels() const { return m_srcChannels; }
+int ChannelMatrix::countDestChannels() const { return m_destChannels; }
+} // namespace mcl
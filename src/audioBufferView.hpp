@@ -0,0 +1,462 @@
+/* -----------------------------------------------------------------------------
+ *
+ * AudioBuffer
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2021 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of AudioBuffer.
+ *
+ * AudioBuffer is free software: you can redistribute it and/or modify it under 
+ * the terms of the GNU General Public License as published by the Free Software 
+ * Foundation, either version 3 of the License, or (at your option) any later 
+ * version.
+ *
+ * AudioBuffer is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS 
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more 
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with 
+ * AudioBuffer. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+#ifndef MONOCASUAL_AUDIO_BUFFER_VIEW_H
+#define MONOCASUAL_AUDIO_BUFFER_VIEW_H
+
+#include "pcm.hpp"
+#include <array>
+#include <span>
+
+namespace mcl
+{
+struct MixSource;
+struct ChannelStats;
+class ChannelMatrix;
+class CompactAudioBufferView;
+
+/* Ramp
+A linear transition from 'start' to 'end' over the frames being processed. 
+The value at frame 'i' of 'n' is start + (end - start) * i / n, so that 'end'
+is reached on the first frame of the next block: pass the same value as 'end'
+of the current block and 'start' of the next one for seamless transitions. */
+
+template <typename T>
+struct Ramp
+{
+	T start;
+	T end;
+};
+
+/* Interpolation
+How AudioBufferView::sum() and set() compute samples falling between two 
+source frames when reading at a fractional rate. LINEAR is the cheapest; 
+HERMITE uses 4 points and keeps more high frequencies. */
+
+enum class Interpolation
+{
+	LINEAR,
+	HERMITE
+};
+
+/* FadeCurve
+Shapes of AudioBufferView::fadeIn(), fadeOut() and crossfade(). EQUAL_POWER 
+(a quarter of a sine) keeps the loudness of uncorrelated material constant 
+across crossfades; EXPONENTIAL rises by a constant amount of dB over the 
+last 60 dB (the first frames are near silent) and sounds the most natural in
+long fades. */
+
+enum class FadeCurve
+{
+	LINEAR,
+	EQUAL_POWER,
+	EXPONENTIAL
+};
+
+/* AudioBufferView
+A non-owning, trivially copyable window over interleaved audio data. It never
+allocates nor frees: whoever provides the data is responsible for keeping it
+alive while the view is in use. Frames are 'stride' samples apart: a stride
+larger than the number of channels lets a view address a subset of the 
+channels of a wider buffer (see channel() below). Like std::span, constness is
+shallow: a const view still grants write access to the underlying data. */
+
+class AudioBufferView
+{
+public:
+	static constexpr int MAX_CHANS = 16;
+
+	/* Pan
+	Per-channel gains, one for each destination channel. Channels not listed in
+	an initializer are set to 0: use UNITY_PAN as a starting point when working
+	with more than two channels. */
+
+	using Pan = std::array<float, MAX_CHANS>;
+
+	static constexpr Pan UNITY_PAN = [] {
+		Pan pan{};
+		pan.fill(1.0f);
+		return pan;
+	}();
+
+	/* AudioBufferView (1)
+	Creates an empty view. */
+
+	AudioBufferView();
+
+	/* AudioBufferView (2)
+	Creates a view over 'frames' frames of 'channels' channels each, starting at
+	'data'. If 'stride' is -1 frames are assumed to be packed, that is 
+	stride == channels. */
+
+	AudioBufferView(float* data, int frames, int channels, int stride = -1);
+
+	/* operator []
+	Given a frame 'offset', returns a pointer to it. Same as 
+	AudioBuffer::operator[]. The offset is validated on every call: loops 
+	should check their range once and then use getFrameUnchecked(), or walk
+	getData() by getStride(). */
+
+	float* operator[](int offset) const;
+
+	/* getFrameUnchecked
+	Same as operator [], without any check. 'offset' MUST lie within 
+	[0, countFrames()). */
+
+	float* getFrameUnchecked(int offset) const;
+
+	/* getData, getStride
+	The first sample of the view and the distance between two consecutive 
+	frames, in samples: sample 'ch' of frame 'f' is at 
+	getData()[f * getStride() + ch]. */
+
+	float* getData() const;
+	int    getStride() const;
+
+	int  countFrames() const;
+	int  countChannels() const;
+	bool isEmpty() const;
+
+	/* isContiguous
+	True if frames are packed one after another, with no gaps in between. */
+
+	bool isContiguous() const;
+
+	/* slice
+	Returns a sub-view of 'count' frames starting at frame 'start'. If 'count' 
+	is -1 the sub-view extends to the end of this one. */
+
+	AudioBufferView slice(int start, int count = -1) const;
+
+	/* channel
+	Returns a mono view over channel 'ch' of this one. */
+
+	AudioBufferView channel(int ch) const;
+
+	/* getPeak
+	Returns the highest absolute value from the specified channel. */
+
+	float getPeak(int channel) const;
+
+	/* analyze
+	Computes the statistics of every channel in one pass, storing them into 
+	'stats' which MUST hold at least countChannels() elements. A sample is 
+	counted as clipped if its absolute value exceeds 'clipThreshold'. */
+
+	void analyze(std::span<ChannelStats> stats, float clipThreshold = 1.0f) const;
+
+	/* sum, set
+	Merges (sum) or copies (set) view 'src' onto this one. The amount of frames
+	processed is the smallest between the two views. If 'src' has a different 
+	amount of channels, it is converted on the fly according to 
+	ChannelMatrix::makeDefault(): for example a mono source is spread over all
+	channels and a stereo source onto a mono view is mixed down, while a stereo
+	source onto a quad view fills the first two channels only. */
+
+	void sum(AudioBufferView src, float gain = 1.0f, Pan pan = UNITY_PAN) const;
+	void set(AudioBufferView src, float gain = 1.0f, Pan pan = UNITY_PAN) const;
+
+	/* sum, set (channel matrix)
+	Same as sum, set above, converting the channels of 'src' through 'matrix' 
+	in the same pass: destination channel 'd' receives the source channels 
+	weighted by matrix.get(d, s), then 'gain' and 'pan[d]' are applied. The 
+	matrix MUST be sized src.countChannels() x countChannels(). Views MUST NOT
+	overlap. */
+
+	void sum(AudioBufferView src, const ChannelMatrix& matrix, float gain = 1.0f, Pan pan = UNITY_PAN) const;
+	void set(AudioBufferView src, const ChannelMatrix& matrix, float gain = 1.0f, Pan pan = UNITY_PAN) const;
+
+	/* sum (multiple sources)
+	Merges all 'sources' onto this view in a single pass. The view is processed
+	in tiles small enough to stay in cache while every source is accumulated, 
+	so that each destination frame is loaded and stored once per tile rather 
+	than once per source. The result is the same as calling sum() for each 
+	source in order. */
+
+	void sum(std::span<const MixSource> sources) const;
+
+	/* sum, set (ramp)
+	Same as sum, set above, with gain and pan moving linearly across the 
+	processed frames. The gain of each channel ramps from gain.start * 
+	pan.start[ch] to gain.end * pan.end[ch]. */
+
+	void sum(AudioBufferView src, Ramp<float> gain, Ramp<Pan> pan = {UNITY_PAN, UNITY_PAN}) const;
+	void set(AudioBufferView src, Ramp<float> gain, Ramp<Pan> pan = {UNITY_PAN, UNITY_PAN}) const;
+
+	/* sum, set (fractional rate)
+	Same as sum, set above, reading 'src' at fractional frame positions: frame
+	'i' of this view is interpolated from 'src' at position 'pos + i * step'. 
+	A 'step' of 2.0 plays twice as fast, 0.5 half as fast. Processing stops at
+	the end of this view or when a position reaches src.countFrames(). Returns
+	the position following the last processed frame: pass it as 'pos' of the
+	next block for gapless playback. 'step' MUST be > 0, 'pos' >= 0. */
+
+	double sum(AudioBufferView src, double pos, double step, Interpolation interp = Interpolation::LINEAR,
+	    float gain = 1.0f, Pan pan = UNITY_PAN) const;
+	double set(AudioBufferView src, double pos, double step, Interpolation interp = Interpolation::LINEAR,
+	    float gain = 1.0f, Pan pan = UNITY_PAN) const;
+
+	/* sum, set (compact)
+	Same as sum, set above, reading 16-bit samples (see CompactAudioBuffer). 
+	When channels match and this view is packed, samples are decoded inside 
+	the mixing kernel; otherwise they go through a small scratch area first. */
+
+	void sum(CompactAudioBufferView src, float gain = 1.0f, Pan pan = UNITY_PAN) const;
+	void set(CompactAudioBufferView src, float gain = 1.0f, Pan pan = UNITY_PAN) const;
+
+	/* clear
+	Sets all samples to 0.0f. */
+
+	void clear() const;
+
+	/* applyGain
+	Applies gain 'g' to all samples. */
+
+	void applyGain(float g) const;
+
+	/* applyGain (ramp)
+	Applies a gain moving linearly from gain.start to gain.end. */
+
+	void applyGain(Ramp<float> gain) const;
+
+	/* fadeIn, fadeOut
+	Apply a fade of 'length' frames, starting from 0 or silence and ending on
+	unity gain or silence respectively. This view covers the part of the fade
+	starting at frame 'offset': pass increasing offsets to spread a fade over
+	multiple blocks. Frames past the end of the fade are left alone by fadeIn()
+	and cleared by fadeOut(). If 'length' is -1, the fade lasts as long as the
+	view. */
+
+	void fadeIn(FadeCurve curve, int length = -1, int offset = 0) const;
+	void fadeOut(FadeCurve curve, int length = -1, int offset = 0) const;
+
+	/* crossfade
+	Sets this view to 'from' fading out plus 'to' fading in, with the same 
+	curve, 'length' and 'offset' as fadeIn() and fadeOut(). The amount of 
+	frames processed is the smallest among the three views. Sources MUST have
+	as many channels as this view; either of them can be this view itself. */
+
+	void crossfade(AudioBufferView from, AudioBufferView to, FadeCurve curve, int length = -1, int offset = 0) const;
+
+	/* flushDenormals
+	Replaces subnormal samples with zeros. Operations that write samples call
+	it on their own while a denormals::ScopedFlushToZero guard in SOFTWARE mode
+	is alive on the calling thread. */
+
+	void flushDenormals() const;
+
+	/* setFromPcm
+	Decodes 'frames' frames of 'channels' interleaved PCM channels from 'src'
+	onto this view. Frames beyond the end of the view are ignored, channels are
+	converted as in set(). 'src' MUST be aligned to the size of its samples. */
+
+	void setFromPcm(const void* src, PcmFormat format, int frames, int channels) const;
+
+	/* writeToPcm
+	Encodes the whole view to interleaved PCM into 'dest', which MUST have room
+	for countFrames() * countChannels() samples aligned to their size. Out of 
+	range samples are clipped. If 'dither' is provided, TPDF noise is added 
+	before rounding to integer formats. */
+
+	void writeToPcm(void* dest, PcmFormat format, Dither* dither = nullptr) const;
+
+private:
+	enum class Operation
+	{
+		SUM,
+		SET
+	};
+
+	/* copyData
+	Merges or copies 'src' onto this view, with per-channel gains 'G': either 
+	constant or ramping (see audioBufferView.cpp). */
+
+	template <Operation O, typename G>
+	void copyData(AudioBufferView src, const G& gains) const;
+
+	template <Operation O, typename G>
+	void copyData(AudioBufferView src, const ChannelMatrix& matrix, const G& gains) const;
+
+	/* copyRaw
+	Same as copyData, without instrumentation nor denormal flushing: for 
+	operations built on top of it, which take care of both. */
+
+	template <Operation O, typename G>
+	void copyRaw(AudioBufferView src, const G& gains) const;
+
+	/* copyFrames (1)
+	Inner loop of copyData, specialized for each source/destination channel 
+	layout. 'dest' and 'src' point to the first frame to process. */
+
+	template <Operation O, int SrcChannels, int DestChannels, typename G>
+	static void copyFrames(float* dest, int destStride, const float* src,
+	    int srcStride, int frames, const G& gains);
+
+	/* copyFrames (2)
+	Same as above, for layouts with a channel count known only at runtime. */
+
+	template <Operation O, typename G>
+	static void copyFrames(float* dest, int destStride, int destChannels,
+	    const float* src, int srcStride, int srcChannels, int frames, const G& gains);
+
+	/* mixFrames
+	Inner loop of copyData with a channel matrix. */
+
+	template <Operation O, typename G>
+	static void mixFrames(float* dest, int destStride, int destChannels,
+	    const float* src, int srcStride, int srcChannels, int frames,
+	    const ChannelMatrix& matrix, const G& gains);
+
+	/* applyFade
+	Implementation of fadeIn() and fadeOut(). */
+
+	void applyFade(FadeCurve curve, int length, int offset, bool out) const;
+
+	/* copyCompact
+	Merges or copies compact samples onto this view. */
+
+	template <Operation O>
+	void copyCompact(CompactAudioBufferView src, float gain, const Pan& pan) const;
+
+	/* resample
+	Implementation of the fractional rate sum() and set(). */
+
+	template <Operation O>
+	double resample(AudioBufferView src, double pos, double step, Interpolation interp,
+	    float gain, Pan pan) const;
+
+	/* MIX_TILE_FRAMES
+	Tile size for the multi-source sum(). 256 stereo frames take 2 KiB, leaving
+	plenty of L1 cache for the sources being streamed in. */
+
+	static constexpr int MIX_TILE_FRAMES = 256;
+
+	/* PCM_TILE_SAMPLES
+	Size of the scratch area used by setFromPcm(), writeToPcm() and resample()
+	when the data can't be converted in place, because of strides or channel 
+	layouts. */
+
+	static constexpr int PCM_TILE_SAMPLES = 2048;
+
+	float* m_data;
+	int    m_frames;
+	int    m_channels;
+	int    m_stride;
+};
+
+/* ChannelStats
+Statistics of a single channel, see AudioBufferView::analyze(). All values are
+0 for empty views. */
+
+struct ChannelStats
+{
+	float  peak       = 0.0f; // Highest absolute value
+	float  min        = 0.0f;
+	float  max        = 0.0f;
+	float  rms        = 0.0f;
+	double sumSquares = 0.0;
+	int    clipped    = 0; // Number of clipped samples
+};
+
+/* ChannelMatrix
+Coefficients for converting between channel layouts, see 
+AudioBufferView::sum(AudioBufferView, const ChannelMatrix&, float, Pan). Entry 
+(dest, src) is the weight of source channel 'src' in destination channel 
+'dest'. */
+
+class ChannelMatrix
+{
+public:
+	/* ChannelMatrix
+	Creates an empty 0 x 0 matrix. Use makeZero() or makeDefault() below to 
+	get a usable one. */
+
+	ChannelMatrix();
+
+	/* makeZero
+	Returns a 'srcChannels' x 'destChannels' matrix filled with 0.0f's. */
+
+	static ChannelMatrix makeZero(int srcChannels, int destChannels);
+
+	/* makeDefault
+	Returns the conversion used by AudioBufferView::sum() and set() when the 
+	amount of channels differs. Same layouts are copied 1:1 and a mono source is
+	spread over all channels. Otherwise source channel 's' goes to destination
+	channel 's % destChannels', averaging the ones that land on the same 
+	destination: stereo to mono is (L + R) / 2. Destination channels past the 
+	source ones get nothing: stereo to quad or 5.1 fills the first two channels
+	only, the others are left alone by sum() and silenced by set(). */
+
+	static ChannelMatrix makeDefault(int srcChannels, int destChannels);
+
+	/* getDefault
+	Same as makeDefault(), but built once per pair of channel counts and 
+	cached. Only the first call for a pair allocates. */
+
+	static const ChannelMatrix& getDefault(int srcChannels, int destChannels);
+
+	/* getRow
+	Returns the coefficients of destination channel 'dest', one for each source
+	channel. Meant for inner loops, which would otherwise validate both 
+	indexes of get() on every sample. */
+
+	const float* getRow(int dest) const;
+
+	float get(int dest, int src) const;
+	void  set(int dest, int src, float value);
+	int   countSrcChannels() const;
+	int   countDestChannels() const;
+
+private:
+	static constexpr int MAX_CHANS = AudioBufferView::MAX_CHANS;
+
+	std::array<float, MAX_CHANS * MAX_CHANS> m_coeffs;
+	int                                      m_srcChannels;
+	int                                      m_destChannels;
+};
+
+/* MixSource
+A source for AudioBufferView::sum(std::span<const MixSource>). 'destOffset' is
+the destination frame the source starts at; pick a sub-range of the source 
+with AudioBufferView::slice(). */
+
+struct MixSource
+{
+	AudioBufferView      src;
+	float                gain       = 1.0f;
+	AudioBufferView::Pan pan        = AudioBufferView::UNITY_PAN;
+	int                  destOffset = 0;
+};
+
+/* -------------------------------------------------------------------------- */
+
+inline float* AudioBufferView::getFrameUnchecked(int offset) const
+{
+	return m_data + (offset * m_stride);
+}
+} // namespace mcl
+
+#endif
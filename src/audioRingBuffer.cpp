@@ -0,0 +1,173 @@
+/* -----------------------------------------------------------------------------
+ *
+ * AudioBuffer
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2021 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of AudioBuffer.
+ *
+ * AudioBuffer is free software: you can redistribute it and/or modify it under 
+ * the terms of the GNU General Public License as published by the Free Software 
+ * Foundation, either version 3 of the License, or (at your option) any later 
+ * version.
+ *
+ * AudioBuffer is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS 
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more 
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with 
+ * AudioBuffer. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+#include "audioRingBuffer.hpp"
+#include <algorithm>
+#include <cassert>
+
+namespace mcl
+{
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free);
+
+/* -------------------------------------------------------------------------- */
+
+int AudioRingBuffer::Region::countFrames() const
+{
+	return first.countFrames() + second.countFrames();
+}
+
+/* -------------------------------------------------------------------------- */
+
+AudioRingBuffer::AudioRingBuffer(int size, int channels)
+: m_buffer(size, channels)
+, m_size(size)
+, m_writePos(0)
+, m_cachedReadPos(0)
+, m_readPos(0)
+, m_cachedWritePos(0)
+{
+	assert(size > 0);
+}
+
+/* -------------------------------------------------------------------------- */
+
+int AudioRingBuffer::countFrames() const { return m_size; }
+int AudioRingBuffer::countChannels() const { return m_buffer.countChannels(); }
+
+/* -------------------------------------------------------------------------- */
+
+int AudioRingBuffer::countReadable() const
+{
+	const std::uint64_t readPos = m_readPos.load(std::memory_order_acquire);
+	return static_cast<int>(m_writePos.load(std::memory_order_acquire) - readPos);
+}
+
+int AudioRingBuffer::countWritable() const
+{
+	return m_size - countReadable();
+}
+
+/* -------------------------------------------------------------------------- */
+
+AudioRingBuffer::Region AudioRingBuffer::prepareWrite(int frames)
+{
+	const std::uint64_t writePos = m_writePos.load(std::memory_order_relaxed);
+
+	/* Refresh the consumer position only if the cached one doesn't leave 
+	enough room: this keeps the consumer's cache line untouched most of the 
+	time. */
+
+	int writable = m_size - static_cast<int>(writePos - m_cachedReadPos);
+	if (frames == -1 || writable < frames)
+	{
+		m_cachedReadPos = m_readPos.load(std::memory_order_acquire);
+		writable        = m_size - static_cast<int>(writePos - m_cachedReadPos);
+	}
+
+	return getRegion(writePos, frames == -1 ? writable : std::min(frames, writable));
+}
+
+/* -------------------------------------------------------------------------- */
+
+void AudioRingBuffer::commitWrite(int frames)
+{
+	const std::uint64_t writePos = m_writePos.load(std::memory_order_relaxed);
+
+	assert(frames >= 0);
+	assert(static_cast<int>(writePos - m_cachedReadPos) + frames <= m_size);
+
+	m_writePos.store(writePos + frames, std::memory_order_release);
+}
+
+/* -------------------------------------------------------------------------- */
+
+int AudioRingBuffer::write(AudioBufferView src)
+{
+	const Region region = prepareWrite(src.countFrames());
+	const int    split  = region.first.countFrames();
+
+	region.first.set(src);
+	if (!region.second.isEmpty())
+		region.second.set(src.slice(split));
+
+	commitWrite(region.countFrames());
+	return region.countFrames();
+}
+
+/* -------------------------------------------------------------------------- */
+
+AudioRingBuffer::Region AudioRingBuffer::prepareRead(int frames) const
+{
+	const std::uint64_t readPos = m_readPos.load(std::memory_order_relaxed);
+
+	int readable = static_cast<int>(m_cachedWritePos - readPos);
+	if (frames == -1 || readable < frames)
+	{
+		m_cachedWritePos = m_writePos.load(std::memory_order_acquire);
+		readable         = static_cast<int>(m_cachedWritePos - readPos);
+	}
+
+	return getRegion(readPos, frames == -1 ? readable : std::min(frames, readable));
+}
+
+/* -------------------------------------------------------------------------- */
+
+void AudioRingBuffer::commitRead(int frames)
+{
+	const std::uint64_t readPos = m_readPos.load(std::memory_order_relaxed);
+
+	assert(frames >= 0);
+	assert(static_cast<int>(m_cachedWritePos - readPos) >= frames);
+
+	m_readPos.store(readPos + frames, std::memory_order_release);
+}
+
+/* -------------------------------------------------------------------------- */
+
+int AudioRingBuffer::read(AudioBufferView dest)
+{
+	const Region region = prepareRead(dest.countFrames());
+	const int    split  = region.first.countFrames();
+
+	dest.set(region.first);
+	if (!region.second.isEmpty())
+		dest.slice(split).set(region.second);
+
+	commitRead(region.countFrames());
+	return region.countFrames();
+}
+
+/* -------------------------------------------------------------------------- */
+
+AudioRingBuffer::Region AudioRingBuffer::getRegion(std::uint64_t pos, int frames) const
+{
+	const int start = static_cast<int>(pos % static_cast<std::uint64_t>(m_size));
+	const int first = std::min(frames, m_size - start);
+
+	const AudioBufferView all = m_buffer.view();
+	return {all.slice(start, first), all.slice(0, frames - first)};
+}
+} // namespace mcl
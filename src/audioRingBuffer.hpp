@@ -0,0 +1,133 @@
+/* -----------------------------------------------------------------------------
+ *
+ * AudioBuffer
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2021 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of AudioBuffer.
+ *
+ * AudioBuffer is free software: you can redistribute it and/or modify it under 
+ * the terms of the GNU General Public License as published by the Free Software 
+ * Foundation, either version 3 of the License, or (at your option) any later 
+ * version.
+ *
+ * AudioBuffer is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS 
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more 
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with 
+ * AudioBuffer. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+#ifndef MONOCASUAL_AUDIO_RING_BUFFER_H
+#define MONOCASUAL_AUDIO_RING_BUFFER_H
+
+#include "audioBuffer.hpp"
+#include "audioBufferView.hpp"
+#include "memory.hpp"
+#include <atomic>
+#include <cstdint>
+
+namespace mcl
+{
+/* AudioRingBuffer
+A fixed-size FIFO of interleaved audio frames, for passing audio between 
+exactly one producer thread and one consumer thread. Reading and writing are
+wait-free and never allocate. Data is exposed in place as (at most) two views,
+so that it can be fed to AudioBufferView::sum() or set() directly, without
+intermediate copies. */
+
+class AudioRingBuffer
+{
+public:
+	/* Region
+	A contiguous range of the ring buffer, split in two views when it wraps 
+	around the end of the underlying memory. 'second' is empty otherwise. */
+
+	struct Region
+	{
+		AudioBufferView first;
+		AudioBufferView second;
+
+		int countFrames() const;
+	};
+
+	/* AudioRingBuffer
+	Allocates room for 'size' frames of 'channels' channels. */
+
+	AudioRingBuffer(int size, int channels);
+	AudioRingBuffer(const AudioRingBuffer&) = delete;
+
+	AudioRingBuffer& operator=(const AudioRingBuffer&) = delete;
+
+	int countFrames() const;
+	int countChannels() const;
+
+	/* countReadable, countWritable
+	Returns how many frames can be read or written right now. The value might
+	be outdated as soon as it's returned, if the other side is active. */
+
+	int countReadable() const;
+	int countWritable() const;
+
+	/* prepareWrite [producer]
+	Returns a writable region of up to 'frames' frames, or all the free space if
+	'frames' is -1. The region might be shorter than requested if the buffer is
+	full. Nothing is visible to the consumer until commitWrite() is called. */
+
+	Region prepareWrite(int frames = -1);
+
+	/* commitWrite [producer]
+	Publishes 'frames' frames written into the region returned by 
+	prepareWrite(). */
+
+	void commitWrite(int frames);
+
+	/* write [producer]
+	Copies as many frames as possible from 'src' and publishes them. Returns
+	the amount of frames written. */
+
+	int write(AudioBufferView src);
+
+	/* prepareRead [consumer]
+	Returns a readable region of up to 'frames' frames, or all the available 
+	ones if 'frames' is -1. */
+
+	Region prepareRead(int frames = -1) const;
+
+	/* commitRead [consumer]
+	Releases 'frames' frames of the region returned by prepareRead(), making 
+	room for the producer. */
+
+	void commitRead(int frames);
+
+	/* read [consumer]
+	Copies as many frames as possible onto 'dest' and releases them. Returns
+	the amount of frames read. */
+
+	int read(AudioBufferView dest);
+
+private:
+	Region getRegion(std::uint64_t pos, int frames) const;
+
+	AudioBuffer m_buffer;
+	int         m_size;
+
+	/* Positions are free-running frame counters, wrapped onto the buffer only
+	when accessing memory. Each side owns its counter plus a cached copy of the 
+	other one, on a separate cache line to prevent false sharing. */
+
+	alignas(memory::ALIGNMENT) std::atomic<std::uint64_t> m_writePos;
+	std::uint64_t m_cachedReadPos; // Producer only
+
+	alignas(memory::ALIGNMENT) std::atomic<std::uint64_t> m_readPos;
+	mutable std::uint64_t m_cachedWritePos; // Consumer only
+};
+} // namespace mcl
+
+#endif
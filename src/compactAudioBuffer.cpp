@@ -0,0 +1,178 @@
+/* -----------------------------------------------------------------------------
+ *
+ * AudioBuffer
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2021 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of AudioBuffer.
+ *
+ * AudioBuffer is free software: you can redistribute it and/or modify it under 
+ * the terms of the GNU General Public License as published by the Free Software 
+ * Foundation, either version 3 of the License, or (at your option) any later 
+ * version.
+ *
+ * AudioBuffer is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS 
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more 
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with 
+ * AudioBuffer. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+#include "compactAudioBuffer.hpp"
+#include "kernels.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <type_traits>
+
+namespace mcl
+{
+static_assert(std::is_trivially_copyable_v<CompactAudioBufferView>);
+
+/* -------------------------------------------------------------------------- */
+
+CompactAudioBufferView::CompactAudioBufferView()
+: CompactAudioBufferView(nullptr, CompactFormat::INT16, 0, 0)
+{
+}
+
+/* -------------------------------------------------------------------------- */
+
+CompactAudioBufferView::CompactAudioBufferView(const std::uint16_t* data, CompactFormat format, int frames, int channels, float scale)
+: m_data(data)
+, m_format(format)
+, m_frames(frames)
+, m_channels(channels)
+, m_scale(scale)
+{
+	assert(frames >= 0);
+	assert(channels >= 0 && channels <= AudioBufferView::MAX_CHANS);
+}
+
+/* -------------------------------------------------------------------------- */
+
+const std::uint16_t* CompactAudioBufferView::getData() const { return m_data; }
+CompactFormat        CompactAudioBufferView::getFormat() const { return m_format; }
+int                  CompactAudioBufferView::countFrames() const { return m_frames; }
+int                  CompactAudioBufferView::countChannels() const { return m_channels; }
+float                CompactAudioBufferView::getScale() const { return m_scale; }
+bool                 CompactAudioBufferView::isEmpty() const { return m_frames == 0; }
+
+/* -------------------------------------------------------------------------- */
+
+float CompactAudioBufferView::get(int frame, int channel) const
+{
+	assert(frame >= 0 && frame < m_frames);
+	assert(channel >= 0 && channel < m_channels);
+
+	const std::uint16_t s = m_data[frame * m_channels + channel];
+	if (m_format == CompactFormat::FLOAT16)
+		return kernels::halfToFloat(s);
+	return static_cast<float>(static_cast<std::int16_t>(s)) * (m_scale / INT16_RANGE);
+}
+
+/* -------------------------------------------------------------------------- */
+
+CompactAudioBufferView CompactAudioBufferView::slice(int start, int count) const
+{
+	assert(start >= 0 && start <= m_frames);
+
+	if (count == -1)
+		count = m_frames - start;
+
+	assert(count >= 0 && start + count <= m_frames);
+
+	return {m_data + start * m_channels, m_format, count, m_channels, m_scale};
+}
+
+/* -------------------------------------------------------------------------- */
+
+CompactAudioBuffer::CompactAudioBuffer()
+: m_format(CompactFormat::INT16)
+, m_frames(0)
+, m_channels(0)
+, m_scale(1.0f)
+{
+}
+
+/* -------------------------------------------------------------------------- */
+
+CompactAudioBuffer::CompactAudioBuffer(AudioBufferView src, CompactFormat format)
+: m_data(static_cast<std::size_t>(src.countFrames()) * src.countChannels())
+, m_format(format)
+, m_frames(src.countFrames())
+, m_channels(src.countChannels())
+, m_scale(1.0f)
+{
+	const float*   in     = src.getData();
+	const int      stride = src.getStride();
+	std::uint16_t* out    = m_data.data();
+
+	if (format == CompactFormat::FLOAT16)
+	{
+		for (int i = 0; i < m_frames; i++, in += stride, out += m_channels)
+			for (int ch = 0; ch < m_channels; ch++)
+				out[ch] = kernels::floatToHalf(in[ch]);
+		return;
+	}
+
+	/* Non-finite samples are stored as 0 and left out of the scale: rescan 
+	the slow way only when the fast peak says there are some. */
+
+	float peak = 0.0f;
+	for (int ch = 0; ch < m_channels; ch++)
+		peak = std::max(peak, src.getPeak(ch));
+	if (!std::isfinite(peak))
+	{
+		peak = 0.0f;
+		for (int i = 0; i < m_frames; i++)
+			for (int ch = 0; ch < m_channels; ch++)
+				if (std::isfinite(in[i * stride + ch]))
+					peak = std::max(peak, std::fabs(in[i * stride + ch]));
+	}
+	if (peak > 0.0f)
+		m_scale = peak;
+
+	const float toInt = CompactAudioBufferView::INT16_RANGE / m_scale;
+	for (int i = 0; i < m_frames; i++, in += stride, out += m_channels)
+		for (int ch = 0; ch < m_channels; ch++)
+		{
+			const float s = std::isfinite(in[ch]) ? in[ch] : 0.0f;
+			const float v = std::clamp(s * toInt, -CompactAudioBufferView::INT16_RANGE, CompactAudioBufferView::INT16_RANGE);
+			out[ch]       = static_cast<std::uint16_t>(static_cast<std::int16_t>(std::lrint(v)));
+		}
+}
+
+/* -------------------------------------------------------------------------- */
+
+CompactAudioBufferView CompactAudioBuffer::view() const
+{
+	return {m_data.data(), m_format, m_frames, m_channels, m_scale};
+}
+
+CompactAudioBuffer::operator CompactAudioBufferView() const
+{
+	return view();
+}
+
+/* -------------------------------------------------------------------------- */
+
+CompactFormat CompactAudioBuffer::getFormat() const { return m_format; }
+int           CompactAudioBuffer::countFrames() const { return m_frames; }
+int           CompactAudioBuffer::countChannels() const { return m_channels; }
+float         CompactAudioBuffer::getScale() const { return m_scale; }
+bool          CompactAudioBuffer::isEmpty() const { return m_frames == 0; }
+
+/* -------------------------------------------------------------------------- */
+
+std::size_t CompactAudioBuffer::getBytes() const
+{
+	return m_data.size() * sizeof(std::uint16_t);
+}
+} // namespace mcl
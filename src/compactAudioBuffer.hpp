@@ -0,0 +1,149 @@
+/* -----------------------------------------------------------------------------
+ *
+ * AudioBuffer
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2021 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of AudioBuffer.
+ *
+ * AudioBuffer is free software: you can redistribute it and/or modify it under 
+ * the terms of the GNU General Public License as published by the Free Software 
+ * Foundation, either version 3 of the License, or (at your option) any later 
+ * version.
+ *
+ * AudioBuffer is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS 
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more 
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with 
+ * AudioBuffer. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+#ifndef MONOCASUAL_COMPACT_AUDIO_BUFFER_H
+#define MONOCASUAL_COMPACT_AUDIO_BUFFER_H
+
+#include "audioBufferView.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace mcl
+{
+/* CompactFormat
+16-bit storage formats for playback-only audio. INT16 stores integers relative
+to a per-buffer scale factor, usually the peak of the encoded audio, so that 
+quiet material uses the full integer range too. FLOAT16 stores IEEE 754 
+half-precision floats: less resolution on loud samples (11 bits of mantissa),
+much larger dynamic range. */
+
+enum class CompactFormat
+{
+	INT16,
+	FLOAT16
+};
+
+/* CompactAudioBufferView
+A non-owning, trivially copyable window over interleaved compact samples. 
+Frames are always packed. Pass it to AudioBufferView::sum() or set(), which 
+decode samples inside the mixing loop. */
+
+class CompactAudioBufferView
+{
+public:
+	/* INT16_RANGE
+	Integer value of a sample as loud as the scale factor. */
+
+	static constexpr float INT16_RANGE = 32767.0f;
+
+	/* CompactAudioBufferView (1)
+	Creates an empty view. */
+
+	CompactAudioBufferView();
+
+	/* CompactAudioBufferView (2)
+	Creates a view over 'frames' frames of 'channels' channels starting at 
+	'data'. For INT16 samples, 'scale' is the value of INT16_RANGE: sample 's'
+	stands for s * scale / INT16_RANGE. It's ignored for FLOAT16. */
+
+	CompactAudioBufferView(const std::uint16_t* data, CompactFormat format, int frames, int channels, float scale = 1.0f);
+
+	const std::uint16_t* getData() const;
+	CompactFormat        getFormat() const;
+	int                  countFrames() const;
+	int                  countChannels() const;
+	float                getScale() const;
+	bool                 isEmpty() const;
+
+	/* get
+	Returns the decoded value of a single sample. Meant for inspection, not for
+	processing: use AudioBufferView::sum() or set() for that. */
+
+	float get(int frame, int channel) const;
+
+	/* slice
+	Returns a view over 'count' frames starting at frame 'start'. If 'count' 
+	is -1 the slice extends to the end of this view. */
+
+	CompactAudioBufferView slice(int start, int count = -1) const;
+
+private:
+	const std::uint16_t* m_data;
+	CompactFormat        m_format;
+	int                  m_frames;
+	int                  m_channels;
+	float                m_scale;
+};
+
+/* CompactAudioBuffer
+Owns audio encoded in a CompactFormat, taking half the memory (and memory 
+bandwidth) of float samples. Meant for sample libraries and other material 
+that is only ever played back: encode once, then mix straight out of it 
+through view(). Encoding allocates and is not realtime safe. */
+
+class CompactAudioBuffer
+{
+public:
+	/* CompactAudioBuffer (1)
+	Creates an empty buffer. */
+
+	CompactAudioBuffer();
+
+	/* CompactAudioBuffer (2)
+	Encodes 'src' in 'format'. INT16 buffers take the peak of 'src' as scale
+	factor and store NaNs and infinities as 0. Samples are rounded to nearest;
+	FLOAT16 values beyond 65504 turn into infinities. */
+
+	CompactAudioBuffer(AudioBufferView src, CompactFormat format);
+
+	/* view, operator CompactAudioBufferView
+	Returns a view over the whole buffer. Views must not outlive the buffer. */
+
+	CompactAudioBufferView view() const;
+	operator CompactAudioBufferView() const;
+
+	CompactFormat getFormat() const;
+	int           countFrames() const;
+	int           countChannels() const;
+	float         getScale() const;
+	bool          isEmpty() const;
+
+	/* getBytes
+	Returns the amount of memory taken by the samples. */
+
+	std::size_t getBytes() const;
+
+private:
+	std::vector<std::uint16_t> m_data;
+	CompactFormat              m_format;
+	int                        m_frames;
+	int                        m_channels;
+	float                      m_scale;
+};
+} // namespace mcl
+
+#endif
@@ -0,0 +1,133 @@
+/* -----------------------------------------------------------------------------
+ *
+ * AudioBuffer
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2021 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of AudioBuffer.
+ *
+ * AudioBuffer is free software: you can redistribute it and/or modify it under 
+ * the terms of the GNU General Public License as published by the Free Software 
+ * Foundation, either version 3 of the License, or (at your option) any later 
+ * version.
+ *
+ * AudioBuffer is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS 
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more 
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with 
+ * AudioBuffer. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+#include "denormals.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define MCL_DENORMALS_X86
+#include <xmmintrin.h>
+#elif defined(__aarch64__) && (defined(__GNUC__) || defined(__clang__))
+#define MCL_DENORMALS_ARM64
+#endif
+
+namespace mcl::denormals
+{
+namespace
+{
+/* FLUSH_BITS
+Bits to set in the FPU control register: FTZ (15) and DAZ (6) in the SSE 
+MXCSR, FZ (24) in the ARM64 FPCR. The latter covers inputs as well. */
+
+#if defined(MCL_DENORMALS_X86)
+constexpr std::uint64_t FLUSH_BITS = 0x8040;
+#elif defined(MCL_DENORMALS_ARM64)
+constexpr std::uint64_t FLUSH_BITS = 1 << 24;
+#else
+constexpr std::uint64_t FLUSH_BITS = 0;
+#endif
+
+/* softwareFlushes
+The amount of SOFTWARE guards alive on the current thread. */
+
+thread_local int softwareFlushes = 0;
+
+/* -------------------------------------------------------------------------- */
+
+std::uint64_t getState()
+{
+#if defined(MCL_DENORMALS_X86)
+	return _mm_getcsr();
+#elif defined(MCL_DENORMALS_ARM64)
+	std::uint64_t fpcr;
+	asm volatile("mrs %0, fpcr" : "=r"(fpcr));
+	return fpcr;
+#else
+	return 0;
+#endif
+}
+
+/* -------------------------------------------------------------------------- */
+
+void setState([[maybe_unused]] std::uint64_t state)
+{
+#if defined(MCL_DENORMALS_X86)
+	_mm_setcsr(static_cast<unsigned int>(state));
+#elif defined(MCL_DENORMALS_ARM64)
+	asm volatile("msr fpcr, %0" : : "r"(state));
+#endif
+}
+} // namespace
+
+/* -------------------------------------------------------------------------- */
+
+bool isHardwareSupported()
+{
+	return FLUSH_BITS != 0;
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool isHardwareFlushEnabled()
+{
+	return isHardwareSupported() && (getState() & FLUSH_BITS) == FLUSH_BITS;
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool isSoftwareFlushEnabled()
+{
+	return softwareFlushes > 0;
+}
+
+/* -------------------------------------------------------------------------- */
+
+ScopedFlushToZero::ScopedFlushToZero(Mode mode)
+: m_mode(isHardwareSupported() ? mode : Mode::SOFTWARE)
+, m_previousState(0)
+{
+	if (m_mode == Mode::SOFTWARE)
+	{
+		softwareFlushes++;
+		return;
+	}
+	m_previousState = getState();
+	setState(m_previousState | FLUSH_BITS);
+}
+
+/* -------------------------------------------------------------------------- */
+
+ScopedFlushToZero::~ScopedFlushToZero()
+{
+	if (m_mode == Mode::SOFTWARE)
+		softwareFlushes--;
+	else
+		setState(m_previousState);
+}
+
+/* -------------------------------------------------------------------------- */
+
+Mode ScopedFlushToZero::getMode() const { return m_mode; }
+} // namespace mcl::denormals
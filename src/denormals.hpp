@@ -0,0 +1,95 @@
+/* -----------------------------------------------------------------------------
+ *
+ * AudioBuffer
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2021 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of AudioBuffer.
+ *
+ * AudioBuffer is free software: you can redistribute it and/or modify it under 
+ * the terms of the GNU General Public License as published by the Free Software 
+ * Foundation, either version 3 of the License, or (at your option) any later 
+ * version.
+ *
+ * AudioBuffer is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS 
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more 
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with 
+ * AudioBuffer. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+#ifndef MONOCASUAL_AUDIO_BUFFER_DENORMALS_H
+#define MONOCASUAL_AUDIO_BUFFER_DENORMALS_H
+
+#include <cstdint>
+
+/* Denormals
+Decaying signals (release tails, reverbs, long fade-outs) end up in the 
+subnormal range, where math on x86 CPUs becomes tens of times slower. The FPU
+can be told to flush subnormals to zero instead: that's per thread, so it has
+to be done on the audio thread, ideally once at the top of the callback. Where 
+the FPU mode can't be changed, AudioBufferView operations can flush their own
+results in software, which is cheaper than computing subnormals but still has
+to read the source ones. Guards don't follow work to other threads on their 
+own: the parallel operations re-establish the caller's protection in each 
+task, see parallel.hpp. */
+
+namespace mcl::denormals
+{
+/* Mode
+HARDWARE sets the flush-to-zero and denormals-are-zero bits of the FPU; 
+SOFTWARE makes AudioBufferView operations flush the samples they write. */
+
+enum class Mode
+{
+	HARDWARE,
+	SOFTWARE
+};
+
+/* isHardwareSupported
+Returns whether the FPU mode can be changed on this platform, i.e. x86 (SSE)
+and ARM64 builds. */
+
+bool isHardwareSupported();
+
+/* isHardwareFlushEnabled
+Returns whether the FPU of the calling thread flushes subnormals to zero, be 
+it through a guard in HARDWARE mode or not. */
+
+bool isHardwareFlushEnabled();
+
+/* isSoftwareFlushEnabled
+Returns whether a guard in SOFTWARE mode is alive on the calling thread. */
+
+bool isSoftwareFlushEnabled();
+
+/* ScopedFlushToZero
+RAII guard that enables denormal protection on the calling thread for its 
+lifetime and restores the previous state on destruction. Guards can be nested,
+and MUST be destroyed on the same thread that created them. Asking for 
+HARDWARE on a platform that doesn't support it falls back to SOFTWARE: check
+getMode() for the one actually in use. */
+
+class ScopedFlushToZero
+{
+public:
+	explicit ScopedFlushToZero(Mode mode = Mode::HARDWARE);
+	ScopedFlushToZero(const ScopedFlushToZero&)            = delete;
+	ScopedFlushToZero& operator=(const ScopedFlushToZero&) = delete;
+	~ScopedFlushToZero();
+
+	Mode getMode() const;
+
+private:
+	Mode          m_mode;
+	std::uint64_t m_previousState;
+};
+} // namespace mcl::denormals
+
+#endif
@@ -0,0 +1,253 @@
+/* -----------------------------------------------------------------------------
+ *
+ * AudioBuffer
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2021 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of AudioBuffer.
+ *
+ * AudioBuffer is free software: you can redistribute it and/or modify it under 
+ * the terms of the GNU General Public License as published by the Free Software 
+ * Foundation, either version 3 of the License, or (at your option) any later 
+ * version.
+ *
+ * AudioBuffer is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS 
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more 
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with 
+ * AudioBuffer. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+#ifndef MONOCASUAL_AUDIO_BUFFER_EXPRESSION_H
+#define MONOCASUAL_AUDIO_BUFFER_EXPRESSION_H
+
+#include "audioBufferView.hpp"
+#include "denormals.hpp"
+#include "instrumentation.hpp"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <concepts>
+#include <span>
+
+/* Expressions
+Lazily evaluated chains of operations over audio views, for example:
+
+	assign(dest, (src * gain) * fader + send * sendGain, peaks);
+
+Nothing is computed while building the expression. assign() and accumulate()
+then run the whole chain in a single loop: every destination sample is read 
+and written once, with no temporary buffers. The result is the same as calling
+set(), applyGain(), sum() and getPeak() one after the other. Expressions 
+refer to their sources through views: don't keep them around longer than the 
+sources. */
+
+namespace mcl
+{
+/* AudioExpression
+Anything that yields a sample for a given frame and channel. countFrames()
+is the amount of frames available, isCompatible() tells whether the 
+expression can be evaluated onto a destination with 'channels' channels. */
+
+template <typename T>
+concept AudioExpression = requires(const T& e, int frame, int channel) {
+	{ e.get(frame, channel) } -> std::same_as<float>;
+	{ e.countFrames() } -> std::same_as<int>;
+	{ e.isCompatible(channel) } -> std::same_as<bool>;
+};
+
+namespace expression
+{
+/* Term
+A source view scaled by gain * pan[ch], as in AudioBufferView::sum(). A mono 
+source is spread over all channels; otherwise its amount of channels MUST 
+match the destination. */
+
+class Term
+{
+public:
+	Term(AudioBufferView src, float gain = 1.0f, AudioBufferView::Pan pan = AudioBufferView::UNITY_PAN)
+	: m_data(src.getData())
+	, m_frames(src.countFrames())
+	, m_channels(src.countChannels())
+	, m_stride(src.getStride())
+	, m_channelStep(src.countChannels() == 1 ? 0 : 1)
+	{
+		for (int ch = 0; ch < AudioBufferView::MAX_CHANS; ch++)
+			m_gains[ch] = gain * pan[ch];
+	}
+
+	float get(int frame, int channel) const
+	{
+		return m_data[frame * m_stride + channel * m_channelStep] * m_gains[channel];
+	}
+
+	int  countFrames() const { return m_frames; }
+	bool isCompatible(int channels) const { return m_channels == 1 || m_channels == channels; }
+
+private:
+	const float*                                  m_data;
+	int                                           m_frames;
+	int                                           m_channels;
+	int                                           m_stride;
+	int                                           m_channelStep; // 0 for mono sources
+	std::array<float, AudioBufferView::MAX_CHANS> m_gains;
+};
+
+/* Sum
+The sum of two expressions. */
+
+template <AudioExpression L, AudioExpression R>
+class Sum
+{
+public:
+	Sum(L l, R r)
+	: m_l(l)
+	, m_r(r)
+	{
+	}
+
+	float get(int frame, int channel) const { return m_l.get(frame, channel) + m_r.get(frame, channel); }
+	int   countFrames() const { return std::min(m_l.countFrames(), m_r.countFrames()); }
+	bool  isCompatible(int channels) const { return m_l.isCompatible(channels) && m_r.isCompatible(channels); }
+
+private:
+	L m_l;
+	R m_r;
+};
+
+/* Scaled
+An expression multiplied by a gain, the lazy version of applyGain(). */
+
+template <AudioExpression E>
+class Scaled
+{
+public:
+	Scaled(E e, float gain)
+	: m_e(e)
+	, m_gain(gain)
+	{
+	}
+
+	float get(int frame, int channel) const { return m_e.get(frame, channel) * m_gain; }
+	int   countFrames() const { return m_e.countFrames(); }
+	bool  isCompatible(int channels) const { return m_e.isCompatible(channels); }
+
+private:
+	E     m_e;
+	float m_gain;
+};
+
+/* operator * (expression, gain)
+Scales a whole expression by 'g'. */
+
+template <AudioExpression E>
+Scaled<E> operator*(E e, float g) { return Scaled<E>(e, g); }
+
+/* operator + (expression, expression)
+Sums two expressions. */
+
+template <AudioExpression L, AudioExpression R>
+Sum<L, R> operator+(L l, R r) { return Sum<L, R>(l, r); }
+
+/* -------------------------------------------------------------------------- */
+
+/* evaluate
+The fused loop behind assign() and accumulate(). Metering and the amount of
+channels for mono and stereo destinations (Channels > 0) are fixed at compile
+time, so that the inner loop can be unrolled and vectorized. */
+
+template <bool Accumulate, bool Meter, int Channels, AudioExpression E>
+void evaluate(AudioBufferView dest, const E& expr, int frames, std::span<float> peaks)
+{
+	const int channels = Channels > 0 ? Channels : dest.countChannels();
+	const int stride   = dest.getStride();
+	float*    data     = dest.getData();
+
+	std::array<float, AudioBufferView::MAX_CHANS> peak{};
+
+	for (int i = 0; i < frames; i++)
+	{
+		float* frame = data + i * stride;
+		for (int ch = 0; ch < channels; ch++)
+		{
+			const float v = Accumulate ? frame[ch] + expr.get(i, ch) : expr.get(i, ch);
+			frame[ch]     = v;
+			if constexpr (Meter)
+				peak[ch] = std::max(peak[ch], std::fabs(v));
+		}
+	}
+
+	if constexpr (Meter)
+		std::copy_n(peak.begin(), channels, peaks.begin());
+}
+
+template <bool Accumulate, int Channels, AudioExpression E>
+void evaluate(AudioBufferView dest, const E& expr, int frames, std::span<float> peaks)
+{
+	if (peaks.empty())
+		evaluate<Accumulate, false, Channels>(dest, expr, frames, peaks);
+	else
+		evaluate<Accumulate, true, Channels>(dest, expr, frames, peaks);
+}
+
+template <bool Accumulate, AudioExpression E>
+void evaluate(AudioBufferView dest, const E& expr, std::span<float> peaks)
+{
+	assert(expr.isCompatible(dest.countChannels()));
+	assert(peaks.empty() || peaks.size() >= static_cast<std::size_t>(dest.countChannels()));
+
+	const int frames = std::min(dest.countFrames(), expr.countFrames());
+
+	MCL_INSTRUMENT_SCOPE(instrumentation::Operation::MIX, frames, frames * dest.countChannels() * sizeof(float));
+
+	if (dest.countChannels() == 1)
+		evaluate<Accumulate, 1>(dest, expr, frames, peaks);
+	else if (dest.countChannels() == 2)
+		evaluate<Accumulate, 2>(dest, expr, frames, peaks);
+	else
+		evaluate<Accumulate, 0>(dest, expr, frames, peaks);
+	if (denormals::isSoftwareFlushEnabled())
+		dest.slice(0, frames).flushDenormals();
+}
+} // namespace expression
+
+/* -------------------------------------------------------------------------- */
+
+/* operator * (view, gain)
+Starts an expression from a view, with gain 'g'. Use expression::Term 
+directly to pass a pan as well. */
+
+inline expression::Term operator*(AudioBufferView src, float g) { return expression::Term(src, g); }
+
+/* assign, accumulate
+Evaluate 'expr' onto 'dest': assign() overwrites it (like set()), 
+accumulate() adds to it (like sum()). The amount of frames processed is the 
+smallest between 'dest' and the sources. If 'peaks' is not empty it MUST hold
+at least dest.countChannels() elements: it is filled with the highest 
+absolute value of each channel over the frames written only, as getPeak() 
+would return on that part of 'dest'. Frames of 'dest' past the sources are 
+left out. A source may also be 'dest' itself, e.g. to apply a fader in place,
+only if it has the same layout. */
+
+template <AudioExpression E>
+void assign(AudioBufferView dest, const E& expr, std::span<float> peaks = {})
+{
+	expression::evaluate<false>(dest, expr, peaks);
+}
+
+template <AudioExpression E>
+void accumulate(AudioBufferView dest, const E& expr, std::span<float> peaks = {})
+{
+	expression::evaluate<true>(dest, expr, peaks);
+}
+} // namespace mcl
+
+#endif
@@ -0,0 +1,223 @@
+/* -----------------------------------------------------------------------------
+ *
+ * AudioBuffer
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2021 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of AudioBuffer.
+ *
+ * AudioBuffer is free software: you can redistribute it and/or modify it under 
+ * the terms of the GNU General Public License as published by the Free Software 
+ * Foundation, either version 3 of the License, or (at your option) any later 
+ * version.
+ *
+ * AudioBuffer is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS 
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more 
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with 
+ * AudioBuffer. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+#ifndef MONOCASUAL_FIXED_AUDIO_BUFFER_H
+#define MONOCASUAL_FIXED_AUDIO_BUFFER_H
+
+#include "audioBufferView.hpp"
+#include "denormals.hpp"
+#include "instrumentation.hpp"
+#include "memory.hpp"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+
+namespace mcl
+{
+/* FixedAudioBuffer
+An audio buffer whose size is known at compile time, meant for scratch blocks
+of a fixed length. Samples live inline, aligned to memory::ALIGNMENT: put it on
+the stack or inside another object, no memory is ever allocated. Operations 
+between fixed buffers of the same length run loops with constant trip counts 
+that the compiler can fully unroll and vectorize; everything else goes through
+the usual AudioBufferView kernels. Unlike AudioBuffer, no dirty range is 
+tracked. Denormals are flushed in SOFTWARE mode like in AudioBufferView, see 
+denormals::ScopedFlushToZero. */
+
+template <int Frames, int Channels>
+class FixedAudioBuffer
+{
+	static_assert(Frames > 0, "FixedAudioBuffer needs at least one frame");
+	static_assert(Channels > 0 && Channels <= AudioBufferView::MAX_CHANS, "Unsupported amount of channels");
+
+public:
+	static constexpr int FRAMES   = Frames;
+	static constexpr int CHANNELS = Channels;
+	static constexpr int SAMPLES  = Frames * Channels;
+
+	using Pan = AudioBufferView::Pan;
+
+	static constexpr Pan UNITY_PAN = AudioBufferView::UNITY_PAN;
+
+	/* FixedAudioBuffer
+	Creates a buffer with all samples set to 0.0f. */
+
+	FixedAudioBuffer()
+	: m_data{}
+	{
+	}
+
+	/* operator []
+	Given a frame 'offset', returns a pointer to it. See 
+	AudioBuffer::operator[]. */
+
+	float* operator[](int offset)
+	{
+		assert(offset >= 0 && offset < Frames);
+		return m_data.data() + offset * Channels;
+	}
+
+	const float* operator[](int offset) const
+	{
+		assert(offset >= 0 && offset < Frames);
+		return m_data.data() + offset * Channels;
+	}
+
+	/* view, operator AudioBufferView
+	Returns a non-owning view over the whole buffer. The const versions are 
+	meant for reading only, see AudioBufferView about shallow constness. */
+
+	AudioBufferView view() { return {m_data.data(), Frames, Channels}; }
+	AudioBufferView view() const { return {const_cast<float*>(m_data.data()), Frames, Channels}; }
+	operator AudioBufferView() { return view(); }
+	operator AudioBufferView() const { return view(); }
+
+	static constexpr int countFrames() { return Frames; }
+	static constexpr int countSamples() { return SAMPLES; }
+	static constexpr int countChannels() { return Channels; }
+
+	/* getPeak
+	Returns the highest absolute value from the specified channel. */
+
+	float getPeak(int channel) const
+	{
+		assert(channel >= 0 && channel < Channels);
+
+		float peak = 0.0f;
+		for (int i = 0; i < Frames; i++)
+			peak = std::max(peak, std::abs(m_data[i * Channels + channel]));
+		return peak;
+	}
+
+	/* sum, set (1)
+	Merges (sum) or copies (set) a fixed buffer of the same length. A mono 
+	source is spread over all channels, a source with the same channels is 
+	copied channel by channel, with compile-time loops in both cases. Other 
+	layouts are converted as described in AudioBufferView::sum(). */
+
+	template <int SrcChannels>
+	void sum(const FixedAudioBuffer<Frames, SrcChannels>& b, float gain = 1.0f, Pan pan = UNITY_PAN)
+	{
+		copyData<true>(b, gain, pan);
+	}
+
+	template <int SrcChannels>
+	void set(const FixedAudioBuffer<Frames, SrcChannels>& b, float gain = 1.0f, Pan pan = UNITY_PAN)
+	{
+		copyData<false>(b, gain, pan);
+	}
+
+	/* sum, set (2)
+	Same as sum, set (1) with any view as source, through the AudioBufferView
+	kernels. */
+
+	void sum(AudioBufferView b, float gain = 1.0f, Pan pan = UNITY_PAN) { view().sum(b, gain, pan); }
+	void set(AudioBufferView b, float gain = 1.0f, Pan pan = UNITY_PAN) { view().set(b, gain, pan); }
+
+	/* sum, set (3)
+	Same as sum, set (2) with gain and pan moving linearly across the buffer. 
+	See AudioBufferView::sum(AudioBufferView, Ramp<float>, Ramp<Pan>). */
+
+	void sum(AudioBufferView b, Ramp<float> gain, Ramp<Pan> pan = {UNITY_PAN, UNITY_PAN}) { view().sum(b, gain, pan); }
+	void set(AudioBufferView b, Ramp<float> gain, Ramp<Pan> pan = {UNITY_PAN, UNITY_PAN}) { view().set(b, gain, pan); }
+
+	/* clear
+	Sets all samples to 0.0f. Nothing to flush in SOFTWARE mode. */
+
+	void clear()
+	{
+		MCL_INSTRUMENT_SCOPE(instrumentation::Operation::CLEAR, Frames, SAMPLES * sizeof(float));
+		m_data.fill(0.0f);
+	}
+
+	/* applyGain (1)
+	Applies gain 'g' to all samples. */
+
+	void applyGain(float g)
+	{
+		MCL_INSTRUMENT_SCOPE(instrumentation::Operation::APPLY_GAIN, Frames, SAMPLES * sizeof(float));
+		for (float& s : m_data)
+			s *= g;
+		flushIfEnabled();
+	}
+
+	/* applyGain (2)
+	Applies a gain moving linearly from gain.start to gain.end across the whole
+	buffer. */
+
+	void applyGain(Ramp<float> gain) { view().applyGain(gain); }
+
+private:
+	template <bool Sum, int SrcChannels>
+	void copyData(const FixedAudioBuffer<Frames, SrcChannels>& b, float gain, const Pan& pan)
+	{
+		if constexpr (SrcChannels != 1 && SrcChannels != Channels)
+		{
+			if constexpr (Sum)
+				view().sum(b.view(), gain, pan);
+			else
+				view().set(b.view(), gain, pan);
+		}
+		else
+		{
+			MCL_INSTRUMENT_SCOPE(instrumentation::Operation::MIX, Frames, SAMPLES * sizeof(float));
+
+			std::array<float, Channels> gains;
+			for (int ch = 0; ch < Channels; ch++)
+				gains[ch] = gain * pan[ch];
+
+			constexpr int srcStep = SrcChannels == 1 ? 0 : 1;
+
+			const float* src = b[0];
+			for (int i = 0; i < Frames; i++)
+				for (int ch = 0; ch < Channels; ch++)
+				{
+					const float s = src[i * SrcChannels + ch * srcStep] * gains[ch];
+					if constexpr (Sum)
+						m_data[i * Channels + ch] += s;
+					else
+						m_data[i * Channels + ch] = s;
+				}
+			flushIfEnabled();
+		}
+	}
+
+	/* flushIfEnabled
+	Flushes denormals out of the whole buffer if the calling thread asked for 
+	it. Only the compile-time paths need it: the others go through views. */
+
+	void flushIfEnabled()
+	{
+		if (denormals::isSoftwareFlushEnabled())
+			view().flushDenormals();
+	}
+
+	alignas(memory::ALIGNMENT) std::array<float, SAMPLES> m_data;
+};
+} // namespace mcl
+
+#endif
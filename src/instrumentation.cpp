@@ -0,0 +1,154 @@
+/* -----------------------------------------------------------------------------
+ *
+ * AudioBuffer
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2021 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of AudioBuffer.
+ *
+ * AudioBuffer is free software: you can redistribute it and/or modify it under 
+ * the terms of the GNU General Public License as published by the Free Software 
+ * Foundation, either version 3 of the License, or (at your option) any later 
+ * version.
+ *
+ * AudioBuffer is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS 
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more 
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with 
+ * AudioBuffer. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+#include "instrumentation.hpp"
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+namespace mcl::instrumentation
+{
+namespace
+{
+/* ThreadCounters
+Counters of a single thread. Only the owner thread writes to them, so plain 
+atomic loads and stores are enough, with no read-modify-write. Blocks are never
+freed while the program runs, so that the numbers of threads that have exited
+are still part of the snapshots. */
+
+struct AtomicCounters
+{
+	std::atomic<std::uint64_t> calls       = 0;
+	std::atomic<std::uint64_t> frames      = 0;
+	std::atomic<std::uint64_t> bytes       = 0;
+	std::atomic<std::uint64_t> nanoseconds = 0;
+};
+
+struct ThreadCounters
+{
+	std::thread::id                            thread;
+	std::array<AtomicCounters, NUM_OPERATIONS> counters;
+};
+
+/* Registry
+All the ThreadCounters ever created. The lock is taken when a thread registers 
+and when taking snapshots, never while recording. */
+
+struct Registry
+{
+	std::mutex                                   mutex;
+	std::vector<std::unique_ptr<ThreadCounters>> threads;
+};
+
+Registry& getRegistry()
+{
+	static Registry registry;
+	return registry;
+}
+
+/* -------------------------------------------------------------------------- */
+
+ThreadCounters& getThreadCounters()
+{
+	thread_local ThreadCounters* counters = [] {
+		Registry&        registry = getRegistry();
+		std::scoped_lock lock(registry.mutex);
+
+		registry.threads.push_back(std::make_unique<ThreadCounters>());
+		registry.threads.back()->thread = std::this_thread::get_id();
+		return registry.threads.back().get();
+	}();
+	return *counters;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void add(std::atomic<std::uint64_t>& counter, std::uint64_t value)
+{
+	counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+} // namespace
+
+/* -------------------------------------------------------------------------- */
+
+Counters Snapshot::getTotal(Operation op) const
+{
+	Counters total;
+	for (const ThreadSnapshot& thread : threads)
+	{
+		const Counters& c = thread.get(op);
+		total.calls += c.calls;
+		total.frames += c.frames;
+		total.bytes += c.bytes;
+		total.nanoseconds += c.nanoseconds;
+	}
+	return total;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void registerThread()
+{
+	if constexpr (isEnabled())
+		getThreadCounters();
+}
+
+/* -------------------------------------------------------------------------- */
+
+Snapshot getSnapshot()
+{
+	Registry&        registry = getRegistry();
+	std::scoped_lock lock(registry.mutex);
+
+	Snapshot snapshot;
+	snapshot.threads.reserve(registry.threads.size());
+	for (const std::unique_ptr<ThreadCounters>& thread : registry.threads)
+	{
+		ThreadSnapshot& out = snapshot.threads.emplace_back();
+		out.thread          = thread->thread;
+		for (int i = 0; i < NUM_OPERATIONS; i++)
+		{
+			const AtomicCounters& in = thread->counters[i];
+			out.counters[i].calls       = in.calls.load(std::memory_order_relaxed);
+			out.counters[i].frames      = in.frames.load(std::memory_order_relaxed);
+			out.counters[i].bytes       = in.bytes.load(std::memory_order_relaxed);
+			out.counters[i].nanoseconds = in.nanoseconds.load(std::memory_order_relaxed);
+		}
+	}
+	return snapshot;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void record(Operation op, std::uint64_t frames, std::uint64_t bytes, std::uint64_t nanoseconds)
+{
+	AtomicCounters& c = getThreadCounters().counters[static_cast<int>(op)];
+	add(c.calls, 1);
+	add(c.frames, frames);
+	add(c.bytes, bytes);
+	add(c.nanoseconds, nanoseconds);
+}
+} // namespace mcl::instrumentation
@@ -0,0 +1,168 @@
+/* -----------------------------------------------------------------------------
+ *
+ * AudioBuffer
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2021 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of AudioBuffer.
+ *
+ * AudioBuffer is free software: you can redistribute it and/or modify it under 
+ * the terms of the GNU General Public License as published by the Free Software 
+ * Foundation, either version 3 of the License, or (at your option) any later 
+ * version.
+ *
+ * AudioBuffer is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS 
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more 
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with 
+ * AudioBuffer. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+#ifndef MONOCASUAL_AUDIO_BUFFER_INSTRUMENTATION_H
+#define MONOCASUAL_AUDIO_BUFFER_INSTRUMENTATION_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+/* MCL_INSTRUMENTATION
+Define it (e.g. -DMCL_INSTRUMENTATION) to enable instrumentation of the hot
+paths. When undefined, MCL_INSTRUMENT_SCOPE expands to nothing and the library
+carries no instrumentation code at all: the functions below still exist, but
+return empty snapshots. */
+
+#if defined(MCL_INSTRUMENTATION)
+#define MCL_INSTRUMENT_SCOPE(operation, frames, bytes) \
+	const mcl::instrumentation::Scope mclInstrumentScope(operation, frames, bytes)
+#else
+#define MCL_INSTRUMENT_SCOPE(operation, frames, bytes)
+#endif
+
+namespace mcl::instrumentation
+{
+/* Operation
+What is being measured. MIX covers all sum() and set() variants, ALLOC any 
+memory allocation (with 'bytes' allocated), COPY data copied from one buffer
+to another on copy construction, assignment or reallocation. Each call is 
+counted once, under the operation called: a ramping applyGain() is APPLY_GAIN
+only, even if it runs the MIX kernels. */
+
+enum class Operation
+{
+	MIX,
+	CLEAR,
+	APPLY_GAIN,
+	ALLOC,
+	COPY
+};
+
+constexpr int NUM_OPERATIONS = 5;
+
+/* Counters
+Totals for one operation. 'bytes' is the amount of memory written to, or 
+allocated for ALLOC. */
+
+struct Counters
+{
+	std::uint64_t calls       = 0;
+	std::uint64_t frames      = 0;
+	std::uint64_t bytes       = 0;
+	std::uint64_t nanoseconds = 0;
+};
+
+/* ThreadSnapshot
+Counters of a single thread, indexed by Operation. */
+
+struct ThreadSnapshot
+{
+	std::thread::id                      thread;
+	std::array<Counters, NUM_OPERATIONS> counters;
+
+	const Counters& get(Operation op) const { return counters[static_cast<int>(op)]; }
+};
+
+/* Snapshot
+Counters of every thread that ran instrumented code, since it first did. */
+
+struct Snapshot
+{
+	std::vector<ThreadSnapshot> threads;
+
+	/* getTotal
+	Returns the sum of 'op' counters across all threads. */
+
+	Counters getTotal(Operation op) const;
+};
+
+/* isEnabled
+Returns whether the library has been compiled with MCL_INSTRUMENTATION. */
+
+constexpr bool isEnabled()
+{
+#if defined(MCL_INSTRUMENTATION)
+	return true;
+#else
+	return false;
+#endif
+}
+
+/* registerThread
+Sets up the counters of the calling thread. It happens automatically on the 
+first instrumented call, but it takes a lock and allocates memory: call this
+from realtime threads before they start processing. */
+
+void registerThread();
+
+/* getSnapshot
+Returns the current value of all counters. Meant for a monitoring thread: it
+never blocks threads running instrumented code, which update their counters 
+without locks. Values of different counters may be a few updates apart. */
+
+Snapshot getSnapshot();
+
+/* record
+Adds one call to the counters of 'op' for the calling thread. */
+
+void record(Operation op, std::uint64_t frames, std::uint64_t bytes, std::uint64_t nanoseconds);
+
+/* Scope
+Records the operation being performed during its lifetime. Use it through
+MCL_INSTRUMENT_SCOPE, so that it vanishes when instrumentation is disabled. */
+
+class Scope
+{
+public:
+	Scope(Operation op, std::uint64_t frames, std::uint64_t bytes)
+	: m_op(op)
+	, m_frames(frames)
+	, m_bytes(bytes)
+	, m_start(std::chrono::steady_clock::now())
+	{
+	}
+
+	~Scope()
+	{
+		const auto elapsed = std::chrono::steady_clock::now() - m_start;
+		record(m_op, m_frames, m_bytes, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+	}
+
+	Scope(const Scope&)            = delete;
+	Scope& operator=(const Scope&) = delete;
+
+private:
+	Operation                             m_op;
+	std::uint64_t                         m_frames;
+	std::uint64_t                         m_bytes;
+	std::chrono::steady_clock::time_point m_start;
+};
+} // namespace mcl::instrumentation
+
+#endif
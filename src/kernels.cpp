@@ -0,0 +1,2064 @@
+/* -----------------------------------------------------------------------------
+ *
+ * AudioBuffer
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2021 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of AudioBuffer.
+ *
+ * AudioBuffer is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * AudioBuffer is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * AudioBuffer. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+#include "kernels.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <initializer_list>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define MCL_KERNELS_X86
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define MCL_KERNELS_NEON
+#include <arm_neon.h>
+#endif
+
+/* MCL_TARGET
+GCC and Clang refuse to emit intrinsics for instruction sets not enabled on the
+command line, unless the function is explicitly marked for that target. MSVC
+has no such restriction. */
+
+#if defined(__GNUC__) || defined(__clang__)
+#define MCL_TARGET(isa) __attribute__((target(isa)))
+#else
+#define MCL_TARGET(isa)
+#endif
+
+namespace mcl::kernels
+{
+namespace
+{
+enum class Operation
+{
+	SUM,
+	SET
+};
+
+/* -------------------------------------------------------------------------- */
+
+template <Operation O>
+inline void write(float& dest, float val)
+{
+	if constexpr (O == Operation::SUM)
+		dest += val;
+	else
+		dest = val;
+}
+
+/* -------------------------------------------------------------------------- */
+
+template <Operation O>
+void stereoScalar(float* dest, const float* src, int frames, float gainL, float gainR)
+{
+	for (int i = 0; i < frames; i++)
+	{
+		write<O>(dest[i * 2], src[i * 2] * gainL);
+		write<O>(dest[i * 2 + 1], src[i * 2 + 1] * gainR);
+	}
+}
+
+template <Operation O>
+void monoScalar(float* dest, const float* src, int frames, float gainL, float gainR)
+{
+	for (int i = 0; i < frames; i++)
+	{
+		write<O>(dest[i * 2], src[i] * gainL);
+		write<O>(dest[i * 2 + 1], src[i] * gainR);
+	}
+}
+
+/* stereoRampScalar, monoRampScalar
+Same as above, with gains moving linearly by 'stepL' and 'stepR' per frame. */
+
+template <Operation O>
+void stereoRampScalar(float* dest, const float* src, int frames, float gainL, float gainR, float stepL, float stepR)
+{
+	for (int i = 0; i < frames; i++)
+	{
+		const float t = static_cast<float>(i);
+		write<O>(dest[i * 2], src[i * 2] * (gainL + t * stepL));
+		write<O>(dest[i * 2 + 1], src[i * 2 + 1] * (gainR + t * stepR));
+	}
+}
+
+template <Operation O>
+void monoRampScalar(float* dest, const float* src, int frames, float gainL, float gainR, float stepL, float stepR)
+{
+	for (int i = 0; i < frames; i++)
+	{
+		const float t = static_cast<float>(i);
+		write<O>(dest[i * 2], src[i] * (gainL + t * stepL));
+		write<O>(dest[i * 2 + 1], src[i] * (gainR + t * stepR));
+	}
+}
+
+/* -------------------------------------------------------------------------- */
+
+void interleaveScalar(float* dest, const float* left, const float* right, int frames)
+{
+	for (int i = 0; i < frames; i++)
+	{
+		dest[i * 2]     = left[i];
+		dest[i * 2 + 1] = right[i];
+	}
+}
+
+void deinterleaveScalar(float* left, float* right, const float* src, int frames)
+{
+	for (int i = 0; i < frames; i++)
+	{
+		left[i]  = src[i * 2];
+		right[i] = src[i * 2 + 1];
+	}
+}
+
+template <Operation O>
+void downmixScalar(float* dest, const float* src, int frames, float gainL, float gainR)
+{
+	for (int i = 0; i < frames; i++)
+		write<O>(dest[i], src[i * 2] * gainL + src[i * 2 + 1] * gainR);
+}
+
+/* -------------------------------------------------------------------------- */
+
+/* ANALYSIS_BLOCK
+Vectorized analysis accumulates squares in single precision for at most this
+many samples, then flushes them into double precision accumulators. This keeps
+the RMS accurate on long buffers. */
+
+constexpr int ANALYSIS_BLOCK = 4096;
+
+void initStats(Stats* out, int channels)
+{
+	for (int ch = 0; ch < channels; ch++)
+		out[ch] = {FLT_MAX, -FLT_MAX, 0.0, 0};
+}
+
+/* accumulateStats
+Scalar analysis of the interleaved samples in range [begin, end). 'begin' must
+be the first sample of a frame. */
+
+void accumulateStats(const float* src, int begin, int end, int channels, float clipThreshold, Stats* out)
+{
+	for (int i = begin, ch = 0; i < end; i++, ch = ch + 1 == channels ? 0 : ch + 1)
+	{
+		const float v = src[i];
+		out[ch].min   = std::min(out[ch].min, v);
+		out[ch].max   = std::max(out[ch].max, v);
+		out[ch].sumSquares += static_cast<double>(v) * v;
+		out[ch].clipped += std::fabs(v) > clipThreshold ? 1 : 0;
+	}
+}
+
+/* foldLanes
+Merges the per-lane partial results of a vectorized analysis into the 
+per-channel ones. Lane 'i' holds samples of channel 'i % channels'. */
+
+void foldLanes(const float* mins, const float* maxs, const double* squares,
+    const int* clipped, int lanes, int channels, Stats* out)
+{
+	for (int i = 0; i < lanes; i++)
+	{
+		Stats& s = out[i % channels];
+		s.min    = std::min(s.min, mins[i]);
+		s.max    = std::max(s.max, maxs[i]);
+		s.sumSquares += squares[i];
+		s.clipped += clipped[i];
+	}
+}
+
+void analyzeScalar(const float* src, int frames, int channels, float clipThreshold, Stats* out)
+{
+	initStats(out, channels);
+	accumulateStats(src, 0, frames * channels, channels, clipThreshold, out);
+}
+
+/* -------------------------------------------------------------------------- */
+
+/* PCM conversions
+Integer formats map [-1.0, 1.0) onto the whole integer range. Encoders add 
+'dither' LSBs of TPDF noise before rounding, drawn from DITHER_LANES xorshift
+generators. Sample 'i' always uses generator 'i % DITHER_LANES', so that all
+instruction sets produce the exact same output. */
+
+constexpr float INT16_SCALE = 32768.0f;
+constexpr float INT16_LIMIT = 32767.0f;
+constexpr float INT24_SCALE = 8388608.0f;
+constexpr float INT24_LIMIT = 8388607.0f;
+constexpr float INT32_SCALE = 2147483648.0f;
+constexpr float INT32_LIMIT = 2147483520.0f; // Largest float below 2^31
+
+inline float nextUniform(std::uint32_t& x)
+{
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return std::bit_cast<float>((x >> 9) | 0x3F800000u) - 1.0f; // [0.0, 1.0)
+}
+
+inline std::int32_t quantize(float v, float scale, float limit, float dither, std::uint32_t& state)
+{
+	v *= scale;
+	if (dither != 0.0f)
+	{
+		const float a = nextUniform(state);
+		v += (a - nextUniform(state)) * dither;
+	}
+	return static_cast<std::int32_t>(std::lrint(std::clamp(v, -scale, limit)));
+}
+
+inline std::int32_t loadInt24(const unsigned char* p)
+{
+	const std::uint32_t u = p[0] | (p[1] << 8) | (p[2] << 16);
+	return static_cast<std::int32_t>(u << 8) >> 8; // Sign extension
+}
+
+inline void storeInt24(unsigned char* p, std::int32_t v)
+{
+	p[0] = static_cast<unsigned char>(v);
+	p[1] = static_cast<unsigned char>(v >> 8);
+	p[2] = static_cast<unsigned char>(v >> 16);
+}
+
+void decodeInt16Scalar(float* dest, const void* src, int samples)
+{
+	const std::int16_t* in = static_cast<const std::int16_t*>(src);
+	for (int i = 0; i < samples; i++)
+		dest[i] = static_cast<float>(in[i]) * (1.0f / INT16_SCALE);
+}
+
+void decodeInt24Scalar(float* dest, const void* src, int samples)
+{
+	const unsigned char* in = static_cast<const unsigned char*>(src);
+	for (int i = 0; i < samples; i++)
+		dest[i] = static_cast<float>(loadInt24(in + i * 3)) * (1.0f / INT24_SCALE);
+}
+
+void decodeInt32Scalar(float* dest, const void* src, int samples)
+{
+	const std::int32_t* in = static_cast<const std::int32_t*>(src);
+	for (int i = 0; i < samples; i++)
+		dest[i] = static_cast<float>(in[i]) * (1.0f / INT32_SCALE);
+}
+
+void decodeFloat64Scalar(float* dest, const void* src, int samples)
+{
+	const double* in = static_cast<const double*>(src);
+	for (int i = 0; i < samples; i++)
+		dest[i] = static_cast<float>(in[i]);
+}
+
+void encodeInt16Scalar(void* dest, const float* src, int samples, float dither, std::uint32_t* state)
+{
+	std::int16_t* out = static_cast<std::int16_t*>(dest);
+	for (int i = 0; i < samples; i++)
+		out[i] = static_cast<std::int16_t>(quantize(src[i], INT16_SCALE, INT16_LIMIT, dither, state[i % DITHER_LANES]));
+}
+
+void encodeInt24Scalar(void* dest, const float* src, int samples, float dither, std::uint32_t* state)
+{
+	unsigned char* out = static_cast<unsigned char*>(dest);
+	for (int i = 0; i < samples; i++)
+		storeInt24(out + i * 3, quantize(src[i], INT24_SCALE, INT24_LIMIT, dither, state[i % DITHER_LANES]));
+}
+
+void encodeInt32Scalar(void* dest, const float* src, int samples, float dither, std::uint32_t* state)
+{
+	std::int32_t* out = static_cast<std::int32_t*>(dest);
+	for (int i = 0; i < samples; i++)
+		out[i] = quantize(src[i], INT32_SCALE, INT32_LIMIT, dither, state[i % DITHER_LANES]);
+}
+
+void encodeFloat64Scalar(void* dest, const float* src, int samples, float /*dither*/, std::uint32_t* /*state*/)
+{
+	double* out = static_cast<double*>(dest);
+	for (int i = 0; i < samples; i++)
+		out[i] = static_cast<double>(src[i]);
+}
+
+/* -------------------------------------------------------------------------- */
+
+/* Compact formats
+16-bit samples decoded while mixing. Loops process sample pairs, so that the 
+even/odd gains stay in place when SIMD versions hand over the remainder. */
+
+template <Operation O>
+void int16Scalar(float* dest, const std::int16_t* src, int samples, float gainEven, float gainOdd)
+{
+	int i = 0;
+	for (; i + 2 <= samples; i += 2)
+	{
+		write<O>(dest[i], static_cast<float>(src[i]) * gainEven);
+		write<O>(dest[i + 1], static_cast<float>(src[i + 1]) * gainOdd);
+	}
+	if (i < samples)
+		write<O>(dest[i], static_cast<float>(src[i]) * gainEven);
+}
+
+template <Operation O>
+void halfScalar(float* dest, const std::uint16_t* src, int samples, float gainEven, float gainOdd)
+{
+	int i = 0;
+	for (; i + 2 <= samples; i += 2)
+	{
+		write<O>(dest[i], halfToFloat(src[i]) * gainEven);
+		write<O>(dest[i + 1], halfToFloat(src[i + 1]) * gainOdd);
+	}
+	if (i < samples)
+		write<O>(dest[i], halfToFloat(src[i]) * gainEven);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void envelopeScalar(float* dest, const float* src, int samples, const float* env)
+{
+	for (int i = 0; i < samples; i++)
+		dest[i] = src[i] * env[i];
+}
+
+void crossfadeScalar(float* dest, const float* a, const float* b, int samples, const float* envA, const float* envB)
+{
+	for (int i = 0; i < samples; i++)
+		dest[i] = a[i] * envA[i] + b[i] * envB[i];
+}
+
+/* -------------------------------------------------------------------------- */
+
+/* flushDenormalsScalar
+Works on the bit patterns: a float is subnormal if its exponent bits are all 
+zero, and integer operations don't suffer from the slowdown it's meant to 
+prevent. The sign is kept. */
+
+void flushDenormalsScalar(float* data, int samples)
+{
+	for (int i = 0; i < samples; i++)
+	{
+		const std::uint32_t bits = std::bit_cast<std::uint32_t>(data[i]);
+		if ((bits & 0x7F800000) == 0)
+			data[i] = std::bit_cast<float>(bits & 0x80000000);
+	}
+}
+
+/* -------------------------------------------------------------------------- */
+
+/* lerp, hermite
+Interpolate between 'x0' and 'x1' at fraction 't'. hermite() also takes the 
+outer neighbours 'xm1' and 'x2' (Catmull-Rom spline). */
+
+inline float lerp(float x0, float x1, float t)
+{
+	return x0 + (x1 - x0) * t;
+}
+
+inline float hermite(float xm1, float x0, float x1, float x2, float t)
+{
+	const float c1 = 0.5f * (x1 - xm1);
+	const float c2 = xm1 - 2.5f * x0 + 2.0f * x1 - 0.5f * x2;
+	const float c3 = 0.5f * (x2 - xm1) + 1.5f * (x0 - x1);
+	return ((c3 * t + c2) * t + c1) * t + x0;
+}
+
+/* resampleScalar
+Processes frames in range [begin, end), so that vectorized versions can reuse
+it for their tail and still compute the exact same positions. */
+
+template <bool Hermite>
+void resampleScalar(float* dest, const float* src, int srcFrames, int srcStride,
+    int channels, int begin, int end, double pos, double step)
+{
+	const int last = srcFrames - 1;
+	for (int i = begin; i < end; i++)
+	{
+		const double p   = pos + i * step;
+		const int    k   = static_cast<int>(p);
+		const float  t   = static_cast<float>(p - k);
+		const float* x0  = src + k * srcStride;
+		const float* x1  = src + std::min(k + 1, last) * srcStride;
+		float*       out = dest + i * channels;
+		if constexpr (Hermite)
+		{
+			const float* xm1 = src + std::max(k - 1, 0) * srcStride;
+			const float* x2  = src + std::min(k + 2, last) * srcStride;
+			for (int ch = 0; ch < channels; ch++)
+				out[ch] = hermite(xm1[ch], x0[ch], x1[ch], x2[ch], t);
+		}
+		else
+		{
+			for (int ch = 0; ch < channels; ch++)
+				out[ch] = lerp(x0[ch], x1[ch], t);
+		}
+	}
+}
+
+template <bool Hermite>
+void resampleScalar(float* dest, const float* src, int srcFrames, int srcStride,
+    int channels, int frames, double pos, double step)
+{
+	resampleScalar<Hermite>(dest, src, srcFrames, srcStride, channels, 0, frames, pos, step);
+}
+
+/* -------------------------------------------------------------------------- */
+
+#if defined(MCL_KERNELS_X86)
+
+template <Operation O>
+MCL_TARGET("sse2")
+inline void storeSse2(float* dest, __m128 val)
+{
+	if constexpr (O == Operation::SUM)
+		val = _mm_add_ps(_mm_loadu_ps(dest), val);
+	_mm_storeu_ps(dest, val);
+}
+
+template <Operation O>
+MCL_TARGET("sse2")
+void stereoSse2(float* dest, const float* src, int frames, float gainL, float gainR)
+{
+	const __m128 gains = _mm_setr_ps(gainL, gainR, gainL, gainR);
+
+	int i = 0;
+	for (; i + 2 <= frames; i += 2) // 2 stereo frames per step
+		storeSse2<O>(dest + i * 2, _mm_mul_ps(_mm_loadu_ps(src + i * 2), gains));
+
+	stereoScalar<O>(dest + i * 2, src + i * 2, frames - i, gainL, gainR);
+}
+
+template <Operation O>
+MCL_TARGET("sse2")
+void monoSse2(float* dest, const float* src, int frames, float gainL, float gainR)
+{
+	const __m128 gains = _mm_setr_ps(gainL, gainR, gainL, gainR);
+
+	int i = 0;
+	for (; i + 4 <= frames; i += 4) // 4 mono frames -> 4 stereo frames per step
+	{
+		const __m128 mono = _mm_loadu_ps(src + i);
+		storeSse2<O>(dest + i * 2, _mm_mul_ps(_mm_unpacklo_ps(mono, mono), gains));
+		storeSse2<O>(dest + i * 2 + 4, _mm_mul_ps(_mm_unpackhi_ps(mono, mono), gains));
+	}
+
+	monoScalar<O>(dest + i * 2, src + i, frames - i, gainL, gainR);
+}
+
+template <Operation O>
+MCL_TARGET("sse2")
+void stereoRampSse2(float* dest, const float* src, int frames, float gainL, float gainR, float stepL, float stepR)
+{
+	const __m128 start = _mm_setr_ps(gainL, gainR, gainL, gainR);
+	const __m128 step  = _mm_setr_ps(stepL, stepR, stepL, stepR);
+	const __m128 index = _mm_setr_ps(0.0f, 0.0f, 1.0f, 1.0f); // Frame index of each lane
+
+	int i = 0;
+	for (; i + 2 <= frames; i += 2)
+	{
+		const __m128 t     = _mm_add_ps(index, _mm_set1_ps(static_cast<float>(i)));
+		const __m128 gains = _mm_add_ps(start, _mm_mul_ps(t, step));
+		storeSse2<O>(dest + i * 2, _mm_mul_ps(_mm_loadu_ps(src + i * 2), gains));
+	}
+
+	const float t = static_cast<float>(i);
+	stereoRampScalar<O>(dest + i * 2, src + i * 2, frames - i, gainL + t * stepL, gainR + t * stepR, stepL, stepR);
+}
+
+template <Operation O>
+MCL_TARGET("sse2")
+void monoRampSse2(float* dest, const float* src, int frames, float gainL, float gainR, float stepL, float stepR)
+{
+	const __m128 start = _mm_setr_ps(gainL, gainR, gainL, gainR);
+	const __m128 step  = _mm_setr_ps(stepL, stepR, stepL, stepR);
+	const __m128 lo    = _mm_setr_ps(0.0f, 0.0f, 1.0f, 1.0f);
+	const __m128 hi    = _mm_setr_ps(2.0f, 2.0f, 3.0f, 3.0f);
+
+	int i = 0;
+	for (; i + 4 <= frames; i += 4)
+	{
+		const __m128 base = _mm_set1_ps(static_cast<float>(i));
+		const __m128 mono = _mm_loadu_ps(src + i);
+		const __m128 gLo  = _mm_add_ps(start, _mm_mul_ps(_mm_add_ps(base, lo), step));
+		const __m128 gHi  = _mm_add_ps(start, _mm_mul_ps(_mm_add_ps(base, hi), step));
+		storeSse2<O>(dest + i * 2, _mm_mul_ps(_mm_unpacklo_ps(mono, mono), gLo));
+		storeSse2<O>(dest + i * 2 + 4, _mm_mul_ps(_mm_unpackhi_ps(mono, mono), gHi));
+	}
+
+	const float t = static_cast<float>(i);
+	monoRampScalar<O>(dest + i * 2, src + i, frames - i, gainL + t * stepL, gainR + t * stepR, stepL, stepR);
+}
+
+MCL_TARGET("sse2")
+void interleaveSse2(float* dest, const float* left, const float* right, int frames)
+{
+	int i = 0;
+	for (; i + 4 <= frames; i += 4)
+	{
+		const __m128 l = _mm_loadu_ps(left + i);
+		const __m128 r = _mm_loadu_ps(right + i);
+		_mm_storeu_ps(dest + i * 2, _mm_unpacklo_ps(l, r));
+		_mm_storeu_ps(dest + i * 2 + 4, _mm_unpackhi_ps(l, r));
+	}
+
+	interleaveScalar(dest + i * 2, left + i, right + i, frames - i);
+}
+
+MCL_TARGET("sse2")
+void deinterleaveSse2(float* left, float* right, const float* src, int frames)
+{
+	int i = 0;
+	for (; i + 4 <= frames; i += 4)
+	{
+		const __m128 a = _mm_loadu_ps(src + i * 2);
+		const __m128 b = _mm_loadu_ps(src + i * 2 + 4);
+		_mm_storeu_ps(left + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+		_mm_storeu_ps(right + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+	}
+
+	deinterleaveScalar(left + i, right + i, src + i * 2, frames - i);
+}
+
+template <Operation O>
+MCL_TARGET("sse2")
+void downmixSse2(float* dest, const float* src, int frames, float gainL, float gainR)
+{
+	const __m128 gains = _mm_setr_ps(gainL, gainR, gainL, gainR);
+
+	int i = 0;
+	for (; i + 4 <= frames; i += 4) // 4 stereo frames -> 4 mono frames per step
+	{
+		const __m128 a = _mm_mul_ps(_mm_loadu_ps(src + i * 2), gains);
+		const __m128 b = _mm_mul_ps(_mm_loadu_ps(src + i * 2 + 4), gains);
+		const __m128 l = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+		const __m128 r = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+		storeSse2<O>(dest + i, _mm_add_ps(l, r));
+	}
+
+	downmixScalar<O>(dest + i, src + i * 2, frames - i, gainL, gainR);
+}
+
+MCL_TARGET("sse2")
+void analyzeSse2(const float* src, int frames, int channels, float clipThreshold, Stats* out)
+{
+	if (4 % channels != 0) // Channels must map evenly onto lanes
+		return analyzeScalar(src, frames, channels, clipThreshold, out);
+
+	const int    samples   = frames * channels;
+	const __m128 threshold = _mm_set1_ps(clipThreshold);
+	const __m128 absMask   = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+
+	__m128  mins    = _mm_set1_ps(FLT_MAX);
+	__m128  maxs    = _mm_set1_ps(-FLT_MAX);
+	__m128i clipped = _mm_setzero_si128();
+	double  squares[4] = {};
+
+	int i = 0;
+	while (i + 4 <= samples)
+	{
+		const int blockEnd = std::min(samples, i + ANALYSIS_BLOCK);
+		__m128    block    = _mm_setzero_ps();
+		for (; i + 4 <= blockEnd; i += 4)
+		{
+			const __m128 v = _mm_loadu_ps(src + i);
+			mins           = _mm_min_ps(mins, v);
+			maxs           = _mm_max_ps(maxs, v);
+			block          = _mm_add_ps(block, _mm_mul_ps(v, v));
+			clipped        = _mm_sub_epi32(clipped, _mm_castps_si128(_mm_cmpgt_ps(_mm_and_ps(v, absMask), threshold)));
+		}
+		float partial[4];
+		_mm_storeu_ps(partial, block);
+		for (int l = 0; l < 4; l++)
+			squares[l] += partial[l];
+	}
+
+	float minLanes[4], maxLanes[4];
+	int   clipLanes[4];
+	_mm_storeu_ps(minLanes, mins);
+	_mm_storeu_ps(maxLanes, maxs);
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(clipLanes), clipped);
+
+	initStats(out, channels);
+	foldLanes(minLanes, maxLanes, squares, clipLanes, 4, channels, out);
+	accumulateStats(src, i, samples, channels, clipThreshold, out);
+}
+
+/* -------------------------------------------------------------------------- */
+
+MCL_TARGET("sse2")
+inline __m128 nextUniformSse2(__m128i& x)
+{
+	x                  = _mm_xor_si128(x, _mm_slli_epi32(x, 13));
+	x                  = _mm_xor_si128(x, _mm_srli_epi32(x, 17));
+	x                  = _mm_xor_si128(x, _mm_slli_epi32(x, 5));
+	const __m128i bits = _mm_or_si128(_mm_srli_epi32(x, 9), _mm_set1_epi32(0x3F800000));
+	return _mm_sub_ps(_mm_castsi128_ps(bits), _mm_set1_ps(1.0f));
+}
+
+template <bool Dither>
+MCL_TARGET("sse2")
+inline __m128i quantizeSse2(__m128 v, float scale, float limit, float dither, __m128i& state)
+{
+	v = _mm_mul_ps(v, _mm_set1_ps(scale));
+	if constexpr (Dither)
+	{
+		const __m128 a = nextUniformSse2(state);
+		v              = _mm_add_ps(v, _mm_mul_ps(_mm_sub_ps(a, nextUniformSse2(state)), _mm_set1_ps(dither)));
+	}
+	v = _mm_min_ps(_mm_max_ps(v, _mm_set1_ps(-scale)), _mm_set1_ps(limit));
+	return _mm_cvtps_epi32(v); // Rounds to nearest even, same as lrint()
+}
+
+MCL_TARGET("sse2")
+void decodeInt16Sse2(float* dest, const void* src, int samples)
+{
+	const std::int16_t* in    = static_cast<const std::int16_t*>(src);
+	const __m128        scale = _mm_set1_ps(1.0f / INT16_SCALE);
+
+	int i = 0;
+	for (; i + 8 <= samples; i += 8)
+	{
+		const __m128i x  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+		const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16); // Sign extension
+		const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+		_mm_storeu_ps(dest + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+		_mm_storeu_ps(dest + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+	}
+
+	decodeInt16Scalar(dest + i, in + i, samples - i);
+}
+
+MCL_TARGET("sse2")
+void decodeInt32Sse2(float* dest, const void* src, int samples)
+{
+	const std::int32_t* in    = static_cast<const std::int32_t*>(src);
+	const __m128        scale = _mm_set1_ps(1.0f / INT32_SCALE);
+
+	int i = 0;
+	for (; i + 4 <= samples; i += 4)
+	{
+		const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+		_mm_storeu_ps(dest + i, _mm_mul_ps(_mm_cvtepi32_ps(x), scale));
+	}
+
+	decodeInt32Scalar(dest + i, in + i, samples - i);
+}
+
+MCL_TARGET("sse2")
+void decodeFloat64Sse2(float* dest, const void* src, int samples)
+{
+	const double* in = static_cast<const double*>(src);
+
+	int i = 0;
+	for (; i + 4 <= samples; i += 4)
+	{
+		const __m128 lo = _mm_cvtpd_ps(_mm_loadu_pd(in + i));
+		const __m128 hi = _mm_cvtpd_ps(_mm_loadu_pd(in + i + 2));
+		_mm_storeu_ps(dest + i, _mm_movelh_ps(lo, hi));
+	}
+
+	decodeFloat64Scalar(dest + i, in + i, samples - i);
+}
+
+template <bool Dither>
+MCL_TARGET("sse2")
+void encodeInt16Sse2(std::int16_t* out, const float* src, int samples, float dither, std::uint32_t* state)
+{
+	__m128i lanesLo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(state));
+	__m128i lanesHi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(state + 4));
+
+	int i = 0;
+	for (; i + 8 <= samples; i += 8)
+	{
+		const __m128i lo = quantizeSse2<Dither>(_mm_loadu_ps(src + i), INT16_SCALE, INT16_LIMIT, dither, lanesLo);
+		const __m128i hi = quantizeSse2<Dither>(_mm_loadu_ps(src + i + 4), INT16_SCALE, INT16_LIMIT, dither, lanesHi);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(lo, hi));
+	}
+
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(state), lanesLo);
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(state + 4), lanesHi);
+	encodeInt16Scalar(out + i, src + i, samples - i, dither, state);
+}
+
+template <bool Dither>
+MCL_TARGET("sse2")
+void encodeInt32Sse2(std::int32_t* out, const float* src, int samples, float dither, std::uint32_t* state)
+{
+	__m128i lanesLo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(state));
+	__m128i lanesHi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(state + 4));
+
+	int i = 0;
+	for (; i + 8 <= samples; i += 8)
+	{
+		const __m128i lo = quantizeSse2<Dither>(_mm_loadu_ps(src + i), INT32_SCALE, INT32_LIMIT, dither, lanesLo);
+		const __m128i hi = quantizeSse2<Dither>(_mm_loadu_ps(src + i + 4), INT32_SCALE, INT32_LIMIT, dither, lanesHi);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), lo);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 4), hi);
+	}
+
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(state), lanesLo);
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(state + 4), lanesHi);
+	encodeInt32Scalar(out + i, src + i, samples - i, dither, state);
+}
+
+void encodeInt16Sse2(void* dest, const float* src, int samples, float dither, std::uint32_t* state)
+{
+	std::int16_t* out = static_cast<std::int16_t*>(dest);
+	dither != 0.0f ? encodeInt16Sse2<true>(out, src, samples, dither, state) : encodeInt16Sse2<false>(out, src, samples, dither, state);
+}
+
+void encodeInt32Sse2(void* dest, const float* src, int samples, float dither, std::uint32_t* state)
+{
+	std::int32_t* out = static_cast<std::int32_t*>(dest);
+	dither != 0.0f ? encodeInt32Sse2<true>(out, src, samples, dither, state) : encodeInt32Sse2<false>(out, src, samples, dither, state);
+}
+
+MCL_TARGET("sse2")
+void encodeFloat64Sse2(void* dest, const float* src, int samples, float dither, std::uint32_t* state)
+{
+	double* out = static_cast<double*>(dest);
+
+	int i = 0;
+	for (; i + 4 <= samples; i += 4)
+	{
+		const __m128 v = _mm_loadu_ps(src + i);
+		_mm_storeu_pd(out + i, _mm_cvtps_pd(v));
+		_mm_storeu_pd(out + i + 2, _mm_cvtps_pd(_mm_movehl_ps(v, v)));
+	}
+
+	encodeFloat64Scalar(out + i, src + i, samples - i, dither, state);
+}
+
+/* -------------------------------------------------------------------------- */
+
+template <Operation O>
+MCL_TARGET("sse2")
+void int16Sse2(float* dest, const std::int16_t* src, int samples, float gainEven, float gainOdd)
+{
+	const __m128 gains = _mm_setr_ps(gainEven, gainOdd, gainEven, gainOdd);
+
+	int i = 0;
+	for (; i + 8 <= samples; i += 8)
+	{
+		const __m128i x  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+		const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16); // Sign extension
+		const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+		storeSse2<O>(dest + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), gains));
+		storeSse2<O>(dest + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), gains));
+	}
+
+	int16Scalar<O>(dest + i, src + i, samples - i, gainEven, gainOdd);
+}
+
+/* halfToFloatSse2
+Same bit manipulation as halfToFloat(), on 4 zero-extended samples. */
+
+MCL_TARGET("sse2")
+inline __m128 halfToFloatSse2(__m128i h)
+{
+	const __m128i expMask = _mm_set1_epi32(0x7C00 << 13);
+
+	const __m128i bits   = _mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(0x7FFF)), 13);
+	const __m128i exp    = _mm_and_si128(bits, expMask);
+	const __m128i infNan = _mm_cmpeq_epi32(exp, expMask);
+	const __m128i denorm = _mm_cmpeq_epi32(exp, _mm_setzero_si128());
+
+	__m128i    out  = _mm_add_epi32(bits, _mm_set1_epi32((127 - 15) << 23));
+	out             = _mm_add_epi32(out, _mm_and_si128(infNan, _mm_set1_epi32((128 - 16) << 23)));
+	const __m128 dn = _mm_sub_ps(_mm_castsi128_ps(_mm_add_epi32(out, _mm_set1_epi32(1 << 23))),
+	    _mm_castsi128_ps(_mm_set1_epi32(113 << 23)));
+
+	const __m128 f = _mm_or_ps(_mm_and_ps(_mm_castsi128_ps(denorm), dn), _mm_andnot_ps(_mm_castsi128_ps(denorm), _mm_castsi128_ps(out)));
+	return _mm_or_ps(f, _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(0x8000)), 16)));
+}
+
+template <Operation O>
+MCL_TARGET("sse2")
+void halfSse2(float* dest, const std::uint16_t* src, int samples, float gainEven, float gainOdd)
+{
+	const __m128  gains = _mm_setr_ps(gainEven, gainOdd, gainEven, gainOdd);
+	const __m128i zero  = _mm_setzero_si128();
+
+	int i = 0;
+	for (; i + 8 <= samples; i += 8)
+	{
+		const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+		storeSse2<O>(dest + i, _mm_mul_ps(halfToFloatSse2(_mm_unpacklo_epi16(x, zero)), gains));
+		storeSse2<O>(dest + i + 4, _mm_mul_ps(halfToFloatSse2(_mm_unpackhi_epi16(x, zero)), gains));
+	}
+
+	halfScalar<O>(dest + i, src + i, samples - i, gainEven, gainOdd);
+}
+
+/* -------------------------------------------------------------------------- */
+
+MCL_TARGET("sse2")
+void envelopeSse2(float* dest, const float* src, int samples, const float* env)
+{
+	int i = 0;
+	for (; i + 4 <= samples; i += 4)
+		_mm_storeu_ps(dest + i, _mm_mul_ps(_mm_loadu_ps(src + i), _mm_loadu_ps(env + i)));
+
+	envelopeScalar(dest + i, src + i, samples - i, env + i);
+}
+
+MCL_TARGET("sse2")
+void crossfadeSse2(float* dest, const float* a, const float* b, int samples, const float* envA, const float* envB)
+{
+	int i = 0;
+	for (; i + 4 <= samples; i += 4)
+	{
+		const __m128 x = _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(envA + i));
+		const __m128 y = _mm_mul_ps(_mm_loadu_ps(b + i), _mm_loadu_ps(envB + i));
+		_mm_storeu_ps(dest + i, _mm_add_ps(x, y));
+	}
+
+	crossfadeScalar(dest + i, a + i, b + i, samples - i, envA + i, envB + i);
+}
+
+MCL_TARGET("sse2")
+void flushDenormalsSse2(float* data, int samples)
+{
+	const __m128i exponent  = _mm_set1_epi32(0x7F800000);
+	const __m128i magnitude = _mm_set1_epi32(0x7FFFFFFF);
+
+	int i = 0;
+	for (; i + 4 <= samples; i += 4)
+	{
+		const __m128i bits = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+		const __m128i zero = _mm_cmpeq_epi32(_mm_and_si128(bits, exponent), _mm_setzero_si128());
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(data + i), _mm_andnot_si128(_mm_and_si128(zero, magnitude), bits));
+	}
+
+	flushDenormalsScalar(data + i, samples - i);
+}
+
+/* -------------------------------------------------------------------------- */
+
+template <Operation O>
+MCL_TARGET("avx2")
+inline void storeAvx2(float* dest, __m256 val)
+{
+	if constexpr (O == Operation::SUM)
+		val = _mm256_add_ps(_mm256_loadu_ps(dest), val);
+	_mm256_storeu_ps(dest, val);
+}
+
+template <Operation O>
+MCL_TARGET("avx2")
+void stereoAvx2(float* dest, const float* src, int frames, float gainL, float gainR)
+{
+	const __m256 gains = _mm256_setr_ps(gainL, gainR, gainL, gainR, gainL, gainR, gainL, gainR);
+
+	int i = 0;
+	for (; i + 8 <= frames; i += 8) // 8 stereo frames per step, two registers
+	{
+		storeAvx2<O>(dest + i * 2, _mm256_mul_ps(_mm256_loadu_ps(src + i * 2), gains));
+		storeAvx2<O>(dest + i * 2 + 8, _mm256_mul_ps(_mm256_loadu_ps(src + i * 2 + 8), gains));
+	}
+
+	stereoScalar<O>(dest + i * 2, src + i * 2, frames - i, gainL, gainR);
+}
+
+template <Operation O>
+MCL_TARGET("avx2")
+void monoAvx2(float* dest, const float* src, int frames, float gainL, float gainR)
+{
+	const __m256  gains = _mm256_setr_ps(gainL, gainR, gainL, gainR, gainL, gainR, gainL, gainR);
+	const __m256i lo    = _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3);
+	const __m256i hi    = _mm256_setr_epi32(4, 4, 5, 5, 6, 6, 7, 7);
+
+	int i = 0;
+	for (; i + 8 <= frames; i += 8) // 8 mono frames -> 8 stereo frames per step
+	{
+		const __m256 mono = _mm256_loadu_ps(src + i);
+		storeAvx2<O>(dest + i * 2, _mm256_mul_ps(_mm256_permutevar8x32_ps(mono, lo), gains));
+		storeAvx2<O>(dest + i * 2 + 8, _mm256_mul_ps(_mm256_permutevar8x32_ps(mono, hi), gains));
+	}
+
+	monoScalar<O>(dest + i * 2, src + i, frames - i, gainL, gainR);
+}
+
+template <Operation O>
+MCL_TARGET("avx2")
+void stereoRampAvx2(float* dest, const float* src, int frames, float gainL, float gainR, float stepL, float stepR)
+{
+	const __m256 start = _mm256_setr_ps(gainL, gainR, gainL, gainR, gainL, gainR, gainL, gainR);
+	const __m256 step  = _mm256_setr_ps(stepL, stepR, stepL, stepR, stepL, stepR, stepL, stepR);
+	const __m256 index = _mm256_setr_ps(0.0f, 0.0f, 1.0f, 1.0f, 2.0f, 2.0f, 3.0f, 3.0f);
+
+	int i = 0;
+	for (; i + 4 <= frames; i += 4) // 4 stereo frames per step
+	{
+		const __m256 t     = _mm256_add_ps(index, _mm256_set1_ps(static_cast<float>(i)));
+		const __m256 gains = _mm256_add_ps(start, _mm256_mul_ps(t, step));
+		storeAvx2<O>(dest + i * 2, _mm256_mul_ps(_mm256_loadu_ps(src + i * 2), gains));
+	}
+
+	const float t = static_cast<float>(i);
+	stereoRampScalar<O>(dest + i * 2, src + i * 2, frames - i, gainL + t * stepL, gainR + t * stepR, stepL, stepR);
+}
+
+template <Operation O>
+MCL_TARGET("avx2")
+void monoRampAvx2(float* dest, const float* src, int frames, float gainL, float gainR, float stepL, float stepR)
+{
+	const __m256  start = _mm256_setr_ps(gainL, gainR, gainL, gainR, gainL, gainR, gainL, gainR);
+	const __m256  step  = _mm256_setr_ps(stepL, stepR, stepL, stepR, stepL, stepR, stepL, stepR);
+	const __m256  lo    = _mm256_setr_ps(0.0f, 0.0f, 1.0f, 1.0f, 2.0f, 2.0f, 3.0f, 3.0f);
+	const __m256  hi    = _mm256_setr_ps(4.0f, 4.0f, 5.0f, 5.0f, 6.0f, 6.0f, 7.0f, 7.0f);
+	const __m256i dupLo = _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3);
+	const __m256i dupHi = _mm256_setr_epi32(4, 4, 5, 5, 6, 6, 7, 7);
+
+	int i = 0;
+	for (; i + 8 <= frames; i += 8)
+	{
+		const __m256 base = _mm256_set1_ps(static_cast<float>(i));
+		const __m256 mono = _mm256_loadu_ps(src + i);
+		const __m256 gLo  = _mm256_add_ps(start, _mm256_mul_ps(_mm256_add_ps(base, lo), step));
+		const __m256 gHi  = _mm256_add_ps(start, _mm256_mul_ps(_mm256_add_ps(base, hi), step));
+		storeAvx2<O>(dest + i * 2, _mm256_mul_ps(_mm256_permutevar8x32_ps(mono, dupLo), gLo));
+		storeAvx2<O>(dest + i * 2 + 8, _mm256_mul_ps(_mm256_permutevar8x32_ps(mono, dupHi), gHi));
+	}
+
+	const float t = static_cast<float>(i);
+	monoRampScalar<O>(dest + i * 2, src + i, frames - i, gainL + t * stepL, gainR + t * stepR, stepL, stepR);
+}
+
+MCL_TARGET("avx2")
+void interleaveAvx2(float* dest, const float* left, const float* right, int frames)
+{
+	int i = 0;
+	for (; i + 8 <= frames; i += 8)
+	{
+		const __m256 l  = _mm256_loadu_ps(left + i);
+		const __m256 r  = _mm256_loadu_ps(right + i);
+		const __m256 lo = _mm256_unpacklo_ps(l, r); // Frames 0, 1 | 4, 5
+		const __m256 hi = _mm256_unpackhi_ps(l, r); // Frames 2, 3 | 6, 7
+		_mm256_storeu_ps(dest + i * 2, _mm256_permute2f128_ps(lo, hi, 0x20));
+		_mm256_storeu_ps(dest + i * 2 + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+	}
+
+	interleaveScalar(dest + i * 2, left + i, right + i, frames - i);
+}
+
+MCL_TARGET("avx2")
+void deinterleaveAvx2(float* left, float* right, const float* src, int frames)
+{
+	int i = 0;
+	for (; i + 8 <= frames; i += 8)
+	{
+		const __m256 a = _mm256_loadu_ps(src + i * 2);
+		const __m256 b = _mm256_loadu_ps(src + i * 2 + 8);
+		const __m256 l = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)); // Frames 0, 1, 4, 5 | 2, 3, 6, 7
+		const __m256 r = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+		_mm256_storeu_ps(left + i, _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(l), _MM_SHUFFLE(3, 1, 2, 0))));
+		_mm256_storeu_ps(right + i, _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(r), _MM_SHUFFLE(3, 1, 2, 0))));
+	}
+
+	deinterleaveScalar(left + i, right + i, src + i * 2, frames - i);
+}
+
+template <Operation O>
+MCL_TARGET("avx2")
+void downmixAvx2(float* dest, const float* src, int frames, float gainL, float gainR)
+{
+	const __m256 gains = _mm256_setr_ps(gainL, gainR, gainL, gainR, gainL, gainR, gainL, gainR);
+
+	int i = 0;
+	for (; i + 8 <= frames; i += 8) // 8 stereo frames -> 8 mono frames per step
+	{
+		const __m256 a   = _mm256_mul_ps(_mm256_loadu_ps(src + i * 2), gains);
+		const __m256 b   = _mm256_mul_ps(_mm256_loadu_ps(src + i * 2 + 8), gains);
+		const __m256 l   = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)); // Frames 0, 1, 4, 5 | 2, 3, 6, 7
+		const __m256 r   = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+		const __m256 sum = _mm256_add_ps(l, r);
+		storeAvx2<O>(dest + i, _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(sum), _MM_SHUFFLE(3, 1, 2, 0))));
+	}
+
+	downmixScalar<O>(dest + i, src + i * 2, frames - i, gainL, gainR);
+}
+
+MCL_TARGET("avx2")
+void analyzeAvx2(const float* src, int frames, int channels, float clipThreshold, Stats* out)
+{
+	if (8 % channels != 0) // Channels must map evenly onto lanes
+		return analyzeScalar(src, frames, channels, clipThreshold, out);
+
+	const int    samples   = frames * channels;
+	const __m256 threshold = _mm256_set1_ps(clipThreshold);
+	const __m256 absMask   = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+
+	__m256  mins    = _mm256_set1_ps(FLT_MAX);
+	__m256  maxs    = _mm256_set1_ps(-FLT_MAX);
+	__m256i clipped = _mm256_setzero_si256();
+	double  squares[8] = {};
+
+	int i = 0;
+	while (i + 8 <= samples)
+	{
+		const int blockEnd = std::min(samples, i + ANALYSIS_BLOCK);
+		__m256    block    = _mm256_setzero_ps();
+		for (; i + 8 <= blockEnd; i += 8)
+		{
+			const __m256 v = _mm256_loadu_ps(src + i);
+			mins           = _mm256_min_ps(mins, v);
+			maxs           = _mm256_max_ps(maxs, v);
+			block          = _mm256_add_ps(block, _mm256_mul_ps(v, v));
+			clipped        = _mm256_sub_epi32(clipped, _mm256_castps_si256(_mm256_cmp_ps(_mm256_and_ps(v, absMask), threshold, _CMP_GT_OQ)));
+		}
+		float partial[8];
+		_mm256_storeu_ps(partial, block);
+		for (int l = 0; l < 8; l++)
+			squares[l] += partial[l];
+	}
+
+	float minLanes[8], maxLanes[8];
+	int   clipLanes[8];
+	_mm256_storeu_ps(minLanes, mins);
+	_mm256_storeu_ps(maxLanes, maxs);
+	_mm256_storeu_si256(reinterpret_cast<__m256i*>(clipLanes), clipped);
+
+	initStats(out, channels);
+	foldLanes(minLanes, maxLanes, squares, clipLanes, 8, channels, out);
+	accumulateStats(src, i, samples, channels, clipThreshold, out);
+}
+
+/* -------------------------------------------------------------------------- */
+
+MCL_TARGET("avx2")
+inline __m256 nextUniformAvx2(__m256i& x)
+{
+	x                  = _mm256_xor_si256(x, _mm256_slli_epi32(x, 13));
+	x                  = _mm256_xor_si256(x, _mm256_srli_epi32(x, 17));
+	x                  = _mm256_xor_si256(x, _mm256_slli_epi32(x, 5));
+	const __m256i bits = _mm256_or_si256(_mm256_srli_epi32(x, 9), _mm256_set1_epi32(0x3F800000));
+	return _mm256_sub_ps(_mm256_castsi256_ps(bits), _mm256_set1_ps(1.0f));
+}
+
+template <bool Dither>
+MCL_TARGET("avx2")
+inline __m256i quantizeAvx2(__m256 v, float scale, float limit, float dither, __m256i& state)
+{
+	v = _mm256_mul_ps(v, _mm256_set1_ps(scale));
+	if constexpr (Dither)
+	{
+		const __m256 a = nextUniformAvx2(state);
+		v              = _mm256_add_ps(v, _mm256_mul_ps(_mm256_sub_ps(a, nextUniformAvx2(state)), _mm256_set1_ps(dither)));
+	}
+	v = _mm256_min_ps(_mm256_max_ps(v, _mm256_set1_ps(-scale)), _mm256_set1_ps(limit));
+	return _mm256_cvtps_epi32(v);
+}
+
+MCL_TARGET("avx2")
+void decodeInt16Avx2(float* dest, const void* src, int samples)
+{
+	const std::int16_t* in    = static_cast<const std::int16_t*>(src);
+	const __m256        scale = _mm256_set1_ps(1.0f / INT16_SCALE);
+
+	int i = 0;
+	for (; i + 8 <= samples; i += 8)
+	{
+		const __m256i x = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)));
+		_mm256_storeu_ps(dest + i, _mm256_mul_ps(_mm256_cvtepi32_ps(x), scale));
+	}
+
+	decodeInt16Scalar(dest + i, in + i, samples - i);
+}
+
+MCL_TARGET("avx2")
+void decodeInt24Avx2(float* dest, const void* src, int samples)
+{
+	/* Each 128-bit lane loads 16 bytes and picks 4 samples of 3 bytes, placed
+	in the upper bytes of 32-bit integers; the arithmetic shift then extends
+	the sign. Lanes read 4 bytes past the 8 samples of each step: stop early 
+	enough not to read past the end of 'src'. */
+
+	const unsigned char* in    = static_cast<const unsigned char*>(src);
+	const __m256         scale = _mm256_set1_ps(1.0f / INT24_SCALE);
+	const __m256i        mask  = _mm256_setr_epi8(
+        -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11,
+        -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
+
+	int i = 0;
+	for (; i + 10 <= samples; i += 8)
+	{
+		const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i * 3));
+		const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i * 3 + 12));
+		const __m256i x  = _mm256_shuffle_epi8(_mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1), mask);
+		_mm256_storeu_ps(dest + i, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srai_epi32(x, 8)), scale));
+	}
+
+	decodeInt24Scalar(dest + i, in + i * 3, samples - i);
+}
+
+MCL_TARGET("avx2")
+void decodeInt32Avx2(float* dest, const void* src, int samples)
+{
+	const std::int32_t* in    = static_cast<const std::int32_t*>(src);
+	const __m256        scale = _mm256_set1_ps(1.0f / INT32_SCALE);
+
+	int i = 0;
+	for (; i + 8 <= samples; i += 8)
+	{
+		const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+		_mm256_storeu_ps(dest + i, _mm256_mul_ps(_mm256_cvtepi32_ps(x), scale));
+	}
+
+	decodeInt32Scalar(dest + i, in + i, samples - i);
+}
+
+MCL_TARGET("avx2")
+void decodeFloat64Avx2(float* dest, const void* src, int samples)
+{
+	const double* in = static_cast<const double*>(src);
+
+	int i = 0;
+	for (; i + 4 <= samples; i += 4)
+		_mm_storeu_ps(dest + i, _mm256_cvtpd_ps(_mm256_loadu_pd(in + i)));
+
+	decodeFloat64Scalar(dest + i, in + i, samples - i);
+}
+
+template <bool Dither>
+MCL_TARGET("avx2")
+void encodeInt16Avx2(std::int16_t* out, const float* src, int samples, float dither, std::uint32_t* state)
+{
+	__m256i lanes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(state));
+
+	int i = 0;
+	for (; i + 8 <= samples; i += 8)
+	{
+		const __m256i q = quantizeAvx2<Dither>(_mm256_loadu_ps(src + i), INT16_SCALE, INT16_LIMIT, dither, lanes);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+		    _mm_packs_epi32(_mm256_castsi256_si128(q), _mm256_extracti128_si256(q, 1)));
+	}
+
+	_mm256_storeu_si256(reinterpret_cast<__m256i*>(state), lanes);
+	encodeInt16Scalar(out + i, src + i, samples - i, dither, state);
+}
+
+template <bool Dither>
+MCL_TARGET("avx2")
+void encodeInt24Avx2(unsigned char* out, const float* src, int samples, float dither, std::uint32_t* state)
+{
+	/* The opposite of decodeInt24Avx2(): the 4 spare bytes written by the 
+	upper lane are overwritten by the next step, or by the scalar tail. */
+
+	const __m256i mask = _mm256_setr_epi8(
+	    0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+	    0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+
+	__m256i lanes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(state));
+
+	int i = 0;
+	for (; i + 10 <= samples; i += 8)
+	{
+		const __m256i q = quantizeAvx2<Dither>(_mm256_loadu_ps(src + i), INT24_SCALE, INT24_LIMIT, dither, lanes);
+		const __m256i p = _mm256_shuffle_epi8(q, mask);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 3), _mm256_castsi256_si128(p));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 3 + 12), _mm256_extracti128_si256(p, 1));
+	}
+
+	_mm256_storeu_si256(reinterpret_cast<__m256i*>(state), lanes);
+	encodeInt24Scalar(out + i * 3, src + i, samples - i, dither, state);
+}
+
+template <bool Dither>
+MCL_TARGET("avx2")
+void encodeInt32Avx2(std::int32_t* out, const float* src, int samples, float dither, std::uint32_t* state)
+{
+	__m256i lanes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(state));
+
+	int i = 0;
+	for (; i + 8 <= samples; i += 8)
+	{
+		const __m256i q = quantizeAvx2<Dither>(_mm256_loadu_ps(src + i), INT32_SCALE, INT32_LIMIT, dither, lanes);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), q);
+	}
+
+	_mm256_storeu_si256(reinterpret_cast<__m256i*>(state), lanes);
+	encodeInt32Scalar(out + i, src + i, samples - i, dither, state);
+}
+
+/* -------------------------------------------------------------------------- */
+
+template <Operation O>
+MCL_TARGET("avx2")
+void int16Avx2(float* dest, const std::int16_t* src, int samples, float gainEven, float gainOdd)
+{
+	const __m256 gains = _mm256_setr_ps(gainEven, gainOdd, gainEven, gainOdd, gainEven, gainOdd, gainEven, gainOdd);
+
+	int i = 0;
+	for (; i + 16 <= samples; i += 16) // Two registers per step
+	{
+		const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+		const __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 8));
+		storeAvx2<O>(dest + i, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(x)), gains));
+		storeAvx2<O>(dest + i + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(y)), gains));
+	}
+
+	int16Scalar<O>(dest + i, src + i, samples - i, gainEven, gainOdd);
+}
+
+template <Operation O>
+MCL_TARGET("avx2,f16c")
+void halfAvx2(float* dest, const std::uint16_t* src, int samples, float gainEven, float gainOdd)
+{
+	const __m256 gains = _mm256_setr_ps(gainEven, gainOdd, gainEven, gainOdd, gainEven, gainOdd, gainEven, gainOdd);
+
+	int i = 0;
+	for (; i + 16 <= samples; i += 16) // Two registers per step
+	{
+		const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+		const __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 8));
+		storeAvx2<O>(dest + i, _mm256_mul_ps(_mm256_cvtph_ps(x), gains));
+		storeAvx2<O>(dest + i + 8, _mm256_mul_ps(_mm256_cvtph_ps(y), gains));
+	}
+
+	halfScalar<O>(dest + i, src + i, samples - i, gainEven, gainOdd);
+}
+
+/* -------------------------------------------------------------------------- */
+
+MCL_TARGET("avx2")
+void envelopeAvx2(float* dest, const float* src, int samples, const float* env)
+{
+	int i = 0;
+	for (; i + 8 <= samples; i += 8)
+		_mm256_storeu_ps(dest + i, _mm256_mul_ps(_mm256_loadu_ps(src + i), _mm256_loadu_ps(env + i)));
+
+	envelopeScalar(dest + i, src + i, samples - i, env + i);
+}
+
+MCL_TARGET("avx2")
+void crossfadeAvx2(float* dest, const float* a, const float* b, int samples, const float* envA, const float* envB)
+{
+	int i = 0;
+	for (; i + 8 <= samples; i += 8)
+	{
+		const __m256 x = _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(envA + i));
+		const __m256 y = _mm256_mul_ps(_mm256_loadu_ps(b + i), _mm256_loadu_ps(envB + i));
+		_mm256_storeu_ps(dest + i, _mm256_add_ps(x, y));
+	}
+
+	crossfadeScalar(dest + i, a + i, b + i, samples - i, envA + i, envB + i);
+}
+
+MCL_TARGET("avx2")
+void flushDenormalsAvx2(float* data, int samples)
+{
+	const __m256i exponent  = _mm256_set1_epi32(0x7F800000);
+	const __m256i magnitude = _mm256_set1_epi32(0x7FFFFFFF);
+
+	int i = 0;
+	for (; i + 8 <= samples; i += 8)
+	{
+		const __m256i bits = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+		const __m256i zero = _mm256_cmpeq_epi32(_mm256_and_si256(bits, exponent), _mm256_setzero_si256());
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(data + i), _mm256_andnot_si256(_mm256_and_si256(zero, magnitude), bits));
+	}
+
+	flushDenormalsScalar(data + i, samples - i);
+}
+
+/* -------------------------------------------------------------------------- */
+
+/* Resampling
+Positions are computed in double precision, 4 frames per step, then source 
+frames are fetched with gathers. Same operations, in the same order, as the
+scalar versions. */
+
+MCL_TARGET("avx2")
+inline __m128 lerpAvx2(__m128 x0, __m128 x1, __m128 t)
+{
+	return _mm_add_ps(x0, _mm_mul_ps(_mm_sub_ps(x1, x0), t));
+}
+
+MCL_TARGET("avx2")
+inline __m128 hermiteAvx2(__m128 xm1, __m128 x0, __m128 x1, __m128 x2, __m128 t)
+{
+	const __m128 c1 = _mm_mul_ps(_mm_set1_ps(0.5f), _mm_sub_ps(x1, xm1));
+	const __m128 c2 = _mm_sub_ps(_mm_add_ps(_mm_sub_ps(xm1, _mm_mul_ps(_mm_set1_ps(2.5f), x0)), _mm_mul_ps(_mm_set1_ps(2.0f), x1)),
+	    _mm_mul_ps(_mm_set1_ps(0.5f), x2));
+	const __m128 c3 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(0.5f), _mm_sub_ps(x2, xm1)), _mm_mul_ps(_mm_set1_ps(1.5f), _mm_sub_ps(x0, x1)));
+	return _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(c3, t), c2), t), c1), t), x0);
+}
+
+template <bool Hermite>
+MCL_TARGET("avx2")
+void resampleAvx2(float* dest, const float* src, int srcFrames, int srcStride,
+    int channels, int frames, double pos, double step)
+{
+	if (srcStride != channels || channels > 2)
+		return resampleScalar<Hermite>(dest, src, srcFrames, srcStride, channels, 0, frames, pos, step);
+
+	const __m256d lanes  = _mm256_setr_pd(0.0, 1.0, 2.0, 3.0);
+	const __m256d vpos   = _mm256_set1_pd(pos);
+	const __m256d vstep  = _mm256_set1_pd(step);
+	const __m128i zero   = _mm_setzero_si128();
+	const __m128i one    = _mm_set1_epi32(1);
+	const __m128i last   = _mm_set1_epi32(srcFrames - 1);
+	const __m128i stride = _mm_set1_epi32(channels);
+
+	int i = 0;
+	for (; i + 4 <= frames; i += 4)
+	{
+		const __m256d p  = _mm256_add_pd(vpos, _mm256_mul_pd(_mm256_add_pd(_mm256_set1_pd(i), lanes), vstep));
+		const __m128i k  = _mm256_cvttpd_epi32(p);
+		const __m128  t  = _mm256_cvtpd_ps(_mm256_sub_pd(p, _mm256_cvtepi32_pd(k)));
+		const __m128i k1 = _mm_min_epi32(_mm_add_epi32(k, one), last);
+
+		/* Sample offsets of the frames involved, per lane. */
+
+		const __m128i o0 = _mm_mullo_epi32(k, stride);
+		const __m128i o1 = _mm_mullo_epi32(k1, stride);
+		__m128i       om1 = zero, o2 = zero;
+		if constexpr (Hermite)
+		{
+			om1 = _mm_mullo_epi32(_mm_max_epi32(_mm_sub_epi32(k, one), zero), stride);
+			o2  = _mm_mullo_epi32(_mm_min_epi32(_mm_add_epi32(k1, one), last), stride);
+		}
+
+		__m128 out[2];
+		for (int ch = 0; ch < channels; ch++)
+		{
+			const float* base = src + ch;
+			const __m128 x0   = _mm_i32gather_ps(base, o0, 4);
+			const __m128 x1   = _mm_i32gather_ps(base, o1, 4);
+			if constexpr (Hermite)
+				out[ch] = hermiteAvx2(_mm_i32gather_ps(base, om1, 4), x0, x1, _mm_i32gather_ps(base, o2, 4), t);
+			else
+				out[ch] = lerpAvx2(x0, x1, t);
+		}
+
+		if (channels == 1)
+		{
+			_mm_storeu_ps(dest + i, out[0]);
+		}
+		else
+		{
+			_mm_storeu_ps(dest + i * 2, _mm_unpacklo_ps(out[0], out[1]));
+			_mm_storeu_ps(dest + i * 2 + 4, _mm_unpackhi_ps(out[0], out[1]));
+		}
+	}
+
+	resampleScalar<Hermite>(dest, src, srcFrames, srcStride, channels, i, frames, pos, step);
+}
+
+void encodeInt16Avx2(void* dest, const float* src, int samples, float dither, std::uint32_t* state)
+{
+	std::int16_t* out = static_cast<std::int16_t*>(dest);
+	dither != 0.0f ? encodeInt16Avx2<true>(out, src, samples, dither, state) : encodeInt16Avx2<false>(out, src, samples, dither, state);
+}
+
+void encodeInt24Avx2(void* dest, const float* src, int samples, float dither, std::uint32_t* state)
+{
+	unsigned char* out = static_cast<unsigned char*>(dest);
+	dither != 0.0f ? encodeInt24Avx2<true>(out, src, samples, dither, state) : encodeInt24Avx2<false>(out, src, samples, dither, state);
+}
+
+void encodeInt32Avx2(void* dest, const float* src, int samples, float dither, std::uint32_t* state)
+{
+	std::int32_t* out = static_cast<std::int32_t*>(dest);
+	dither != 0.0f ? encodeInt32Avx2<true>(out, src, samples, dither, state) : encodeInt32Avx2<false>(out, src, samples, dither, state);
+}
+
+MCL_TARGET("avx2")
+void encodeFloat64Avx2(void* dest, const float* src, int samples, float dither, std::uint32_t* state)
+{
+	double* out = static_cast<double*>(dest);
+
+	int i = 0;
+	for (; i + 4 <= samples; i += 4)
+		_mm256_storeu_pd(out + i, _mm256_cvtps_pd(_mm_loadu_ps(src + i)));
+
+	encodeFloat64Scalar(out + i, src + i, samples - i, dither, state);
+}
+
+#endif // MCL_KERNELS_X86
+
+/* -------------------------------------------------------------------------- */
+
+#if defined(MCL_KERNELS_NEON)
+
+template <Operation O>
+inline void storeNeon(float* dest, float32x4_t val)
+{
+	if constexpr (O == Operation::SUM)
+		val = vaddq_f32(vld1q_f32(dest), val);
+	vst1q_f32(dest, val);
+}
+
+template <Operation O>
+void stereoNeon(float* dest, const float* src, int frames, float gainL, float gainR)
+{
+	const float       g[4]  = {gainL, gainR, gainL, gainR};
+	const float32x4_t gains = vld1q_f32(g);
+
+	int i = 0;
+	for (; i + 4 <= frames; i += 4) // 4 stereo frames per step, two registers
+	{
+		storeNeon<O>(dest + i * 2, vmulq_f32(vld1q_f32(src + i * 2), gains));
+		storeNeon<O>(dest + i * 2 + 4, vmulq_f32(vld1q_f32(src + i * 2 + 4), gains));
+	}
+
+	stereoScalar<O>(dest + i * 2, src + i * 2, frames - i, gainL, gainR);
+}
+
+template <Operation O>
+void monoNeon(float* dest, const float* src, int frames, float gainL, float gainR)
+{
+	const float       g[4]  = {gainL, gainR, gainL, gainR};
+	const float32x4_t gains = vld1q_f32(g);
+
+	int i = 0;
+	for (; i + 4 <= frames; i += 4) // 4 mono frames -> 4 stereo frames per step
+	{
+		const float32x4_t   mono = vld1q_f32(src + i);
+		const float32x4x2_t zip  = vzipq_f32(mono, mono);
+		storeNeon<O>(dest + i * 2, vmulq_f32(zip.val[0], gains));
+		storeNeon<O>(dest + i * 2 + 4, vmulq_f32(zip.val[1], gains));
+	}
+
+	monoScalar<O>(dest + i * 2, src + i, frames - i, gainL, gainR);
+}
+
+template <Operation O>
+void stereoRampNeon(float* dest, const float* src, int frames, float gainL, float gainR, float stepL, float stepR)
+{
+	const float       g[4]  = {gainL, gainR, gainL, gainR};
+	const float       d[4]  = {stepL, stepR, stepL, stepR};
+	const float       x[4]  = {0.0f, 0.0f, 1.0f, 1.0f};
+	const float32x4_t start = vld1q_f32(g);
+	const float32x4_t step  = vld1q_f32(d);
+	const float32x4_t index = vld1q_f32(x);
+
+	int i = 0;
+	for (; i + 2 <= frames; i += 2)
+	{
+		const float32x4_t t     = vaddq_f32(index, vdupq_n_f32(static_cast<float>(i)));
+		const float32x4_t gains = vaddq_f32(start, vmulq_f32(t, step));
+		storeNeon<O>(dest + i * 2, vmulq_f32(vld1q_f32(src + i * 2), gains));
+	}
+
+	const float t = static_cast<float>(i);
+	stereoRampScalar<O>(dest + i * 2, src + i * 2, frames - i, gainL + t * stepL, gainR + t * stepR, stepL, stepR);
+}
+
+template <Operation O>
+void monoRampNeon(float* dest, const float* src, int frames, float gainL, float gainR, float stepL, float stepR)
+{
+	const float       g[4]  = {gainL, gainR, gainL, gainR};
+	const float       d[4]  = {stepL, stepR, stepL, stepR};
+	const float       x[4]  = {0.0f, 0.0f, 1.0f, 1.0f};
+	const float32x4_t start = vld1q_f32(g);
+	const float32x4_t step  = vld1q_f32(d);
+	const float32x4_t lo    = vld1q_f32(x);
+	const float32x4_t hi    = vaddq_f32(lo, vdupq_n_f32(2.0f));
+
+	int i = 0;
+	for (; i + 4 <= frames; i += 4)
+	{
+		const float32x4_t   base = vdupq_n_f32(static_cast<float>(i));
+		const float32x4_t   mono = vld1q_f32(src + i);
+		const float32x4x2_t zip  = vzipq_f32(mono, mono);
+		const float32x4_t   gLo  = vaddq_f32(start, vmulq_f32(vaddq_f32(base, lo), step));
+		const float32x4_t   gHi  = vaddq_f32(start, vmulq_f32(vaddq_f32(base, hi), step));
+		storeNeon<O>(dest + i * 2, vmulq_f32(zip.val[0], gLo));
+		storeNeon<O>(dest + i * 2 + 4, vmulq_f32(zip.val[1], gHi));
+	}
+
+	const float t = static_cast<float>(i);
+	monoRampScalar<O>(dest + i * 2, src + i, frames - i, gainL + t * stepL, gainR + t * stepR, stepL, stepR);
+}
+
+void interleaveNeon(float* dest, const float* left, const float* right, int frames)
+{
+	int i = 0;
+	for (; i + 4 <= frames; i += 4)
+	{
+		float32x4x2_t lr;
+		lr.val[0] = vld1q_f32(left + i);
+		lr.val[1] = vld1q_f32(right + i);
+		vst2q_f32(dest + i * 2, lr);
+	}
+
+	interleaveScalar(dest + i * 2, left + i, right + i, frames - i);
+}
+
+void deinterleaveNeon(float* left, float* right, const float* src, int frames)
+{
+	int i = 0;
+	for (; i + 4 <= frames; i += 4)
+	{
+		const float32x4x2_t lr = vld2q_f32(src + i * 2);
+		vst1q_f32(left + i, lr.val[0]);
+		vst1q_f32(right + i, lr.val[1]);
+	}
+
+	deinterleaveScalar(left + i, right + i, src + i * 2, frames - i);
+}
+
+template <Operation O>
+void downmixNeon(float* dest, const float* src, int frames, float gainL, float gainR)
+{
+	int i = 0;
+	for (; i + 4 <= frames; i += 4)
+	{
+		const float32x4x2_t lr = vld2q_f32(src + i * 2);
+		storeNeon<O>(dest + i, vmlaq_n_f32(vmulq_n_f32(lr.val[0], gainL), lr.val[1], gainR));
+	}
+
+	downmixScalar<O>(dest + i, src + i * 2, frames - i, gainL, gainR);
+}
+
+void analyzeNeon(const float* src, int frames, int channels, float clipThreshold, Stats* out)
+{
+	if (4 % channels != 0) // Channels must map evenly onto lanes
+		return analyzeScalar(src, frames, channels, clipThreshold, out);
+
+	const int         samples   = frames * channels;
+	const float32x4_t threshold = vdupq_n_f32(clipThreshold);
+
+	float32x4_t mins    = vdupq_n_f32(FLT_MAX);
+	float32x4_t maxs    = vdupq_n_f32(-FLT_MAX);
+	uint32x4_t  clipped = vdupq_n_u32(0);
+	double      squares[4] = {};
+
+	int i = 0;
+	while (i + 4 <= samples)
+	{
+		const int   blockEnd = std::min(samples, i + ANALYSIS_BLOCK);
+		float32x4_t block    = vdupq_n_f32(0.0f);
+		for (; i + 4 <= blockEnd; i += 4)
+		{
+			const float32x4_t v = vld1q_f32(src + i);
+			mins                = vminq_f32(mins, v);
+			maxs                = vmaxq_f32(maxs, v);
+			block               = vaddq_f32(block, vmulq_f32(v, v));
+			clipped             = vsubq_u32(clipped, vcgtq_f32(vabsq_f32(v), threshold));
+		}
+		float partial[4];
+		vst1q_f32(partial, block);
+		for (int l = 0; l < 4; l++)
+			squares[l] += partial[l];
+	}
+
+	float    minLanes[4], maxLanes[4];
+	uint32_t clipLanesU[4];
+	int      clipLanes[4];
+	vst1q_f32(minLanes, mins);
+	vst1q_f32(maxLanes, maxs);
+	vst1q_u32(clipLanesU, clipped);
+	for (int l = 0; l < 4; l++)
+		clipLanes[l] = static_cast<int>(clipLanesU[l]);
+
+	initStats(out, channels);
+	foldLanes(minLanes, maxLanes, squares, clipLanes, 4, channels, out);
+	accumulateStats(src, i, samples, channels, clipThreshold, out);
+}
+
+/* -------------------------------------------------------------------------- */
+
+inline float32x4_t nextUniformNeon(uint32x4_t& x)
+{
+	x                     = veorq_u32(x, vshlq_n_u32(x, 13));
+	x                     = veorq_u32(x, vshrq_n_u32(x, 17));
+	x                     = veorq_u32(x, vshlq_n_u32(x, 5));
+	const uint32x4_t bits = vorrq_u32(vshrq_n_u32(x, 9), vdupq_n_u32(0x3F800000));
+	return vsubq_f32(vreinterpretq_f32_u32(bits), vdupq_n_f32(1.0f));
+}
+
+template <bool Dither>
+inline int32x4_t quantizeNeon(float32x4_t v, float scale, float limit, float dither, uint32x4_t& state)
+{
+	v = vmulq_n_f32(v, scale);
+	if constexpr (Dither)
+	{
+		const float32x4_t a = nextUniformNeon(state);
+		v                   = vaddq_f32(v, vmulq_n_f32(vsubq_f32(a, nextUniformNeon(state)), dither));
+	}
+	v = vminq_f32(vmaxq_f32(v, vdupq_n_f32(-scale)), vdupq_n_f32(limit));
+#if defined(__aarch64__) || defined(_M_ARM64)
+	return vcvtnq_s32_f32(v); // Rounds to nearest even, same as lrint()
+#else
+	/* ARMv7 can only truncate: round half away from zero instead, which only 
+	differs from lrint() on exact ties. */
+	const float32x4_t half = vbslq_f32(vcltq_f32(v, vdupq_n_f32(0.0f)), vdupq_n_f32(-0.5f), vdupq_n_f32(0.5f));
+	return vcvtq_s32_f32(vaddq_f32(v, half));
+#endif
+}
+
+void decodeInt16Neon(float* dest, const void* src, int samples)
+{
+	const std::int16_t* in = static_cast<const std::int16_t*>(src);
+
+	int i = 0;
+	for (; i + 8 <= samples; i += 8)
+	{
+		const int16x8_t x = vld1q_s16(in + i);
+		vst1q_f32(dest + i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(x))), 1.0f / INT16_SCALE));
+		vst1q_f32(dest + i + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(x))), 1.0f / INT16_SCALE));
+	}
+
+	decodeInt16Scalar(dest + i, in + i, samples - i);
+}
+
+void decodeInt32Neon(float* dest, const void* src, int samples)
+{
+	const std::int32_t* in = static_cast<const std::int32_t*>(src);
+
+	int i = 0;
+	for (; i + 4 <= samples; i += 4)
+		vst1q_f32(dest + i, vmulq_n_f32(vcvtq_f32_s32(vld1q_s32(in + i)), 1.0f / INT32_SCALE));
+
+	decodeInt32Scalar(dest + i, in + i, samples - i);
+}
+
+template <bool Dither>
+void encodeInt16Neon(std::int16_t* out, const float* src, int samples, float dither, std::uint32_t* state)
+{
+	uint32x4_t lanesLo = vld1q_u32(state);
+	uint32x4_t lanesHi = vld1q_u32(state + 4);
+
+	int i = 0;
+	for (; i + 8 <= samples; i += 8)
+	{
+		const int32x4_t lo = quantizeNeon<Dither>(vld1q_f32(src + i), INT16_SCALE, INT16_LIMIT, dither, lanesLo);
+		const int32x4_t hi = quantizeNeon<Dither>(vld1q_f32(src + i + 4), INT16_SCALE, INT16_LIMIT, dither, lanesHi);
+		vst1q_s16(out + i, vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi)));
+	}
+
+	vst1q_u32(state, lanesLo);
+	vst1q_u32(state + 4, lanesHi);
+	encodeInt16Scalar(out + i, src + i, samples - i, dither, state);
+}
+
+template <bool Dither>
+void encodeInt32Neon(std::int32_t* out, const float* src, int samples, float dither, std::uint32_t* state)
+{
+	uint32x4_t lanesLo = vld1q_u32(state);
+	uint32x4_t lanesHi = vld1q_u32(state + 4);
+
+	int i = 0;
+	for (; i + 8 <= samples; i += 8)
+	{
+		vst1q_s32(out + i, quantizeNeon<Dither>(vld1q_f32(src + i), INT32_SCALE, INT32_LIMIT, dither, lanesLo));
+		vst1q_s32(out + i + 4, quantizeNeon<Dither>(vld1q_f32(src + i + 4), INT32_SCALE, INT32_LIMIT, dither, lanesHi));
+	}
+
+	vst1q_u32(state, lanesLo);
+	vst1q_u32(state + 4, lanesHi);
+	encodeInt32Scalar(out + i, src + i, samples - i, dither, state);
+}
+
+void encodeInt16Neon(void* dest, const float* src, int samples, float dither, std::uint32_t* state)
+{
+	std::int16_t* out = static_cast<std::int16_t*>(dest);
+	dither != 0.0f ? encodeInt16Neon<true>(out, src, samples, dither, state) : encodeInt16Neon<false>(out, src, samples, dither, state);
+}
+
+void encodeInt32Neon(void* dest, const float* src, int samples, float dither, std::uint32_t* state)
+{
+	std::int32_t* out = static_cast<std::int32_t*>(dest);
+	dither != 0.0f ? encodeInt32Neon<true>(out, src, samples, dither, state) : encodeInt32Neon<false>(out, src, samples, dither, state);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+template <Operation O>
+void int16Neon(float* dest, const std::int16_t* src, int samples, float gainEven, float gainOdd)
+{
+	const float       g[4]  = {gainEven, gainOdd, gainEven, gainOdd};
+	const float32x4_t gains = vld1q_f32(g);
+
+	int i = 0;
+	for (; i + 8 <= samples; i += 8)
+	{
+		const int16x8_t x = vld1q_s16(src + i);
+		storeNeon<O>(dest + i, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(x))), gains));
+		storeNeon<O>(dest + i + 4, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(x))), gains));
+	}
+
+	int16Scalar<O>(dest + i, src + i, samples - i, gainEven, gainOdd);
+}
+
+template <Operation O>
+void halfNeon(float* dest, const std::uint16_t* src, int samples, float gainEven, float gainOdd)
+{
+	int i = 0;
+#if defined(__aarch64__) || defined(_M_ARM64)
+	const float       g[4]  = {gainEven, gainOdd, gainEven, gainOdd};
+	const float32x4_t gains = vld1q_f32(g);
+
+	for (; i + 8 <= samples; i += 8)
+	{
+		const uint16x8_t x = vld1q_u16(src + i);
+		storeNeon<O>(dest + i, vmulq_f32(vcvt_f32_f16(vreinterpret_f16_u16(vget_low_u16(x))), gains));
+		storeNeon<O>(dest + i + 4, vmulq_f32(vcvt_f32_f16(vreinterpret_f16_u16(vget_high_u16(x))), gains));
+	}
+#endif // Half conversions are optional on ARMv7: stay scalar there
+
+	halfScalar<O>(dest + i, src + i, samples - i, gainEven, gainOdd);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void envelopeNeon(float* dest, const float* src, int samples, const float* env)
+{
+	int i = 0;
+	for (; i + 4 <= samples; i += 4)
+		vst1q_f32(dest + i, vmulq_f32(vld1q_f32(src + i), vld1q_f32(env + i)));
+
+	envelopeScalar(dest + i, src + i, samples - i, env + i);
+}
+
+void crossfadeNeon(float* dest, const float* a, const float* b, int samples, const float* envA, const float* envB)
+{
+	int i = 0;
+	for (; i + 4 <= samples; i += 4)
+	{
+		const float32x4_t x = vmulq_f32(vld1q_f32(a + i), vld1q_f32(envA + i));
+		const float32x4_t y = vmulq_f32(vld1q_f32(b + i), vld1q_f32(envB + i));
+		vst1q_f32(dest + i, vaddq_f32(x, y));
+	}
+
+	crossfadeScalar(dest + i, a + i, b + i, samples - i, envA + i, envB + i);
+}
+
+void flushDenormalsNeon(float* data, int samples)
+{
+	const uint32x4_t exponent = vdupq_n_u32(0x7F800000);
+	const uint32x4_t sign     = vdupq_n_u32(0x80000000);
+
+	int i = 0;
+	for (; i + 4 <= samples; i += 4)
+	{
+		const uint32x4_t bits   = vreinterpretq_u32_f32(vld1q_f32(data + i));
+		const uint32x4_t normal = vtstq_u32(bits, exponent); // All ones if any exponent bit is set
+		vst1q_f32(data + i, vreinterpretq_f32_u32(vandq_u32(bits, vorrq_u32(normal, sign))));
+	}
+
+	flushDenormalsScalar(data + i, samples - i);
+}
+#endif // MCL_KERNELS_NEON
+
+/* -------------------------------------------------------------------------- */
+
+#if defined(MCL_KERNELS_X86)
+
+bool hasAvx2()
+{
+#if defined(__GNUC__) || defined(__clang__)
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("f16c");
+#elif defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 1);
+	const bool osxsave = (info[2] & (1 << 27)) != 0;
+	const bool avx     = (info[2] & (1 << 28)) != 0;
+	const bool f16c    = (info[2] & (1 << 29)) != 0;
+	if (!osxsave || !avx || !f16c || (_xgetbv(0) & 0x6) != 0x6) // OS must save YMM registers
+		return false;
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	return false;
+#endif
+}
+
+bool hasSse2()
+{
+#if defined(__x86_64__) || defined(_M_X64)
+	return true; // Part of the x86-64 baseline
+#elif defined(__GNUC__) || defined(__clang__)
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("sse2");
+#elif defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 1);
+	return (info[3] & (1 << 26)) != 0;
+#else
+	return false;
+#endif
+}
+
+#endif // MCL_KERNELS_X86
+
+/* -------------------------------------------------------------------------- */
+
+constexpr Table scalarTable = {
+    stereoScalar<Operation::SUM>,
+    stereoScalar<Operation::SET>,
+    monoScalar<Operation::SUM>,
+    monoScalar<Operation::SET>,
+    analyzeScalar,
+    stereoRampScalar<Operation::SUM>,
+    stereoRampScalar<Operation::SET>,
+    monoRampScalar<Operation::SUM>,
+    monoRampScalar<Operation::SET>,
+    interleaveScalar,
+    deinterleaveScalar,
+    downmixScalar<Operation::SUM>,
+    downmixScalar<Operation::SET>,
+    decodeInt16Scalar,
+    decodeInt24Scalar,
+    decodeInt32Scalar,
+    decodeFloat64Scalar,
+    encodeInt16Scalar,
+    encodeInt24Scalar,
+    encodeInt32Scalar,
+    encodeFloat64Scalar,
+    resampleScalar<false>,
+    resampleScalar<true>,
+    int16Scalar<Operation::SUM>,
+    int16Scalar<Operation::SET>,
+    halfScalar<Operation::SUM>,
+    halfScalar<Operation::SET>,
+    envelopeScalar,
+    crossfadeScalar,
+    flushDenormalsScalar};
+
+#if defined(MCL_KERNELS_X86)
+
+constexpr Table sse2Table = {
+    stereoSse2<Operation::SUM>,
+    stereoSse2<Operation::SET>,
+    monoSse2<Operation::SUM>,
+    monoSse2<Operation::SET>,
+    analyzeSse2,
+    stereoRampSse2<Operation::SUM>,
+    stereoRampSse2<Operation::SET>,
+    monoRampSse2<Operation::SUM>,
+    monoRampSse2<Operation::SET>,
+    interleaveSse2,
+    deinterleaveSse2,
+    downmixSse2<Operation::SUM>,
+    downmixSse2<Operation::SET>,
+    decodeInt16Sse2,
+    decodeInt24Scalar,
+    decodeInt32Sse2,
+    decodeFloat64Sse2,
+    encodeInt16Sse2,
+    encodeInt24Scalar,
+    encodeInt32Sse2,
+    encodeFloat64Sse2,
+    resampleScalar<false>,
+    resampleScalar<true>,
+    int16Sse2<Operation::SUM>,
+    int16Sse2<Operation::SET>,
+    halfSse2<Operation::SUM>,
+    halfSse2<Operation::SET>,
+    envelopeSse2,
+    crossfadeSse2,
+    flushDenormalsSse2};
+
+constexpr Table avx2Table = {
+    stereoAvx2<Operation::SUM>,
+    stereoAvx2<Operation::SET>,
+    monoAvx2<Operation::SUM>,
+    monoAvx2<Operation::SET>,
+    analyzeAvx2,
+    stereoRampAvx2<Operation::SUM>,
+    stereoRampAvx2<Operation::SET>,
+    monoRampAvx2<Operation::SUM>,
+    monoRampAvx2<Operation::SET>,
+    interleaveAvx2,
+    deinterleaveAvx2,
+    downmixAvx2<Operation::SUM>,
+    downmixAvx2<Operation::SET>,
+    decodeInt16Avx2,
+    decodeInt24Avx2,
+    decodeInt32Avx2,
+    decodeFloat64Avx2,
+    encodeInt16Avx2,
+    encodeInt24Avx2,
+    encodeInt32Avx2,
+    encodeFloat64Avx2,
+    resampleAvx2<false>,
+    resampleAvx2<true>,
+    int16Avx2<Operation::SUM>,
+    int16Avx2<Operation::SET>,
+    halfAvx2<Operation::SUM>,
+    halfAvx2<Operation::SET>,
+    envelopeAvx2,
+    crossfadeAvx2,
+    flushDenormalsAvx2};
+
+#endif
+
+#if defined(MCL_KERNELS_NEON)
+
+constexpr Table neonTable = {
+    stereoNeon<Operation::SUM>,
+    stereoNeon<Operation::SET>,
+    monoNeon<Operation::SUM>,
+    monoNeon<Operation::SET>,
+    analyzeNeon,
+    stereoRampNeon<Operation::SUM>,
+    stereoRampNeon<Operation::SET>,
+    monoRampNeon<Operation::SUM>,
+    monoRampNeon<Operation::SET>,
+    interleaveNeon,
+    deinterleaveNeon,
+    downmixNeon<Operation::SUM>,
+    downmixNeon<Operation::SET>,
+    decodeInt16Neon,
+    decodeInt24Scalar,
+    decodeInt32Neon,
+    decodeFloat64Scalar,
+    encodeInt16Neon,
+    encodeInt24Scalar,
+    encodeInt32Neon,
+    encodeFloat64Scalar,
+    resampleScalar<false>,
+    resampleScalar<true>,
+    int16Neon<Operation::SUM>,
+    int16Neon<Operation::SET>,
+    halfNeon<Operation::SUM>,
+    halfNeon<Operation::SET>,
+    envelopeNeon,
+    crossfadeNeon,
+    flushDenormalsNeon};
+
+#endif
+} // namespace
+
+/* -------------------------------------------------------------------------- */
+
+float halfToFloat(std::uint16_t h)
+{
+	/* Move exponent and mantissa in place and rebias the exponent. Infinities
+	and NaNs need a larger bias to reach the float maximum exponent, whereas
+	subnormals are renormalized with a float subtraction. No denormal floats
+	are involved, so the result doesn't depend on FTZ/DAZ modes. */
+
+	constexpr std::uint32_t EXP_MASK = 0x7C00 << 13;
+
+	std::uint32_t       bits = static_cast<std::uint32_t>(h & 0x7FFF) << 13;
+	const std::uint32_t exp  = bits & EXP_MASK;
+	bits += (127 - 15) << 23;
+
+	if (exp == EXP_MASK)
+		bits += (128 - 16) << 23;
+	else if (exp == 0)
+		bits = std::bit_cast<std::uint32_t>(std::bit_cast<float>(bits + (1 << 23)) - std::bit_cast<float>(113u << 23));
+
+	return std::bit_cast<float>(bits | static_cast<std::uint32_t>(h & 0x8000) << 16);
+}
+
+/* -------------------------------------------------------------------------- */
+
+std::uint16_t floatToHalf(float f)
+{
+	const std::uint32_t bits = std::bit_cast<std::uint32_t>(f);
+	const std::uint32_t abs  = bits & 0x7FFFFFFF;
+	const auto          sign = static_cast<std::uint16_t>((bits >> 16) & 0x8000);
+
+	if (abs > 0x7F800000) // NaN, kept quiet
+		return sign | 0x7E00;
+	if (abs >= 0x477FF000) // Rounds to 65520 or more: infinity
+		return sign | 0x7C00;
+	if (abs < 0x38800000) // Below 2^-14: subnormal or zero, in steps of 2^-24
+		return sign | static_cast<std::uint16_t>(std::lrint(std::bit_cast<float>(abs) * 0x1p24f));
+
+	/* Rebias the exponent, then round the mantissa to 10 bits, to nearest even.
+	A carry out of the mantissa correctly bumps the exponent. */
+
+	std::uint32_t out = abs - ((127 - 15) << 23);
+	out += 0x0FFF + ((out >> 13) & 1);
+	return sign | static_cast<std::uint16_t>(out >> 13);
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool isSupported(Isa isa)
+{
+	switch (isa)
+	{
+	case Isa::SCALAR:
+		return true;
+#if defined(MCL_KERNELS_X86)
+	case Isa::SSE2:
+		return hasSse2();
+	case Isa::AVX2:
+		return hasAvx2();
+#endif
+#if defined(MCL_KERNELS_NEON)
+	case Isa::NEON:
+		return true;
+#endif
+	default:
+		return false;
+	}
+}
+
+/* -------------------------------------------------------------------------- */
+
+Isa getBestIsa()
+{
+	for (Isa isa : {Isa::AVX2, Isa::SSE2, Isa::NEON})
+		if (isSupported(isa))
+			return isa;
+	return Isa::SCALAR;
+}
+
+/* -------------------------------------------------------------------------- */
+
+const Table& getTable(Isa isa)
+{
+	assert(isSupported(isa));
+
+	switch (isa)
+	{
+#if defined(MCL_KERNELS_X86)
+	case Isa::SSE2:
+		return sse2Table;
+	case Isa::AVX2:
+		return avx2Table;
+#endif
+#if defined(MCL_KERNELS_NEON)
+	case Isa::NEON:
+		return neonTable;
+#endif
+	default:
+		return scalarTable;
+	}
+}
+
+/* -------------------------------------------------------------------------- */
+
+const Table& getTable()
+{
+	static const Table& table = getTable(getBestIsa());
+	return table;
+}
+} // namespace mcl::kernels
@@ -0,0 +1,209 @@
+/* -----------------------------------------------------------------------------
+ *
+ * AudioBuffer
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2021 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of AudioBuffer.
+ *
+ * AudioBuffer is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * AudioBuffer is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * AudioBuffer. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+#ifndef MONOCASUAL_AUDIO_BUFFER_KERNELS_H
+#define MONOCASUAL_AUDIO_BUFFER_KERNELS_H
+
+#include <cstdint>
+
+namespace mcl::kernels
+{
+/* DITHER_LANES
+Number of independent noise generators used by the PCM encoders, see 
+Table::encodeInt16 and friends. */
+
+constexpr int DITHER_LANES = 8;
+
+/* Isa
+Instruction sets the kernels are compiled for. Which one is actually used is
+decided at runtime, according to what the current CPU supports. */
+
+enum class Isa
+{
+	SCALAR,
+	SSE2,
+	AVX2,
+	NEON
+};
+
+/* Stats
+Raw statistics of a single channel, as produced by Table::analyze. 'min' and 
+'max' are left to +FLT_MAX and -FLT_MAX respectively for empty buffers. */
+
+struct Stats
+{
+	float  min;
+	float  max;
+	double sumSquares;
+	int    clipped;
+};
+
+/* Table
+A set of pointers to the kernels compiled for a specific instruction set. All
+buffers are interleaved. 'gainL' and 'gainR' are the gains applied to the left
+and right destination channel respectively (i.e. gain * pan[ch]). */
+
+struct Table
+{
+	/* sumStereo, setStereo
+	Stereo source onto stereo destination, 'frames' frames long. */
+
+	void (*sumStereo)(float* dest, const float* src, int frames, float gainL, float gainR);
+	void (*setStereo)(float* dest, const float* src, int frames, float gainL, float gainR);
+
+	/* sumMono, setMono
+	Mono source spread over a stereo destination, 'frames' frames long. */
+
+	void (*sumMono)(float* dest, const float* src, int frames, float gainL, float gainR);
+	void (*setMono)(float* dest, const float* src, int frames, float gainL, float gainR);
+
+	/* analyze
+	Computes the statistics of 'frames' frames of 'channels' packed channels, 
+	one Stats object per channel. A sample is clipped if its absolute value 
+	exceeds 'clipThreshold'. */
+
+	void (*analyze)(const float* src, int frames, int channels, float clipThreshold, Stats* out);
+
+	/* sumStereoRamp, setStereoRamp, sumMonoRamp, setMonoRamp
+	Same as their non-ramp counterparts, with gains changing linearly over 
+	time: frame 'i' is processed with gain 'gainL + i * stepL' on the left
+	channel and 'gainR + i * stepR' on the right one. Stereo kernels can work
+	in place, i.e. with 'dest' == 'src'. */
+
+	void (*sumStereoRamp)(float* dest, const float* src, int frames, float gainL, float gainR, float stepL, float stepR);
+	void (*setStereoRamp)(float* dest, const float* src, int frames, float gainL, float gainR, float stepL, float stepR);
+	void (*sumMonoRamp)(float* dest, const float* src, int frames, float gainL, float gainR, float stepL, float stepR);
+	void (*setMonoRamp)(float* dest, const float* src, int frames, float gainL, float gainR, float stepL, float stepR);
+
+	/* interleaveStereo, deinterleaveStereo
+	Conversions between two planar channels and an interleaved stereo buffer,
+	'frames' frames long. */
+
+	void (*interleaveStereo)(float* dest, const float* left, const float* right, int frames);
+	void (*deinterleaveStereo)(float* left, float* right, const float* src, int frames);
+
+	/* sumDownmix, setDownmix
+	Stereo source folded onto a mono destination, 'frames' frames long: frame 
+	'i' is 'src left * gainL + src right * gainR'. */
+
+	void (*sumDownmix)(float* dest, const float* src, int frames, float gainL, float gainR);
+	void (*setDownmix)(float* dest, const float* src, int frames, float gainL, float gainR);
+
+	/* decodeInt16, decodeInt24, decodeInt32, decodeFloat64
+	Convert 'samples' PCM samples to floats. Integers are little-endian and 
+	scaled to [-1.0, 1.0); int24 samples are packed in 3 bytes. 'src' MUST be
+	aligned to the size of its samples. */
+
+	void (*decodeInt16)(float* dest, const void* src, int samples);
+	void (*decodeInt24)(float* dest, const void* src, int samples);
+	void (*decodeInt32)(float* dest, const void* src, int samples);
+	void (*decodeFloat64)(float* dest, const void* src, int samples);
+
+	/* encodeInt16, encodeInt24, encodeInt32, encodeFloat64
+	The opposite of the decoders above, clipping out-of-range samples. If 
+	'dither' is not 0, TPDF noise of 'dither' LSBs peak is added before 
+	rounding, drawn from 'state' (DITHER_LANES non-zero seeds, updated on 
+	return). encodeFloat64 ignores dithering. */
+
+	void (*encodeInt16)(void* dest, const float* src, int samples, float dither, std::uint32_t* state);
+	void (*encodeInt24)(void* dest, const float* src, int samples, float dither, std::uint32_t* state);
+	void (*encodeInt32)(void* dest, const float* src, int samples, float dither, std::uint32_t* state);
+	void (*encodeFloat64)(void* dest, const float* src, int samples, float dither, std::uint32_t* state);
+
+	/* resampleLinear, resampleHermite
+	Read 'frames' frames of 'channels' channels from 'src' at fractional 
+	positions, the i-th one being 'pos + i * step', interpolating neighbour
+	frames linearly or with a 4-point Hermite curve. Source frames are 
+	'srcStride' samples apart and 'srcFrames' long; neighbours beyond the ends
+	repeat the edge frames. Every position MUST lie within [0, srcFrames). 
+	'dest' is packed. */
+
+	void (*resampleLinear)(float* dest, const float* src, int srcFrames, int srcStride,
+	    int channels, int frames, double pos, double step);
+	void (*resampleHermite)(float* dest, const float* src, int srcFrames, int srcStride,
+	    int channels, int frames, double pos, double step);
+
+	/* sumInt16, setInt16, sumHalf, setHalf
+	Merge or copy 'samples' packed 16-bit samples onto 'dest', converting them 
+	to float on the fly: signed integers as they are, without any scaling, or
+	IEEE 754 half-precision floats. Even samples are multiplied by 'gainEven'
+	and odd ones by 'gainOdd', so that the same kernels serve mono and stereo
+	data. */
+
+	void (*sumInt16)(float* dest, const std::int16_t* src, int samples, float gainEven, float gainOdd);
+	void (*setInt16)(float* dest, const std::int16_t* src, int samples, float gainEven, float gainOdd);
+	void (*sumHalf)(float* dest, const std::uint16_t* src, int samples, float gainEven, float gainOdd);
+	void (*setHalf)(float* dest, const std::uint16_t* src, int samples, float gainEven, float gainOdd);
+
+	/* applyEnvelope, crossfade
+	Per-sample gains over 'samples' packed samples: applyEnvelope computes 
+	'src[i] * env[i]', crossfade 'a[i] * envA[i] + b[i] * envB[i]', both 
+	overwriting 'dest'. They can work in place, i.e. with 'dest' == 'src' or
+	'dest' == 'a'. */
+
+	void (*applyEnvelope)(float* dest, const float* src, int samples, const float* env);
+	void (*crossfade)(float* dest, const float* a, const float* b, int samples, const float* envA, const float* envB);
+
+	/* flushDenormals
+	Replaces subnormal samples with zeros of the same sign, in place. Meant for
+	CPUs, or threads, where the FPU can't be told to flush them on its own. */
+
+	void (*flushDenormals)(float* data, int samples);
+};
+
+/* halfToFloat, floatToHalf
+Scalar conversions between floats and IEEE 754 half-precision floats, the 
+latter rounding to nearest even. Out of range values become infinities. */
+
+float         halfToFloat(std::uint16_t h);
+std::uint16_t floatToHalf(float f);
+
+/* isSupported
+Returns whether kernels for the given instruction set have been compiled in and
+can run on the current CPU. AVX2 kernels also need F16C, which every AVX2 CPU
+provides in practice. */
+
+bool isSupported(Isa);
+
+/* getBestIsa
+Returns the fastest instruction set available on the current CPU. */
+
+Isa getBestIsa();
+
+/* getTable (1)
+Returns the kernels for the given instruction set. The instruction set MUST be
+supported, see isSupported() above. */
+
+const Table& getTable(Isa);
+
+/* getTable (2)
+Returns the kernels for the best instruction set available. The CPU is queried
+only once, on the first call. */
+
+const Table& getTable();
+} // namespace mcl::kernels
+
+#endif
@@ -0,0 +1,329 @@
+/* -----------------------------------------------------------------------------
+ *
+ * AudioBuffer
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2021 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of AudioBuffer.
+ *
+ * AudioBuffer is free software: you can redistribute it and/or modify it under 
+ * the terms of the GNU General Public License as published by the Free Software 
+ * Foundation, either version 3 of the License, or (at your option) any later 
+ * version.
+ *
+ * AudioBuffer is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS 
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more 
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with 
+ * AudioBuffer. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+#include "mappedAudioFile.hpp"
+#include <bit>
+#include <cassert>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace mcl
+{
+namespace
+{
+constexpr std::uint16_t WAV_FORMAT_FLOAT      = 0x0003;
+constexpr std::uint16_t WAV_FORMAT_EXTENSIBLE = 0xFFFE;
+
+/* -------------------------------------------------------------------------- */
+
+std::uint16_t readU16(const unsigned char* p)
+{
+	return static_cast<std::uint16_t>(p[0] | (p[1] << 8));
+}
+
+std::uint32_t readU32(const unsigned char* p)
+{
+	return static_cast<std::uint32_t>(p[0]) | (static_cast<std::uint32_t>(p[1]) << 8) |
+	       (static_cast<std::uint32_t>(p[2]) << 16) | (static_cast<std::uint32_t>(p[3]) << 24);
+}
+} // namespace
+
+/* -------------------------------------------------------------------------- */
+
+MappedAudioFile::MappedAudioFile()
+: m_mapping(nullptr)
+, m_mappingSize(0)
+, m_data(nullptr)
+, m_frames(0)
+, m_channels(0)
+, m_sampleRate(0)
+{
+}
+
+/* -------------------------------------------------------------------------- */
+
+MappedAudioFile::MappedAudioFile(MappedAudioFile&& o) noexcept
+: MappedAudioFile()
+{
+	move(std::move(o));
+}
+
+/* -------------------------------------------------------------------------- */
+
+MappedAudioFile::~MappedAudioFile()
+{
+	close();
+}
+
+/* -------------------------------------------------------------------------- */
+
+MappedAudioFile& MappedAudioFile::operator=(MappedAudioFile&& o) noexcept
+{
+	if (this == &o)
+		return *this;
+	move(std::move(o));
+	return *this;
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool MappedAudioFile::openRaw(const std::string& path, int channels, std::size_t offset)
+{
+	assert(channels > 0 && channels <= AudioBufferView::MAX_CHANS);
+	assert(offset % sizeof(float) == 0);
+
+	if (!map(path) || offset > m_mappingSize || !setData(offset, m_mappingSize - offset, channels))
+	{
+		close();
+		return false;
+	}
+	return true;
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool MappedAudioFile::openWav(const std::string& path)
+{
+	if constexpr (std::endian::native != std::endian::little)
+		return false;
+
+	if (!map(path))
+		return false;
+
+	const unsigned char* bytes = static_cast<const unsigned char*>(m_mapping);
+	const std::size_t    size  = m_mappingSize;
+
+	if (size < 12 || std::memcmp(bytes, "RIFF", 4) != 0 || std::memcmp(bytes + 8, "WAVE", 4) != 0)
+	{
+		close();
+		return false;
+	}
+
+	/* Walk the chunk list. Chunks are padded to an even size. */
+
+	int  channels   = 0;
+	int  sampleRate = 0;
+	bool isFloat    = false;
+
+	for (std::size_t pos = 12; pos + 8 <= size;)
+	{
+		const unsigned char* chunk     = bytes + pos;
+		const std::size_t    chunkSize = readU32(chunk + 4);
+		const std::size_t    body      = pos + 8;
+
+		if (std::memcmp(chunk, "fmt ", 4) == 0 && chunkSize >= 16 && body + 16 <= size)
+		{
+			std::uint16_t format = readU16(bytes + body);
+			const int     bits   = readU16(bytes + body + 14);
+
+			if (format == WAV_FORMAT_EXTENSIBLE && chunkSize >= 40 && body + 40 <= size)
+				format = readU16(bytes + body + 24); // First two bytes of the sub-format GUID
+
+			channels   = readU16(bytes + body + 2);
+			sampleRate = static_cast<int>(readU32(bytes + body + 4));
+			isFloat    = format == WAV_FORMAT_FLOAT && bits == 32;
+		}
+		else if (std::memcmp(chunk, "data", 4) == 0)
+		{
+			const bool valid = isFloat && channels > 0 && channels <= AudioBufferView::MAX_CHANS &&
+			                   setData(body, std::min(chunkSize, size - body), channels);
+			if (!valid)
+				break;
+			m_sampleRate = sampleRate;
+			return true;
+		}
+
+		pos = body + chunkSize + (chunkSize & 1);
+	}
+
+	close();
+	return false;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void MappedAudioFile::close()
+{
+	if (m_mapping != nullptr)
+	{
+#if defined(_WIN32)
+		UnmapViewOfFile(m_mapping);
+#else
+		munmap(m_mapping, m_mappingSize);
+#endif
+	}
+	m_mapping     = nullptr;
+	m_mappingSize = 0;
+	m_data        = nullptr;
+	m_frames      = 0;
+	m_channels    = 0;
+	m_sampleRate  = 0;
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool MappedAudioFile::isOpen() const { return m_data != nullptr; }
+int  MappedAudioFile::countFrames() const { return m_frames; }
+int  MappedAudioFile::countChannels() const { return m_channels; }
+int  MappedAudioFile::getSampleRate() const { return m_sampleRate; }
+
+/* -------------------------------------------------------------------------- */
+
+AudioBufferView MappedAudioFile::view() const
+{
+	return AudioBufferView(m_data, m_frames, m_channels);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void MappedAudioFile::prefetch(int start, int count) const
+{
+	assert(start >= 0 && count >= 0 && start + count <= m_frames);
+
+	if (count == 0)
+		return;
+
+	const std::size_t frameBytes = sizeof(float) * m_channels;
+	char*             begin      = reinterpret_cast<char*>(m_data) + start * frameBytes;
+
+#if defined(_WIN32)
+	WIN32_MEMORY_RANGE_ENTRY range = {begin, count * frameBytes};
+	PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#else
+	/* madvise() wants a page-aligned address. */
+
+	const std::uintptr_t page    = static_cast<std::uintptr_t>(sysconf(_SC_PAGESIZE));
+	const std::uintptr_t address = reinterpret_cast<std::uintptr_t>(begin);
+	const std::uintptr_t aligned = address - (address % page);
+	madvise(reinterpret_cast<void*>(aligned), count * frameBytes + (address - aligned), MADV_WILLNEED);
+#endif
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool MappedAudioFile::map(const std::string& path)
+{
+	close();
+
+#if defined(_WIN32)
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+	    OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	/* The view keeps the mapping alive: both handles can be closed right 
+	away. */
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle(file);
+	if (mapping == nullptr)
+		return false;
+
+	void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	if (data == nullptr)
+		return false;
+
+	m_mapping     = data;
+	m_mappingSize = static_cast<std::size_t>(size.QuadPart);
+#else
+	const int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd == -1)
+		return false;
+
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size == 0)
+	{
+		::close(fd);
+		return false;
+	}
+
+	/* The mapping stays valid after the file descriptor is closed. */
+
+	void* data = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (data == MAP_FAILED)
+		return false;
+
+	m_mapping     = data;
+	m_mappingSize = static_cast<std::size_t>(info.st_size);
+#endif
+	return true;
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool MappedAudioFile::setData(std::size_t offset, std::size_t bytes, int channels)
+{
+	/* Mappings are page-aligned, so 'offset' alone decides whether floats are
+	properly aligned. */
+
+	const std::size_t frames = bytes / (sizeof(float) * channels);
+
+	if (offset % sizeof(float) != 0 || frames == 0 || frames > INT_MAX)
+		return false;
+
+	m_data     = reinterpret_cast<float*>(static_cast<char*>(m_mapping) + offset);
+	m_frames   = static_cast<int>(frames);
+	m_channels = channels;
+	return true;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void MappedAudioFile::move(MappedAudioFile&& o)
+{
+	close();
+
+	m_mapping     = o.m_mapping;
+	m_mappingSize = o.m_mappingSize;
+	m_data        = o.m_data;
+	m_frames      = o.m_frames;
+	m_channels    = o.m_channels;
+	m_sampleRate  = o.m_sampleRate;
+
+	o.m_mapping = nullptr;
+	o.close();
+}
+} // namespace mcl
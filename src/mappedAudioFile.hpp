@@ -0,0 +1,113 @@
+/* -----------------------------------------------------------------------------
+ *
+ * AudioBuffer
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2021 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of AudioBuffer.
+ *
+ * AudioBuffer is free software: you can redistribute it and/or modify it under 
+ * the terms of the GNU General Public License as published by the Free Software 
+ * Foundation, either version 3 of the License, or (at your option) any later 
+ * version.
+ *
+ * AudioBuffer is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS 
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more 
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with 
+ * AudioBuffer. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+#ifndef MONOCASUAL_MAPPED_AUDIO_FILE_H
+#define MONOCASUAL_MAPPED_AUDIO_FILE_H
+
+#include "audioBufferView.hpp"
+#include <cstddef>
+#include <string>
+
+namespace mcl
+{
+/* MappedAudioFile
+A read-only, memory-mapped audio file. Samples are not loaded upfront: the OS
+pages them in on demand when accessed through view(), and can drop them again
+under memory pressure. Kernels read the mapping directly, with no copy. 
+Supported formats are raw interleaved 32-bit float files and 32-bit float WAV
+files, both in little-endian byte order. The mapping is read-only: writing to
+the view is undefined behavior (typically a crash). */
+
+class MappedAudioFile
+{
+public:
+	MappedAudioFile();
+	MappedAudioFile(const MappedAudioFile&) = delete;
+	MappedAudioFile(MappedAudioFile&& o) noexcept;
+	~MappedAudioFile();
+
+	MappedAudioFile& operator=(const MappedAudioFile&) = delete;
+	MappedAudioFile& operator=(MappedAudioFile&& o) noexcept;
+
+	/* openRaw
+	Maps file 'path' as raw interleaved float samples of 'channels' channels,
+	skipping the first 'offset' bytes. 'offset' MUST be a multiple of 4. 
+	Trailing bytes that don't make up a whole frame are ignored. Returns false
+	if the file can't be mapped. */
+
+	bool openRaw(const std::string& path, int channels, std::size_t offset = 0);
+
+	/* openWav
+	Maps the 'data' chunk of WAV file 'path'. Returns false if the file can't
+	be mapped, is not a 32-bit float WAV or its samples don't start at a 
+	multiple of 4 bytes (they can't be read in place in that case). */
+
+	bool openWav(const std::string& path);
+
+	/* close
+	Unmaps the file. Views obtained so far become invalid. */
+
+	void close();
+
+	bool isOpen() const;
+	int  countFrames() const;
+	int  countChannels() const;
+
+	/* getSampleRate
+	Returns the sample rate declared in the WAV header, or 0 for raw files. */
+
+	int getSampleRate() const;
+
+	/* view
+	Returns a view over the whole file, for reading only: see AudioBufferView 
+	about shallow constness. Passing it as the destination of any operation 
+	(set, sum, clear, applyGain...) is undefined behavior. It must not outlive
+	the mapping. */
+
+	AudioBufferView view() const;
+
+	/* prefetch
+	Hints the OS that 'count' frames starting from 'start' will be needed 
+	soon, so that they can be paged in ahead of time. Call it from a 
+	non-realtime thread: the audio thread should never wait for disk I/O. */
+
+	void prefetch(int start, int count) const;
+
+private:
+	bool map(const std::string& path);
+	bool setData(std::size_t offset, std::size_t bytes, int channels);
+	void move(MappedAudioFile&& o);
+
+	void*       m_mapping; // Beginning of the whole mapped file
+	std::size_t m_mappingSize;
+	float*      m_data; // Beginning of audio data within the mapping
+	int         m_frames;
+	int         m_channels;
+	int         m_sampleRate;
+};
+} // namespace mcl
+
+#endif
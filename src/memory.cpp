@@ -0,0 +1,44 @@
+/* -----------------------------------------------------------------------------
+ *
+ * AudioBuffer
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2021 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of AudioBuffer.
+ *
+ * AudioBuffer is free software: you can redistribute it and/or modify it under 
+ * the terms of the GNU General Public License as published by the Free Software 
+ * Foundation, either version 3 of the License, or (at your option) any later 
+ * version.
+ *
+ * AudioBuffer is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS 
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more 
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with 
+ * AudioBuffer. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+#include "memory.hpp"
+#include <new>
+
+namespace mcl::memory
+{
+float* allocAligned(std::size_t count)
+{
+	const std::size_t bytes = padSamples(count) * sizeof(float);
+	return static_cast<float*>(::operator new[](bytes, std::align_val_t{ALIGNMENT}));
+}
+
+/* -------------------------------------------------------------------------- */
+
+void freeAligned(float* p)
+{
+	::operator delete[](p, std::align_val_t{ALIGNMENT});
+}
+} // namespace mcl::memory
@@ -0,0 +1,69 @@
+/* -----------------------------------------------------------------------------
+ *
+ * AudioBuffer
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2021 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of AudioBuffer.
+ *
+ * AudioBuffer is free software: you can redistribute it and/or modify it under 
+ * the terms of the GNU General Public License as published by the Free Software 
+ * Foundation, either version 3 of the License, or (at your option) any later 
+ * version.
+ *
+ * AudioBuffer is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS 
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more 
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with 
+ * AudioBuffer. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+#ifndef MONOCASUAL_AUDIO_BUFFER_MEMORY_H
+#define MONOCASUAL_AUDIO_BUFFER_MEMORY_H
+
+#include <cstddef>
+
+namespace mcl::memory
+{
+/* ALIGNMENT
+Alignment in bytes of all the memory allocated by the library, i.e. the size
+of a cache line. Wide enough for any SIMD register. */
+
+constexpr std::size_t ALIGNMENT = 64;
+
+/* padSamples
+Rounds 'count' samples up to the next multiple of ALIGNMENT bytes. */
+
+constexpr std::size_t padSamples(std::size_t count)
+{
+	constexpr std::size_t samplesPerLine = ALIGNMENT / sizeof(float);
+	return (count + samplesPerLine - 1) / samplesPerLine * samplesPerLine;
+}
+
+/* allocAligned
+Allocates room for 'count' samples, aligned to ALIGNMENT and padded to a whole
+number of cache lines. Memory is NOT initialized. */
+
+float* allocAligned(std::size_t count);
+
+/* freeAligned
+Releases memory obtained with allocAligned(). Nullptr is a no-op. */
+
+void freeAligned(float* p);
+
+/* AlignedDeleter
+Deleter for std::unique_ptr holding memory obtained with allocAligned(). */
+
+struct AlignedDeleter
+{
+	void operator()(float* p) const { freeAligned(p); }
+};
+} // namespace mcl::memory
+
+#endif
@@ -0,0 +1,269 @@
+/* -----------------------------------------------------------------------------
+ *
+ * AudioBuffer
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2021 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of AudioBuffer.
+ *
+ * AudioBuffer is free software: you can redistribute it and/or modify it under 
+ * the terms of the GNU General Public License as published by the Free Software 
+ * Foundation, either version 3 of the License, or (at your option) any later 
+ * version.
+ *
+ * AudioBuffer is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS 
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more 
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with 
+ * AudioBuffer. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+#include "parallel.hpp"
+#include "denormals.hpp"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <optional>
+
+namespace mcl::parallel
+{
+namespace
+{
+int getChunkFrames(int channels)
+{
+	return std::max(1, CHUNK_SAMPLES / channels);
+}
+
+/* -------------------------------------------------------------------------- */
+
+/* forEachChunk
+Calls f(start, count) for each chunk of a 'frames' long buffer, through the 
+scheduler. Denormal guards are per thread: the ones of the caller are 
+recreated around each chunk, so that chunks on other threads flush too. */
+
+template <typename F>
+void forEachChunk(TaskScheduler& scheduler, int frames, int channels, F&& f)
+{
+	const int  chunkFrames = getChunkFrames(channels);
+	const bool hardware    = denormals::isHardwareFlushEnabled();
+	const bool software    = denormals::isSoftwareFlushEnabled();
+
+	scheduler.run(countChunks(frames, channels), [&](int i) {
+		std::optional<denormals::ScopedFlushToZero> hardwareGuard, softwareGuard;
+		if (hardware)
+			hardwareGuard.emplace(denormals::Mode::HARDWARE);
+		if (software)
+			softwareGuard.emplace(denormals::Mode::SOFTWARE);
+
+		const int start = i * chunkFrames;
+		f(start, std::min(chunkFrames, frames - start));
+	});
+}
+} // namespace
+
+/* -------------------------------------------------------------------------- */
+
+ThreadPool::ThreadPool(int workers)
+: m_task(nullptr)
+, m_count(0)
+, m_next(0)
+, m_active(0)
+, m_batch(0)
+, m_stop(false)
+{
+	if (workers == -1)
+		workers = std::max(0, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+
+	assert(workers >= 0);
+
+	for (int i = 0; i < workers; i++)
+		m_workers.emplace_back(&ThreadPool::work, this);
+}
+
+/* -------------------------------------------------------------------------- */
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::scoped_lock lock(m_mutex);
+		m_stop = true;
+	}
+	m_wake.notify_all();
+	for (std::thread& t : m_workers)
+		t.join();
+}
+
+/* -------------------------------------------------------------------------- */
+
+int ThreadPool::countWorkers() const
+{
+	return static_cast<int>(m_workers.size());
+}
+
+/* -------------------------------------------------------------------------- */
+
+void ThreadPool::run(int count, const std::function<void(int)>& task)
+{
+	if (count <= 0)
+		return;
+
+	if (m_workers.empty() || count == 1)
+	{
+		for (int i = 0; i < count; i++)
+			task(i);
+		return;
+	}
+
+	std::scoped_lock runLock(m_runMutex);
+	{
+		std::scoped_lock lock(m_mutex);
+		m_task  = &task;
+		m_count = count;
+		m_next.store(0, std::memory_order_relaxed);
+		m_batch++;
+	}
+	m_wake.notify_all();
+
+	drain(task, count);
+
+	/* All tasks have been picked once drain() returns. The ones picked by 
+	workers are done when no worker is active anymore. */
+
+	std::unique_lock lock(m_mutex);
+	m_done.wait(lock, [this] { return m_active == 0; });
+	m_task = nullptr;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void ThreadPool::work()
+{
+	std::uint64_t seen = 0;
+	while (true)
+	{
+		std::unique_lock lock(m_mutex);
+		m_wake.wait(lock, [&] { return m_stop || (m_task != nullptr && m_batch != seen); });
+		if (m_stop)
+			return;
+
+		/* Joining the batch before picking any task: run() can't complete, nor
+		start the next batch, until this worker is done. */
+
+		seen                                  = m_batch;
+		const std::function<void(int)>* task  = m_task;
+		const int                       count = m_count;
+		m_active++;
+		lock.unlock();
+
+		drain(*task, count);
+
+		lock.lock();
+		if (--m_active == 0)
+			m_done.notify_one();
+	}
+}
+
+/* -------------------------------------------------------------------------- */
+
+void ThreadPool::drain(const std::function<void(int)>& task, int count)
+{
+	for (int i = m_next.fetch_add(1, std::memory_order_relaxed); i < count; i = m_next.fetch_add(1, std::memory_order_relaxed))
+		task(i);
+}
+
+/* -------------------------------------------------------------------------- */
+
+int countChunks(int frames, int channels)
+{
+	const int chunkFrames = getChunkFrames(channels);
+	return (frames + chunkFrames - 1) / chunkFrames;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void clear(TaskScheduler& scheduler, AudioBufferView dest)
+{
+	forEachChunk(scheduler, dest.countFrames(), dest.countChannels(), [&](int start, int count) {
+		dest.slice(start, count).clear();
+	});
+}
+
+/* -------------------------------------------------------------------------- */
+
+void applyGain(TaskScheduler& scheduler, AudioBufferView dest, float g)
+{
+	forEachChunk(scheduler, dest.countFrames(), dest.countChannels(), [&](int start, int count) {
+		dest.slice(start, count).applyGain(g);
+	});
+}
+
+/* -------------------------------------------------------------------------- */
+
+void sum(TaskScheduler& scheduler, AudioBufferView dest, AudioBufferView src, float gain, AudioBufferView::Pan pan)
+{
+	const int frames = std::min(dest.countFrames(), src.countFrames());
+	forEachChunk(scheduler, frames, dest.countChannels(), [&](int start, int count) {
+		dest.slice(start, count).sum(src.slice(start, count), gain, pan);
+	});
+}
+
+void set(TaskScheduler& scheduler, AudioBufferView dest, AudioBufferView src, float gain, AudioBufferView::Pan pan)
+{
+	const int frames = std::min(dest.countFrames(), src.countFrames());
+	forEachChunk(scheduler, frames, dest.countChannels(), [&](int start, int count) {
+		dest.slice(start, count).set(src.slice(start, count), gain, pan);
+	});
+}
+
+/* -------------------------------------------------------------------------- */
+
+float getPeak(TaskScheduler& scheduler, AudioBufferView src, int channel)
+{
+	assert(channel >= 0 && channel < src.countChannels());
+
+	std::vector<float> peaks(countChunks(src.countFrames(), src.countChannels()), 0.0f);
+	forEachChunk(scheduler, src.countFrames(), src.countChannels(), [&](int start, int count) {
+		peaks[start / getChunkFrames(src.countChannels())] = src.slice(start, count).getPeak(channel);
+	});
+	return peaks.empty() ? 0.0f : *std::max_element(peaks.begin(), peaks.end());
+}
+
+/* -------------------------------------------------------------------------- */
+
+void analyze(TaskScheduler& scheduler, AudioBufferView src, std::span<ChannelStats> stats, float clipThreshold)
+{
+	const int channels = src.countChannels();
+
+	assert(stats.size() >= static_cast<std::size_t>(channels));
+
+	using ChunkStats = std::array<ChannelStats, AudioBufferView::MAX_CHANS>;
+
+	std::vector<ChunkStats> chunks(countChunks(src.countFrames(), channels));
+	forEachChunk(scheduler, src.countFrames(), channels, [&](int start, int count) {
+		src.slice(start, count).analyze(chunks[start / getChunkFrames(channels)], clipThreshold);
+	});
+
+	for (int ch = 0; ch < channels; ch++)
+	{
+		stats[ch] = chunks.empty() ? ChannelStats{} : chunks[0][ch];
+		for (std::size_t i = 1; i < chunks.size(); i++)
+		{
+			const ChannelStats& c = chunks[i][ch];
+			stats[ch].peak        = std::max(stats[ch].peak, c.peak);
+			stats[ch].min         = std::min(stats[ch].min, c.min);
+			stats[ch].max         = std::max(stats[ch].max, c.max);
+			stats[ch].sumSquares += c.sumSquares;
+			stats[ch].clipped += c.clipped;
+		}
+		if (!chunks.empty())
+			stats[ch].rms = static_cast<float>(std::sqrt(stats[ch].sumSquares / src.countFrames()));
+	}
+}
+} // namespace mcl::parallel
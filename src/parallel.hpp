@@ -0,0 +1,143 @@
+/* -----------------------------------------------------------------------------
+ *
+ * AudioBuffer
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2021 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of AudioBuffer.
+ *
+ * AudioBuffer is free software: you can redistribute it and/or modify it under 
+ * the terms of the GNU General Public License as published by the Free Software 
+ * Foundation, either version 3 of the License, or (at your option) any later 
+ * version.
+ *
+ * AudioBuffer is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS 
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more 
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with 
+ * AudioBuffer. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+#ifndef MONOCASUAL_AUDIO_BUFFER_PARALLEL_H
+#define MONOCASUAL_AUDIO_BUFFER_PARALLEL_H
+
+#include "audioBufferView.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+/* Parallel operations
+Versions of the usual view operations that split long buffers into chunks and
+process them on multiple threads, for offline work like bouncing, exporting or
+normalizing. Threads come from a TaskScheduler: use the ThreadPool below or 
+plug in the one of the host application. Chunk boundaries depend only on the
+buffer layout, never on the amount of threads: results are the same, bit by 
+bit, with any scheduler. Denormal protection active on the calling thread (see
+denormals::ScopedFlushToZero) is re-established in every task, wherever it 
+runs. They are NOT realtime safe. */
+
+namespace mcl::parallel
+{
+/* CHUNK_SAMPLES
+Size of the chunks in samples, so that every chunk fits comfortably in the L2
+cache of a core. */
+
+constexpr int CHUNK_SAMPLES = 32768;
+
+/* TaskScheduler
+Interface for running a batch of independent tasks. run() calls 'task' once 
+for each index in [0, count), in any order and on any thread, and returns only
+when all of them are done. */
+
+class TaskScheduler
+{
+public:
+	virtual ~TaskScheduler() = default;
+
+	virtual void run(int count, const std::function<void(int)>& task) = 0;
+};
+
+/* ThreadPool
+A TaskScheduler backed by 'workers' threads, started on construction. The 
+calling thread takes part in the work too. A pool runs one batch at a time: 
+concurrent calls to run() are serialized. */
+
+class ThreadPool : public TaskScheduler
+{
+public:
+	/* ThreadPool
+	Starts 'workers' threads. If -1, one less than the hardware threads. */
+
+	explicit ThreadPool(int workers = -1);
+	ThreadPool(const ThreadPool&) = delete;
+	~ThreadPool() override;
+
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	int countWorkers() const;
+
+	void run(int count, const std::function<void(int)>& task) override;
+
+private:
+	void work();
+
+	/* drain
+	Runs tasks of the current batch until there are none left to pick. */
+
+	void drain(const std::function<void(int)>& task, int count);
+
+	std::vector<std::thread>        m_workers;
+	std::mutex                      m_runMutex; // One batch at a time
+	std::mutex                      m_mutex;
+	std::condition_variable         m_wake;
+	std::condition_variable         m_done;
+	const std::function<void(int)>* m_task;
+	int                             m_count;
+	std::atomic<int>                m_next;
+	int                             m_active; // Workers inside the current batch
+	std::uint64_t                   m_batch;
+	bool                            m_stop;
+};
+
+/* countChunks
+Returns how many chunks a view of 'frames' frames of 'channels' channels is 
+split into. */
+
+int countChunks(int frames, int channels);
+
+/* clear, applyGain
+Parallel versions of AudioBufferView::clear() and applyGain(). */
+
+void clear(TaskScheduler&, AudioBufferView dest);
+void applyGain(TaskScheduler&, AudioBufferView dest, float g);
+
+/* sum, set
+Parallel versions of AudioBufferView::sum() and set(). */
+
+void sum(TaskScheduler&, AudioBufferView dest, AudioBufferView src, float gain = 1.0f,
+    AudioBufferView::Pan pan = AudioBufferView::UNITY_PAN);
+void set(TaskScheduler&, AudioBufferView dest, AudioBufferView src, float gain = 1.0f,
+    AudioBufferView::Pan pan = AudioBufferView::UNITY_PAN);
+
+/* getPeak, analyze
+Parallel versions of AudioBufferView::getPeak() and analyze(). Per-chunk 
+results are combined in chunk order, so sums (hence RMS) are the same with any
+amount of threads. They may differ in the last bits from the single-threaded 
+AudioBufferView versions, which accumulate in a different order. */
+
+float getPeak(TaskScheduler&, AudioBufferView src, int channel);
+void  analyze(TaskScheduler&, AudioBufferView src, std::span<ChannelStats> stats, float clipThreshold = 1.0f);
+} // namespace mcl::parallel
+
+#endif
@@ -0,0 +1,74 @@
+/* -----------------------------------------------------------------------------
+ *
+ * AudioBuffer
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2021 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of AudioBuffer.
+ *
+ * AudioBuffer is free software: you can redistribute it and/or modify it under 
+ * the terms of the GNU General Public License as published by the Free Software 
+ * Foundation, either version 3 of the License, or (at your option) any later 
+ * version.
+ *
+ * AudioBuffer is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS 
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more 
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with 
+ * AudioBuffer. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+#include "pcm.hpp"
+#include <cassert>
+
+namespace mcl
+{
+int getPcmSampleSize(PcmFormat format)
+{
+	switch (format)
+	{
+	case PcmFormat::INT16:
+		return 2;
+	case PcmFormat::INT24:
+		return 3;
+	case PcmFormat::INT32:
+	case PcmFormat::FLOAT32:
+		return 4;
+	case PcmFormat::FLOAT64:
+		return 8;
+	}
+	assert(false);
+	return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+
+Dither::Dither(float amount, std::uint32_t seed)
+: m_amount(amount)
+{
+	assert(amount >= 0.0f);
+
+	/* Spread the seed over all generators with a few rounds of an integer 
+	hash, so that lanes are uncorrelated. xorshift needs non-zero states. */
+
+	for (std::size_t i = 0; i < m_state.size(); i++)
+	{
+		std::uint32_t x = seed + static_cast<std::uint32_t>(i) * 0x9E3779B9u;
+		x               = (x ^ (x >> 16)) * 0x85EBCA6Bu;
+		x               = (x ^ (x >> 13)) * 0xC2B2AE35u;
+		x               = x ^ (x >> 16);
+		m_state[i]      = x != 0 ? x : 0x6D2B79F5u;
+	}
+}
+
+/* -------------------------------------------------------------------------- */
+
+float          Dither::getAmount() const { return m_amount; }
+std::uint32_t* Dither::getState() { return m_state.data(); }
+} // namespace mcl
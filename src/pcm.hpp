@@ -0,0 +1,83 @@
+/* -----------------------------------------------------------------------------
+ *
+ * AudioBuffer
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2021 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of AudioBuffer.
+ *
+ * AudioBuffer is free software: you can redistribute it and/or modify it under 
+ * the terms of the GNU General Public License as published by the Free Software 
+ * Foundation, either version 3 of the License, or (at your option) any later 
+ * version.
+ *
+ * AudioBuffer is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS 
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more 
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with 
+ * AudioBuffer. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+#ifndef MONOCASUAL_AUDIO_BUFFER_PCM_H
+#define MONOCASUAL_AUDIO_BUFFER_PCM_H
+
+#include "kernels.hpp"
+#include <array>
+#include <cstdint>
+
+namespace mcl
+{
+/* PcmFormat
+Sample formats for AudioBufferView::setFromPcm() and writeToPcm(). Integers 
+are little-endian and map onto [-1.0, 1.0); INT24 samples are packed in 3 
+bytes. */
+
+enum class PcmFormat
+{
+	INT16,
+	INT24,
+	INT32,
+	FLOAT32,
+	FLOAT64
+};
+
+/* getPcmSampleSize
+Returns the size of a single sample in bytes. */
+
+int getPcmSampleSize(PcmFormat);
+
+/* Dither
+TPDF dither for AudioBufferView::writeToPcm(). Keep one object per output 
+stream and pass it along with every block, so that the noise sequence carries
+on across block boundaries. */
+
+class Dither
+{
+public:
+	/* Dither
+	'amount' is the peak noise level in LSBs of the output format: 1.0 is the
+	customary TPDF dither, 0.0 disables it. Equal seeds give equal noise. */
+
+	explicit Dither(float amount = 1.0f, std::uint32_t seed = 1);
+
+	float getAmount() const;
+
+	/* getState
+	Returns the state of the noise generators, as expected by the 
+	kernels::Table encoders. */
+
+	std::uint32_t* getState();
+
+private:
+	std::array<std::uint32_t, kernels::DITHER_LANES> m_state;
+	float                                            m_amount;
+};
+} // namespace mcl
+
+#endif
@@ -0,0 +1,358 @@
+/* -----------------------------------------------------------------------------
+ *
+ * AudioBuffer
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2021 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of AudioBuffer.
+ *
+ * AudioBuffer is free software: you can redistribute it and/or modify it under 
+ * the terms of the GNU General Public License as published by the Free Software 
+ * Foundation, either version 3 of the License, or (at your option) any later 
+ * version.
+ *
+ * AudioBuffer is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS 
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more 
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with 
+ * AudioBuffer. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+#include "peakPyramid.hpp"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cfloat>
+
+namespace mcl
+{
+namespace
+{
+/* EMPTY
+Starting point for merging ranges: anything replaces it. */
+
+constexpr PeakRange EMPTY = {FLT_MAX, -FLT_MAX};
+
+void merge(PeakRange& dest, const PeakRange& src)
+{
+	dest.min = std::min(dest.min, src.min);
+	dest.max = std::max(dest.max, src.max);
+}
+
+/* -------------------------------------------------------------------------- */
+
+/* forEachPiece
+Calls 'f' on each part of frames [a, b) that lies in a single chunk, in 
+order. */
+
+template <typename F>
+void forEachPiece(std::span<const AudioBufferView> chunks, int a, int b, F&& f)
+{
+	if (a >= b)
+		return;
+
+	const int chunkFrames = chunks[0].countFrames();
+	assert(chunkFrames > 0);
+
+	for (int c = a / chunkFrames; a < b; c++)
+	{
+		const int start = a - c * chunkFrames;
+		const int count = std::min(b - a, chunks[c].countFrames() - start);
+		f(chunks[c].slice(start, count));
+		a += count;
+	}
+}
+
+/* -------------------------------------------------------------------------- */
+
+/* scan
+Computes the range of every channel over frames [a, b), writing them onto 
+'out'. */
+
+void scan(std::span<const AudioBufferView> chunks, int a, int b, int channels, PeakRange* out)
+{
+	std::fill_n(out, channels, EMPTY);
+
+	forEachPiece(chunks, a, b, [=](AudioBufferView piece) {
+		std::array<ChannelStats, AudioBufferView::MAX_CHANS> stats;
+		piece.analyze(stats);
+		for (int ch = 0; ch < channels; ch++)
+			merge(out[ch], {stats[ch].min, stats[ch].max});
+	});
+}
+} // namespace
+
+/* -------------------------------------------------------------------------- */
+
+PeakPyramid::PeakPyramid()
+: m_frames(0)
+, m_channels(0)
+, m_dirtyBlocks(0)
+, m_invalidBegin(0)
+, m_invalidEnd(0)
+{
+	resize(0, 0);
+}
+
+/* -------------------------------------------------------------------------- */
+
+int PeakPyramid::countFrames() const { return m_frames; }
+int PeakPyramid::countChannels() const { return m_channels; }
+int PeakPyramid::countLevels() const { return static_cast<int>(m_levels.size()); }
+int PeakPyramid::countDirtyBlocks() const { return m_dirtyBlocks; }
+
+/* -------------------------------------------------------------------------- */
+
+void PeakPyramid::invalidate(int a, int b)
+{
+	if (b == -1 || b > m_frames)
+		b = m_frames;
+	a = std::max(a, 0);
+	if (a >= b)
+		return;
+
+	/* Nothing to flag if the range has been invalidated already: writers that
+	invalidate the whole signal over and over, such as AudioBuffer::operator[],
+	would walk every flag of every level each time otherwise. */
+
+	if (a >= m_invalidBegin && b <= m_invalidEnd)
+		return;
+
+	for (std::size_t l = 0; l < m_levels.size(); l++)
+	{
+		const std::int64_t blockFrames = m_levels[l].blockFrames;
+		markDirty(static_cast<int>(l), static_cast<int>(a / blockFrames),
+		    static_cast<int>((b + blockFrames - 1) / blockFrames));
+	}
+
+	/* Grow the known invalid range if the two touch, keep the larger one 
+	otherwise. */
+
+	if (a <= m_invalidEnd && b >= m_invalidBegin)
+	{
+		m_invalidBegin = std::min(m_invalidBegin, a);
+		m_invalidEnd   = std::max(m_invalidEnd, b);
+	}
+	else if (b - a > m_invalidEnd - m_invalidBegin)
+	{
+		m_invalidBegin = a;
+		m_invalidEnd   = b;
+	}
+}
+
+/* -------------------------------------------------------------------------- */
+
+void PeakPyramid::update(AudioBufferView signal)
+{
+	update(std::span<const AudioBufferView>(&signal, 1));
+}
+
+/* -------------------------------------------------------------------------- */
+
+void PeakPyramid::update(std::span<const AudioBufferView> chunks)
+{
+	const int channels = chunks.empty() ? 0 : chunks[0].countChannels();
+
+	int frames = 0;
+	for (const AudioBufferView& chunk : chunks)
+	{
+		assert(chunk.countChannels() == channels);
+		frames += chunk.countFrames();
+	}
+
+	if (frames != m_frames || channels != m_channels)
+		resize(frames, channels);
+
+	/* Level 0 from the signal, then each level from the one below. */
+
+	for (std::size_t l = 0; l < m_levels.size(); l++)
+	{
+		Level& level = m_levels[l];
+
+		for (int i = level.dirtyBegin; i < level.dirtyEnd; i++)
+		{
+			if (!level.dirty[i])
+				continue;
+			level.dirty[i] = 0;
+
+			PeakRange* out = level.blocks.data() + (i * m_channels);
+
+			if (l == 0)
+			{
+				const int start = i * BLOCK_FRAMES;
+				scan(chunks, start, std::min(start + BLOCK_FRAMES, m_frames), m_channels, out);
+				continue;
+			}
+
+			const Level& below = m_levels[l - 1];
+			const int    last  = std::min((i + 1) * FANOUT, below.count);
+
+			std::fill_n(out, m_channels, EMPTY);
+			for (int c = i * FANOUT; c < last; c++)
+				for (int ch = 0; ch < m_channels; ch++)
+					merge(out[ch], below.blocks[c * m_channels + ch]);
+		}
+
+		level.dirtyBegin = level.dirtyEnd = 0;
+	}
+
+	m_dirtyBlocks  = 0;
+	m_invalidBegin = m_invalidEnd = 0;
+}
+
+/* -------------------------------------------------------------------------- */
+
+PeakRange PeakPyramid::getRange(AudioBufferView signal, int channel, int a, int b) const
+{
+	return getRange(std::span<const AudioBufferView>(&signal, 1), channel, a, b);
+}
+
+/* -------------------------------------------------------------------------- */
+
+PeakRange PeakPyramid::getRange(std::span<const AudioBufferView> chunks, int channel, int a, int b) const
+{
+	if (b == -1)
+		b = m_frames;
+
+	assert(channel >= 0 && channel < m_channels);
+	assert(a >= 0 && a <= b && b <= m_frames);
+	assert(m_dirtyBlocks == 0);
+
+	if (a >= b)
+		return {};
+
+	PeakRange out = EMPTY;
+
+	auto scanEdge = [&](int start, int end) {
+		forEachPiece(chunks, start, end, [&](AudioBufferView piece) {
+			ChannelStats stats;
+			piece.channel(channel).analyze({&stats, 1});
+			merge(out, {stats.min, stats.max});
+		});
+	};
+
+	/* Frames at the edges that don't fill a whole level 0 block are read from 
+	the signal. */
+
+	const int first = static_cast<int>((static_cast<std::int64_t>(a) + BLOCK_FRAMES - 1) / BLOCK_FRAMES * BLOCK_FRAMES);
+	const int last  = b / BLOCK_FRAMES * BLOCK_FRAMES;
+
+	if (first >= last)
+	{
+		scanEdge(a, b);
+		return out;
+	}
+	scanEdge(a, first);
+	scanEdge(last, b);
+
+	/* Blocks in [lo, hi) at the current level: use the ones that don't fill a
+	whole block above, then move up. */
+
+	auto mergeBlocks = [&](const Level& level, int lo, int hi) {
+		for (int i = lo; i < hi; i++)
+			merge(out, level.blocks[i * m_channels + channel]);
+	};
+
+	int lo = first / BLOCK_FRAMES;
+	int hi = last / BLOCK_FRAMES;
+
+	for (std::size_t l = 0; lo < hi; l++)
+	{
+		const Level& level = m_levels[l];
+		const int    upLo  = (lo + FANOUT - 1) / FANOUT;
+		const int    upHi  = hi / FANOUT;
+
+		if (l + 1 == m_levels.size() || upLo >= upHi)
+		{
+			mergeBlocks(level, lo, hi);
+			break;
+		}
+		mergeBlocks(level, lo, upLo * FANOUT);
+		mergeBlocks(level, upHi * FANOUT, hi);
+		lo = upLo;
+		hi = upHi;
+	}
+
+	return out;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void PeakPyramid::resize(int frames, int channels)
+{
+	/* Blocks covering frames that both the old and the new signal have are
+	still valid, as long as the amount of channels is the same. */
+
+	const bool same = channels == m_channels;
+	const int  kept = same ? std::min(frames, m_frames) : 0;
+
+	std::vector<Level> levels;
+	std::int64_t       blockFrames = BLOCK_FRAMES;
+	int                count       = static_cast<int>((static_cast<std::int64_t>(frames) + BLOCK_FRAMES - 1) / BLOCK_FRAMES);
+
+	while (true)
+	{
+		Level level{blockFrames, count, {}, {}, 0, 0};
+
+		const std::size_t l = levels.size();
+		if (same && l < m_levels.size())
+		{
+			level.blocks     = std::move(m_levels[l].blocks);
+			level.dirty      = std::move(m_levels[l].dirty);
+			level.dirtyBegin = std::min(m_levels[l].dirtyBegin, count);
+			level.dirtyEnd   = std::min(m_levels[l].dirtyEnd, count);
+		}
+		level.blocks.resize(count * channels);
+		level.dirty.resize(count, 0);
+		levels.push_back(std::move(level));
+
+		if (count <= 1)
+			break;
+		count = (count + FANOUT - 1) / FANOUT;
+		blockFrames *= FANOUT;
+	}
+
+	m_levels      = std::move(levels);
+	m_frames      = frames;
+	m_channels    = channels;
+	m_dirtyBlocks = static_cast<int>(std::count(m_levels[0].dirty.begin(), m_levels[0].dirty.end(), 1));
+
+	for (std::size_t l = 0; l < m_levels.size(); l++)
+		markDirty(static_cast<int>(l), static_cast<int>(kept / m_levels[l].blockFrames), m_levels[l].count);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void PeakPyramid::markDirty(int l, int a, int b)
+{
+	Level& level = m_levels[l];
+
+	b = std::min(b, level.count);
+	if (a >= b)
+		return;
+
+	for (int i = a; i < b; i++)
+	{
+		if (level.dirty[i])
+			continue;
+		level.dirty[i] = 1;
+		if (l == 0)
+			m_dirtyBlocks++;
+	}
+
+	if (level.dirtyBegin >= level.dirtyEnd)
+	{
+		level.dirtyBegin = a;
+		level.dirtyEnd   = b;
+		return;
+	}
+	level.dirtyBegin = std::min(level.dirtyBegin, a);
+	level.dirtyEnd   = std::max(level.dirtyEnd, b);
+}
+} // namespace mcl
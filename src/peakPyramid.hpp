@@ -0,0 +1,163 @@
+/* -----------------------------------------------------------------------------
+ *
+ * AudioBuffer
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2021 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of AudioBuffer.
+ *
+ * AudioBuffer is free software: you can redistribute it and/or modify it under 
+ * the terms of the GNU General Public License as published by the Free Software 
+ * Foundation, either version 3 of the License, or (at your option) any later 
+ * version.
+ *
+ * AudioBuffer is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS 
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more 
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with 
+ * AudioBuffer. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+#ifndef MONOCASUAL_PEAK_PYRAMID_H
+#define MONOCASUAL_PEAK_PYRAMID_H
+
+#include "audioBufferView.hpp"
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace mcl
+{
+/* PeakRange
+Lowest and highest sample over a range of frames of a single channel. Both 
+are 0.0f for empty ranges. */
+
+struct PeakRange
+{
+	float min = 0.0f;
+	float max = 0.0f;
+
+	bool operator==(const PeakRange&) const = default;
+};
+
+/* PeakPyramid
+Min/max summary of a signal at multiple resolutions, for drawing waveforms. 
+Level 0 holds a PeakRange per channel every BLOCK_FRAMES frames; every level 
+above summarizes FANOUT blocks of the one below (256, 4096, 65536... frames),
+up to a level made of a single block. getRange() reads at most 2 * (FANOUT - 
+1) blocks per level plus the frames at the edges, so its cost grows with the
+logarithm of the range length instead of the range length itself.
+
+The pyramid doesn't own the signal, nor does it watch it: call invalidate() 
+when frames change and update() before querying. update() rebuilds only the 
+blocks invalidated in the meantime, plus the ones at the end if the signal 
+changed length: appending to a recording costs as much as the new frames. 
+AudioBuffer can keep a pyramid in sync on its own, see 
+AudioBuffer::setPeakPyramid().
+
+A signal is passed either as a single view or as a sequence of views (chunks)
+one after the other, such as RecordingBuffer::getChunks(): all chunks but the 
+last MUST be equally long. Not thread-safe. */
+
+class PeakPyramid
+{
+public:
+	static constexpr int BLOCK_FRAMES = 256;
+	static constexpr int FANOUT       = 16;
+
+	PeakPyramid();
+
+	/* countFrames, countChannels
+	Size of the signal as of the last update(). */
+
+	int countFrames() const;
+	int countChannels() const;
+
+	/* countLevels
+	Returns the amount of levels, including level 0. */
+
+	int countLevels() const;
+
+	/* countDirtyBlocks
+	Returns how many level 0 blocks the next update() will rebuild, new blocks
+	excluded. */
+
+	int countDirtyBlocks() const;
+
+	/* invalidate
+	Marks frames in range [a, b) as changed. If 'b' is -1, the range extends 
+	to the end of the signal. */
+
+	void invalidate(int a = 0, int b = -1);
+
+	/* update (1)
+	Rebuilds the blocks invalidated since the last update, resizing the 
+	pyramid if the signal has changed length. A change in the amount of 
+	channels rebuilds everything. */
+
+	void update(AudioBufferView signal);
+
+	/* update (2)
+	Same as (1), for a signal made of multiple chunks. */
+
+	void update(std::span<const AudioBufferView> chunks);
+
+	/* getRange (1)
+	Returns the range of channel 'channel' over frames [a, b) of 'signal',
+	which MUST be the same one passed to the last update(). If 'b' is -1, the
+	range extends to the end of the signal. */
+
+	PeakRange getRange(AudioBufferView signal, int channel, int a = 0, int b = -1) const;
+
+	/* getRange (2)
+	Same as (1), for a signal made of multiple chunks. */
+
+	PeakRange getRange(std::span<const AudioBufferView> chunks, int channel, int a = 0, int b = -1) const;
+
+private:
+	/* Level
+	Blocks of a single level, 'channels' PeakRanges each. Dirty blocks have 
+	their flag set, and lie within [dirtyBegin, dirtyEnd). */
+
+	struct Level
+	{
+		std::int64_t              blockFrames;
+		int                       count;
+		std::vector<PeakRange>    blocks;
+		std::vector<std::uint8_t> dirty;
+		int                       dirtyBegin;
+		int                       dirtyEnd;
+	};
+
+	/* resize
+	Adapts levels to a signal of 'frames' frames and 'channels' channels, 
+	keeping the blocks that are still valid. */
+
+	void resize(int frames, int channels);
+
+	/* markDirty
+	Flags blocks in range [a, b) of level 'l'. */
+
+	void markDirty(int l, int a, int b);
+
+	std::vector<Level> m_levels;
+	int                m_frames;
+	int                m_channels;
+	int                m_dirtyBlocks;
+
+	/* m_invalidBegin, m_invalidEnd
+	Frames known to be flagged on every level since the last update(). Lets 
+	invalidate() return early on ranges already invalid. */
+
+	int m_invalidBegin;
+	int m_invalidEnd;
+};
+} // namespace mcl
+
+#endif
@@ -0,0 +1,255 @@
+/* -----------------------------------------------------------------------------
+ *
+ * AudioBuffer
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2021 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of AudioBuffer.
+ *
+ * AudioBuffer is free software: you can redistribute it and/or modify it under 
+ * the terms of the GNU General Public License as published by the Free Software 
+ * Foundation, either version 3 of the License, or (at your option) any later 
+ * version.
+ *
+ * AudioBuffer is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS 
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more 
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with 
+ * AudioBuffer. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+#include "planarAudioBuffer.hpp"
+#include "kernels.hpp"
+#include <algorithm>
+#include <cassert>
+
+namespace mcl
+{
+PlanarAudioBuffer::PlanarAudioBuffer()
+: m_data(nullptr)
+, m_channelPtrs(nullptr)
+, m_size(0)
+, m_channels(0)
+, m_capacity(0)
+{
+}
+
+/* -------------------------------------------------------------------------- */
+
+PlanarAudioBuffer::PlanarAudioBuffer(int size, int channels, AudioBuffer::Init init)
+: PlanarAudioBuffer()
+{
+	alloc(size, channels, init);
+}
+
+/* -------------------------------------------------------------------------- */
+
+PlanarAudioBuffer::PlanarAudioBuffer(const PlanarAudioBuffer& o)
+: PlanarAudioBuffer()
+{
+	copy(o);
+}
+
+/* -------------------------------------------------------------------------- */
+
+PlanarAudioBuffer::PlanarAudioBuffer(PlanarAudioBuffer&& o) noexcept
+: PlanarAudioBuffer()
+{
+	move(std::move(o));
+}
+
+/* -------------------------------------------------------------------------- */
+
+PlanarAudioBuffer::~PlanarAudioBuffer() = default;
+
+/* -------------------------------------------------------------------------- */
+
+PlanarAudioBuffer& PlanarAudioBuffer::operator=(const PlanarAudioBuffer& o)
+{
+	if (this == &o)
+		return *this;
+	copy(o);
+	return *this;
+}
+
+/* -------------------------------------------------------------------------- */
+
+PlanarAudioBuffer& PlanarAudioBuffer::operator=(PlanarAudioBuffer&& o) noexcept
+{
+	if (this == &o)
+		return *this;
+	move(std::move(o));
+	return *this;
+}
+
+/* -------------------------------------------------------------------------- */
+
+float* const* PlanarAudioBuffer::getChannels() const { return m_channelPtrs.get(); }
+
+/* -------------------------------------------------------------------------- */
+
+float* PlanarAudioBuffer::getChannel(int ch) const
+{
+	assert(m_data != nullptr);
+	assert(ch >= 0 && ch < m_channels);
+	return m_channelPtrs[ch];
+}
+
+/* -------------------------------------------------------------------------- */
+
+AudioBufferView PlanarAudioBuffer::getChannelView(int ch) const
+{
+	return AudioBufferView(getChannel(ch), m_size, 1);
+}
+
+/* -------------------------------------------------------------------------- */
+
+int  PlanarAudioBuffer::countFrames() const { return m_size; }
+int  PlanarAudioBuffer::countSamples() const { return m_size * m_channels; }
+int  PlanarAudioBuffer::countChannels() const { return m_channels; }
+bool PlanarAudioBuffer::isAllocd() const { return m_data != nullptr; }
+int  PlanarAudioBuffer::getCapacity() const { return m_capacity; }
+
+/* -------------------------------------------------------------------------- */
+
+void PlanarAudioBuffer::alloc(int size, int channels, AudioBuffer::Init init)
+{
+	assert(channels > 0 && channels <= MAX_CHANS);
+
+	/* One block for all channels. Each channel is padded to a whole number of 
+	cache lines, so that they all start aligned. */
+
+	const std::size_t channelSamples = memory::padSamples(size);
+
+	/* Reuse the current memory block if it's big enough. The pointer array 
+	always has room for MAX_CHANS channels. */
+
+	if (channelSamples * channels > static_cast<std::size_t>(m_capacity))
+	{
+		free();
+		m_data.reset(memory::allocAligned(channelSamples * channels));
+		m_channelPtrs = std::make_unique<float*[]>(MAX_CHANS);
+		m_capacity    = static_cast<int>(channelSamples * channels);
+	}
+
+	m_size     = size;
+	m_channels = channels;
+
+	for (int ch = 0; ch < channels; ch++)
+		m_channelPtrs[ch] = m_data.get() + (ch * channelSamples);
+
+	if (init == AudioBuffer::Init::ZERO)
+		clear();
+}
+
+/* -------------------------------------------------------------------------- */
+
+void PlanarAudioBuffer::free()
+{
+	m_data.reset();
+	m_channelPtrs.reset();
+	m_size     = 0;
+	m_channels = 0;
+	m_capacity = 0;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void PlanarAudioBuffer::clear()
+{
+	for (int ch = 0; ch < m_channels; ch++)
+		std::fill_n(m_channelPtrs[ch], m_size, 0.0f);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void PlanarAudioBuffer::applyGain(float g)
+{
+	for (int ch = 0; ch < m_channels; ch++)
+		getChannelView(ch).applyGain(g);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void PlanarAudioBuffer::copy(const PlanarAudioBuffer& o)
+{
+	if (o.m_data == nullptr)
+	{
+		free();
+		return;
+	}
+
+	alloc(o.m_size, o.m_channels, AudioBuffer::Init::UNINITIALIZED);
+	for (int ch = 0; ch < m_channels; ch++)
+		std::copy_n(o.m_channelPtrs[ch], m_size, m_channelPtrs[ch]);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void PlanarAudioBuffer::move(PlanarAudioBuffer&& o)
+{
+	m_data        = std::move(o.m_data);
+	m_channelPtrs = std::move(o.m_channelPtrs);
+	m_size        = o.m_size;
+	m_channels    = o.m_channels;
+	m_capacity    = o.m_capacity;
+
+	o.m_size     = 0;
+	o.m_channels = 0;
+	o.m_capacity = 0;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void interleave(const float* const* src, AudioBufferView dest)
+{
+	const int frames = dest.countFrames();
+
+	if (dest.isContiguous() && dest.countChannels() == 2)
+	{
+		kernels::getTable().interleaveStereo(dest.getData(), src[0], src[1], frames);
+		return;
+	}
+	for (int ch = 0; ch < dest.countChannels(); ch++)
+		dest.channel(ch).set(AudioBufferView(const_cast<float*>(src[ch]), frames, 1));
+}
+
+/* -------------------------------------------------------------------------- */
+
+void interleave(const PlanarAudioBuffer& src, AudioBufferView dest)
+{
+	assert(src.countChannels() == dest.countChannels());
+
+	interleave(src.getChannels(), dest.slice(0, std::min(src.countFrames(), dest.countFrames())));
+}
+
+/* -------------------------------------------------------------------------- */
+
+void deinterleave(AudioBufferView src, float* const* dest)
+{
+	const int frames = src.countFrames();
+
+	if (src.isContiguous() && src.countChannels() == 2)
+	{
+		kernels::getTable().deinterleaveStereo(dest[0], dest[1], src.getData(), frames);
+		return;
+	}
+	for (int ch = 0; ch < src.countChannels(); ch++)
+		AudioBufferView(dest[ch], frames, 1).set(src.channel(ch));
+}
+
+/* -------------------------------------------------------------------------- */
+
+void deinterleave(AudioBufferView src, PlanarAudioBuffer& dest)
+{
+	assert(src.countChannels() == dest.countChannels());
+
+	deinterleave(src.slice(0, std::min(src.countFrames(), dest.countFrames())), dest.getChannels());
+}
+} // namespace mcl
@@ -0,0 +1,151 @@
+/* -----------------------------------------------------------------------------
+ *
+ * AudioBuffer
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2021 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of AudioBuffer.
+ *
+ * AudioBuffer is free software: you can redistribute it and/or modify it under 
+ * the terms of the GNU General Public License as published by the Free Software 
+ * Foundation, either version 3 of the License, or (at your option) any later 
+ * version.
+ *
+ * AudioBuffer is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS 
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more 
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with 
+ * AudioBuffer. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+#ifndef MONOCASUAL_PLANAR_AUDIO_BUFFER_H
+#define MONOCASUAL_PLANAR_AUDIO_BUFFER_H
+
+#include "audioBuffer.hpp"
+#include "audioBufferView.hpp"
+#include "memory.hpp"
+#include <memory>
+
+namespace mcl
+{
+/* PlanarAudioBuffer
+A class that holds audio data in planar (non-interleaved) layout: each channel
+lives in its own contiguous array, as most plugin hosts and FFT libraries 
+expect. Channel arrays are aligned to memory::ALIGNMENT. Each channel can be
+wrapped in a mono AudioBufferView, so that all the usual kernels apply. */
+
+class PlanarAudioBuffer
+{
+public:
+	static constexpr int MAX_CHANS = AudioBuffer::MAX_CHANS;
+
+	/* PlanarAudioBuffer (1)
+	Creates an empty (and invalid) audio buffer. */
+
+	PlanarAudioBuffer();
+
+	/* PlanarAudioBuffer (2)
+	Creates an audio buffer and allocates memory for 'size' frames of 
+	'channels' channels. See alloc() below. */
+
+	PlanarAudioBuffer(int size, int channels, AudioBuffer::Init init = AudioBuffer::Init::ZERO);
+
+	PlanarAudioBuffer(const PlanarAudioBuffer& o);
+	PlanarAudioBuffer(PlanarAudioBuffer&& o) noexcept;
+	~PlanarAudioBuffer();
+
+	PlanarAudioBuffer& operator=(const PlanarAudioBuffer& o);
+	PlanarAudioBuffer& operator=(PlanarAudioBuffer&& o) noexcept;
+
+	/* getChannels
+	Returns the array of channel pointers, suitable for APIs that take 
+	'float**' or 'float* const*'. */
+
+	float* const* getChannels() const;
+
+	/* getChannel
+	Returns a pointer to the first sample of channel 'ch'. */
+
+	float* getChannel(int ch) const;
+
+	/* getChannelView
+	Returns a mono view over channel 'ch'. */
+
+	AudioBufferView getChannelView(int ch) const;
+
+	int  countFrames() const;
+	int  countSamples() const;
+	int  countChannels() const;
+	bool isAllocd() const;
+
+	/* getCapacity
+	Returns how many samples the buffer can hold without allocating new 
+	memory, padding of each channel included. */
+
+	int getCapacity() const;
+
+	/* alloc
+	Allocates memory for 'size' frames of 'channels' channels, discarding any
+	previous data. Like AudioBuffer::alloc(), the current memory is reused if
+	it's big enough. */
+
+	void alloc(int size, int channels, AudioBuffer::Init init = AudioBuffer::Init::ZERO);
+	void free();
+
+	/* clear
+	Sets all samples to 0.0f. */
+
+	void clear();
+
+	/* applyGain
+	Applies gain 'g' to all samples. */
+
+	void applyGain(float g);
+
+private:
+	void copy(const PlanarAudioBuffer& o);
+	void move(PlanarAudioBuffer&& o);
+
+	std::unique_ptr<float[], memory::AlignedDeleter> m_data;
+	std::unique_ptr<float*[]>                        m_channelPtrs;
+	int                                              m_size;
+	int                                              m_channels;
+	int                                              m_capacity;
+};
+
+/* -------------------------------------------------------------------------- */
+
+/* interleave (1)
+Converts planar data from channel pointers 'src' into the interleaved view 
+'dest'. 'src' MUST provide dest.countChannels() channels of at least 
+dest.countFrames() frames. */
+
+void interleave(const float* const* src, AudioBufferView dest);
+
+/* interleave (2)
+Same as above with a PlanarAudioBuffer as source. The amount of frames 
+converted is the smallest between the two buffers. Channels MUST match. */
+
+void interleave(const PlanarAudioBuffer& src, AudioBufferView dest);
+
+/* deinterleave (1)
+Converts the interleaved view 'src' into planar data to channel pointers 
+'dest'. 'dest' MUST provide src.countChannels() channels of at least 
+src.countFrames() frames. */
+
+void deinterleave(AudioBufferView src, float* const* dest);
+
+/* deinterleave (2)
+Same as above with a PlanarAudioBuffer as destination. The amount of frames 
+converted is the smallest between the two buffers. Channels MUST match. */
+
+void deinterleave(AudioBufferView src, PlanarAudioBuffer& dest);
+} // namespace mcl
+
+#endif
@@ -0,0 +1,259 @@
+/* -----------------------------------------------------------------------------
+ *
+ * AudioBuffer
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2021 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of AudioBuffer.
+ *
+ * AudioBuffer is free software: you can redistribute it and/or modify it under 
+ * the terms of the GNU General Public License as published by the Free Software 
+ * Foundation, either version 3 of the License, or (at your option) any later 
+ * version.
+ *
+ * AudioBuffer is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS 
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more 
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with 
+ * AudioBuffer. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+#include "recordingBuffer.hpp"
+#include "memory.hpp"
+#include <algorithm>
+#include <cassert>
+
+namespace mcl
+{
+static_assert(std::atomic<int>::is_always_lock_free);
+
+/* -------------------------------------------------------------------------- */
+
+RecordingBuffer::RecordingBuffer(int channels, int maxFrames, int chunkFrames, int spareChunks)
+: m_chunks(std::make_unique<float*[]>((maxFrames + chunkFrames - 1) / chunkFrames))
+, m_channels(channels)
+, m_chunkFrames(chunkFrames)
+, m_maxChunks((maxFrames + chunkFrames - 1) / chunkFrames)
+, m_spareChunks(spareChunks)
+, m_frames(0)
+, m_requested(0)
+, m_allocated(0)
+, m_stop(false)
+, m_allocator(&RecordingBuffer::runAllocator, this)
+{
+	assert(channels > 0 && channels <= AudioBuffer::MAX_CHANS);
+	assert(maxFrames > 0);
+	assert(chunkFrames > 0);
+	assert(spareChunks >= 0);
+
+	reserve(std::min(spareChunks + 1, m_maxChunks) * chunkFrames);
+}
+
+/* -------------------------------------------------------------------------- */
+
+RecordingBuffer::~RecordingBuffer()
+{
+	m_stop.store(true);
+	m_requested.fetch_add(1);
+	m_requested.notify_one();
+	m_allocator.join();
+
+	const int allocated = m_allocated.load();
+	for (int i = 0; i < allocated; i++)
+		memory::freeAligned(m_chunks[i]);
+}
+
+/* -------------------------------------------------------------------------- */
+
+int RecordingBuffer::countChannels() const { return m_channels; }
+int RecordingBuffer::countChunkFrames() const { return m_chunkFrames; }
+int RecordingBuffer::getMaxFrames() const { return m_maxChunks * m_chunkFrames; }
+
+/* -------------------------------------------------------------------------- */
+
+int RecordingBuffer::countFrames() const
+{
+	return m_frames.load(std::memory_order_acquire);
+}
+
+/* -------------------------------------------------------------------------- */
+
+int RecordingBuffer::getCapacity() const
+{
+	return m_allocated.load(std::memory_order_acquire) * m_chunkFrames;
+}
+
+/* -------------------------------------------------------------------------- */
+
+int RecordingBuffer::append(AudioBufferView src)
+{
+	assert(src.countChannels() == m_channels);
+
+	const int allocated = m_allocated.load(std::memory_order_acquire);
+
+	int frames  = m_frames.load(std::memory_order_relaxed);
+	int written = 0;
+	while (written < src.countFrames())
+	{
+		const int chunk  = frames / m_chunkFrames;
+		const int offset = frames % m_chunkFrames;
+		if (chunk >= allocated)
+			break;
+
+		const int count = std::min(src.countFrames() - written, m_chunkFrames - offset);
+		AudioBufferView(getChunkData(chunk), m_chunkFrames, m_channels).slice(offset, count).set(src.slice(written, count));
+
+		written += count;
+		frames += count;
+	}
+
+	m_frames.store(frames, std::memory_order_release);
+	requestChunks(frames / m_chunkFrames + 1 + m_spareChunks);
+	return written;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void RecordingBuffer::reset()
+{
+	m_frames.store(0, std::memory_order_release);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void RecordingBuffer::reserve(int frames)
+{
+	assert(frames <= getMaxFrames());
+
+	const int count = (frames + m_chunkFrames - 1) / m_chunkFrames;
+	requestChunks(count);
+
+	int allocated = m_allocated.load(std::memory_order_acquire);
+	while (allocated < count)
+	{
+		m_allocated.wait(allocated, std::memory_order_acquire);
+		allocated = m_allocated.load(std::memory_order_acquire);
+	}
+}
+
+/* -------------------------------------------------------------------------- */
+
+int RecordingBuffer::countChunks() const
+{
+	return (countFrames() + m_chunkFrames - 1) / m_chunkFrames;
+}
+
+/* -------------------------------------------------------------------------- */
+
+AudioBufferView RecordingBuffer::getChunk(int i) const
+{
+	const int frames = countFrames();
+
+	assert(i >= 0 && i * m_chunkFrames < frames);
+
+	return {getChunkData(i), std::min(m_chunkFrames, frames - i * m_chunkFrames), m_channels};
+}
+
+/* -------------------------------------------------------------------------- */
+
+std::vector<AudioBufferView> RecordingBuffer::getChunks() const
+{
+	const int frames = countFrames();
+
+	std::vector<AudioBufferView> chunks;
+	for (int i = 0; i * m_chunkFrames < frames; i++)
+		chunks.emplace_back(getChunkData(i), std::min(m_chunkFrames, frames - i * m_chunkFrames), m_channels);
+	return chunks;
+}
+
+/* -------------------------------------------------------------------------- */
+
+int RecordingBuffer::copyTo(AudioBufferView dest, int offset) const
+{
+	assert(dest.countChannels() == m_channels);
+	assert(offset >= 0);
+
+	const int total = std::min(dest.countFrames(), std::max(countFrames() - offset, 0));
+
+	int copied = 0;
+	while (copied < total)
+	{
+		const int chunk    = (offset + copied) / m_chunkFrames;
+		const int position = (offset + copied) % m_chunkFrames;
+		const int count    = std::min(total - copied, m_chunkFrames - position);
+
+		dest.slice(copied, count).set(AudioBufferView(getChunkData(chunk), m_chunkFrames, m_channels).slice(position, count));
+		copied += count;
+	}
+	return copied;
+}
+
+/* -------------------------------------------------------------------------- */
+
+AudioBuffer RecordingBuffer::toAudioBuffer() const
+{
+	const int frames = countFrames();
+	if (frames == 0)
+		return {};
+
+	AudioBuffer out(frames, m_channels, AudioBuffer::Init::UNINITIALIZED);
+	copyTo(out.view());
+	return out;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void RecordingBuffer::requestChunks(int count)
+{
+	count = std::min(count, m_maxChunks);
+
+	/* Only ever raise the request: append() and reserve() may race. The 
+	allocator thread is woken up only when the request actually changes, 
+	which happens once per chunk at most. */
+
+	int requested = m_requested.load(std::memory_order_relaxed);
+	while (count > requested)
+	{
+		if (m_requested.compare_exchange_weak(requested, count, std::memory_order_release, std::memory_order_relaxed))
+		{
+			m_requested.notify_one();
+			return;
+		}
+	}
+}
+
+/* -------------------------------------------------------------------------- */
+
+void RecordingBuffer::runAllocator()
+{
+	int allocated = 0;
+	while (true)
+	{
+		const int requested = m_requested.load(std::memory_order_acquire);
+		if (m_stop.load())
+			return;
+
+		for (; allocated < std::min(requested, m_maxChunks); allocated++)
+		{
+			m_chunks[allocated] = memory::allocAligned(static_cast<std::size_t>(m_chunkFrames) * m_channels);
+			m_allocated.store(allocated + 1, std::memory_order_release);
+			m_allocated.notify_all();
+		}
+
+		m_requested.wait(requested, std::memory_order_acquire);
+	}
+}
+
+/* -------------------------------------------------------------------------- */
+
+float* RecordingBuffer::getChunkData(int i) const
+{
+	return m_chunks[i];
+}
+} // namespace mcl
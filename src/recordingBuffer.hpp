@@ -0,0 +1,161 @@
+/* -----------------------------------------------------------------------------
+ *
+ * AudioBuffer
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2021 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of AudioBuffer.
+ *
+ * AudioBuffer is free software: you can redistribute it and/or modify it under 
+ * the terms of the GNU General Public License as published by the Free Software 
+ * Foundation, either version 3 of the License, or (at your option) any later 
+ * version.
+ *
+ * AudioBuffer is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS 
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more 
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with 
+ * AudioBuffer. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+#ifndef MONOCASUAL_RECORDING_BUFFER_H
+#define MONOCASUAL_RECORDING_BUFFER_H
+
+#include "audioBuffer.hpp"
+#include "audioBufferView.hpp"
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace mcl
+{
+/* RecordingBuffer
+An append-only buffer for recording live input of unknown length. Audio is 
+stored in fixed-size chunks that are never moved nor copied once written, so 
+growing the take costs the same at any length. Chunks are allocated ahead of
+time by a background thread owned by the buffer: the audio thread only writes
+samples and bumps counters, it never allocates nor waits.
+
+Exactly one thread (the producer) may call append() and reset(). Any thread
+can read the frames recorded so far, at the same time, through getChunk(),
+copyTo() or toAudioBuffer(). */
+
+class RecordingBuffer
+{
+public:
+	static constexpr int DEFAULT_CHUNK_FRAMES = 65536;
+	static constexpr int DEFAULT_SPARE_CHUNKS = 2;
+
+	/* RecordingBuffer
+	Prepares a buffer for up to 'maxFrames' frames of 'channels' channels, 
+	stored in chunks of 'chunkFrames' frames. The allocator thread keeps 
+	'spareChunks' chunks ready beyond the one being written; the first ones are
+	allocated before the constructor returns, so that recording can start 
+	straight away. Memory for 'maxFrames' is NOT allocated up front. */
+
+	RecordingBuffer(int channels, int maxFrames, int chunkFrames = DEFAULT_CHUNK_FRAMES,
+	    int spareChunks = DEFAULT_SPARE_CHUNKS);
+	RecordingBuffer(const RecordingBuffer&) = delete;
+	~RecordingBuffer();
+
+	RecordingBuffer& operator=(const RecordingBuffer&) = delete;
+
+	int countChannels() const;
+	int countChunkFrames() const;
+	int getMaxFrames() const;
+
+	/* countFrames
+	Returns how many frames have been recorded so far. Frames below this value
+	are safe to read from any thread. */
+
+	int countFrames() const;
+
+	/* getCapacity
+	Returns how many frames can be appended without waiting for the allocator
+	thread. The value might be outdated as soon as it's returned. */
+
+	int getCapacity() const;
+
+	/* append [producer]
+	Copies 'src' at the end of the recording. Returns the amount of frames
+	appended, which is less than src.countFrames() if the allocator thread is
+	lagging behind (try a larger 'spareChunks' or chunk size) or 'maxFrames' 
+	has been reached. Channels MUST match. */
+
+	int append(AudioBufferView src);
+
+	/* reset [producer]
+	Starts a new recording from frame 0. Allocated chunks are kept for reuse.
+	Readers MUST be done with the previous take. */
+
+	void reset();
+
+	/* reserve
+	Blocks until the buffer can hold 'frames' frames without waiting for the 
+	allocator thread. Don't call it from the audio thread. */
+
+	void reserve(int frames);
+
+	/* countChunks, getChunk
+	The recording as a sequence of views, one per chunk: all of them are 
+	countChunkFrames() long, except for the last one which holds the remaining
+	frames. */
+
+	int             countChunks() const;
+	AudioBufferView getChunk(int i) const;
+
+	/* getChunks
+	All the chunks at once, from a single reading of countFrames(): a 
+	consistent snapshot while recording goes on, e.g. for updating a 
+	PeakPyramid as the take grows. It allocates. */
+
+	std::vector<AudioBufferView> getChunks() const;
+
+	/* copyTo
+	Copies recorded frames starting from 'offset' onto 'dest'. Returns the 
+	amount of frames copied, limited by both the recording and 'dest' length. */
+
+	int copyTo(AudioBufferView dest, int offset = 0) const;
+
+	/* toAudioBuffer
+	Returns the recording so far as a contiguous AudioBuffer. This is the only
+	point where the whole take is copied, once. It allocates: don't call it from
+	the audio thread. */
+
+	AudioBuffer toAudioBuffer() const;
+
+private:
+	/* requestChunks
+	Asks the allocator thread to have at least 'count' chunks ready. */
+
+	void requestChunks(int count);
+
+	/* runAllocator
+	Body of the allocator thread. It sleeps until more chunks are requested or
+	the buffer is destroyed. */
+
+	void runAllocator();
+
+	float* getChunkData(int i) const;
+
+	std::unique_ptr<float*[]> m_chunks;
+	int                       m_channels;
+	int                       m_chunkFrames;
+	int                       m_maxChunks;
+	int                       m_spareChunks;
+	std::atomic<int>          m_frames;
+	std::atomic<int>          m_requested;
+	std::atomic<int>          m_allocated;
+	std::atomic<bool>         m_stop;
+	std::thread               m_allocator;
+};
+} // namespace mcl
+
+#endif
@@ -1,6 +1,10 @@
 #include "src/audioBuffer.hpp"
+#include <array>
 #include <catch2/catch_test_macros.hpp>
+#include <cstdint>
 #include <iostream>
+#include <type_traits>
+#include <utility>
 
 using namespace mcl;
 
@@ -70,6 +74,39 @@ TEST_CASE("AudioBuffer")
 			REQUIRE(buffer.countChannels() == 2);
 		}
 
+		SECTION("test multichannel")
+		{
+			buffer.alloc(BUFFER_SIZE, 8);
+			REQUIRE(buffer.countFrames() == BUFFER_SIZE);
+			REQUIRE(buffer.countSamples() == BUFFER_SIZE * 8);
+			REQUIRE(buffer.countChannels() == 8);
+
+			AudioBuffer mono(BUFFER_SIZE, 1);
+			mono[10][0] = 2.0f;
+			buffer.set(mono, 0.5f);
+			for (int ch = 0; ch < 8; ch++)
+				REQUIRE(buffer[10][ch] == 1.0f);
+
+			mono.set(buffer.view()); // 8 channels folded onto one
+			REQUIRE(mono[10][0] == 1.0f);
+		}
+
+		SECTION("test alignment")
+		{
+			REQUIRE(reinterpret_cast<std::uintptr_t>(buffer[0]) % memory::ALIGNMENT == 0);
+		}
+
+		SECTION("test init")
+		{
+			buffer.alloc(BUFFER_SIZE, 2, AudioBuffer::Init::ZERO);
+			REQUIRE(buffer.getPeak(0) == 0.0f);
+			REQUIRE(buffer.getPeak(1) == 0.0f);
+
+			buffer.alloc(BUFFER_SIZE, 2, AudioBuffer::Init::UNINITIALIZED);
+			REQUIRE(buffer.countFrames() == BUFFER_SIZE);
+			REQUIRE(buffer.countChannels() == 2);
+		}
+
 		buffer.free();
 
 		REQUIRE(buffer.countFrames() == 0);
@@ -130,6 +167,75 @@ TEST_CASE("AudioBuffer")
 		}
 	}
 
+	SECTION("test capacity")
+	{
+		float* data = buffer[0];
+
+		REQUIRE(buffer.getCapacity() >= BUFFER_SIZE * 2);
+
+		SECTION("alloc reuses memory")
+		{
+			buffer.alloc(BUFFER_SIZE / 2, 2);
+
+			REQUIRE(buffer[0] == data);
+			REQUIRE(buffer.countFrames() == BUFFER_SIZE / 2);
+			REQUIRE(buffer.getPeak(0) == 0.0f);
+		}
+
+		SECTION("copy assignment reuses memory")
+		{
+			AudioBuffer other(BUFFER_SIZE / 4, 1);
+			other.forEachFrame([](float* channels, int numFrame) {
+				channels[0] = static_cast<float>(numFrame);
+			});
+
+			buffer = other;
+
+			REQUIRE(buffer[0] == data);
+			REQUIRE(buffer.countFrames() == BUFFER_SIZE / 4);
+			REQUIRE(buffer.countChannels() == 1);
+			REQUIRE(buffer[10][0] == 10.0f);
+		}
+
+		SECTION("resize keeps content")
+		{
+			buffer.resize(BUFFER_SIZE / 2);
+
+			REQUIRE(buffer[0] == data);
+			REQUIRE(buffer.countFrames() == BUFFER_SIZE / 2);
+
+			buffer.resize(BUFFER_SIZE * 2);
+
+			REQUIRE(buffer.countFrames() == BUFFER_SIZE * 2);
+			REQUIRE(buffer[BUFFER_SIZE / 2 - 1][1] == static_cast<float>(BUFFER_SIZE / 2 - 1));
+			REQUIRE(buffer[BUFFER_SIZE / 2][1] == 0.0f);
+			REQUIRE(buffer[BUFFER_SIZE * 2 - 1][1] == 0.0f);
+		}
+
+		SECTION("reserve keeps content")
+		{
+			buffer.reserve(BUFFER_SIZE * 4, 2);
+
+			REQUIRE(buffer.getCapacity() >= BUFFER_SIZE * 8);
+			REQUIRE(buffer.countFrames() == BUFFER_SIZE);
+			REQUIRE(buffer[BUFFER_SIZE - 1][0] == static_cast<float>(BUFFER_SIZE - 1));
+
+			data = buffer[0];
+			buffer.resize(BUFFER_SIZE * 4);
+
+			REQUIRE(buffer[0] == data);
+		}
+
+		SECTION("shrink to fit")
+		{
+			buffer.resize(16);
+			buffer.shrinkToFit();
+
+			REQUIRE(buffer.getCapacity() == 32);
+			REQUIRE(buffer[15][0] == 15.0f);
+		}
+	}
+
 	SECTION("test move")
 	{
 		constexpr int numChannels = 2;
@@ -158,6 +264,158 @@ TEST_CASE("AudioBuffer")
 		}
 	}
 
+	SECTION("test sum and set")
+	{
+		SECTION("stereo onto stereo")
+		{
+			AudioBuffer other(BUFFER_SIZE, 2);
+			other.set(buffer, 0.5f, {1.0f, 0.5f});
+			other.sum(buffer, 1.0f, {0.0f, 1.0f});
+
+			for (int i = 0; i < BUFFER_SIZE; i++)
+			{
+				REQUIRE(other[i][0] == static_cast<float>(i) * 0.5f);
+				REQUIRE(other[i][1] == static_cast<float>(i) * 1.25f);
+			}
+		}
+
+		SECTION("mono onto stereo")
+		{
+			AudioBuffer mono(BUFFER_SIZE, 1);
+			mono.forEachFrame([](float* channels, int numFrame) {
+				channels[0] = static_cast<float>(numFrame);
+			});
+
+			buffer.sum(mono, 2.0f, {1.0f, 0.5f});
+
+			for (int i = 0; i < BUFFER_SIZE; i++)
+			{
+				REQUIRE(buffer[i][0] == static_cast<float>(i) * 3.0f);
+				REQUIRE(buffer[i][1] == static_cast<float>(i) * 2.0f);
+			}
+		}
+
+		SECTION("mono onto mono")
+		{
+			AudioBuffer a(BUFFER_SIZE, 1);
+			AudioBuffer b(BUFFER_SIZE, 1);
+			a.forEachFrame([](float* channels, int numFrame) {
+				channels[0] = static_cast<float>(numFrame);
+			});
+
+			b.set(a, 0.5f);
+			b.sum(a, 0.5f, {2.0f, 0.0f});
+
+			for (int i = 0; i < BUFFER_SIZE; i++)
+				REQUIRE(b[i][0] == static_cast<float>(i) * 1.5f);
+		}
+
+		SECTION("with offsets")
+		{
+			AudioBuffer other(BUFFER_SIZE, 2);
+			other.set(buffer, 16, 8, 4);
+
+			for (int i = 0; i < BUFFER_SIZE; i++)
+			{
+				const float expected = i >= 4 && i < 20 ? static_cast<float>(i + 4) : 0.0f;
+				REQUIRE(other[i][0] == expected);
+				REQUIRE(other[i][1] == expected);
+			}
+		}
+
+		SECTION("with source shorter than offset + frames")
+		{
+			AudioBuffer other(BUFFER_SIZE, 2);
+			other.set(buffer, -1, BUFFER_SIZE - 10, 0);
+
+			REQUIRE(other[9][0] == static_cast<float>(BUFFER_SIZE - 1));
+			REQUIRE(other[10][0] == 0.0f);
+		}
+	}
+
+	SECTION("test gain ramps")
+	{
+		AudioBuffer other(BUFFER_SIZE, 2);
+		other.set(buffer, {0.0f, 1.0f});
+		other.applyGain({2.0f, 2.0f});
+
+		REQUIRE(other[0][0] == 0.0f);
+		REQUIRE(other[BUFFER_SIZE / 2][1] == static_cast<float>(BUFFER_SIZE / 2));
+
+		buffer.applyGain({1.0f, 0.0f});
+
+		REQUIRE(buffer[1][0] == 1.0f - 1.0f / BUFFER_SIZE);
+		REQUIRE(buffer[BUFFER_SIZE / 2][1] == static_cast<float>(BUFFER_SIZE / 4));
+	}
+
+	SECTION("test fades")
+	{
+		AudioBuffer other(buffer);
+		other.fadeOut(FadeCurve::LINEAR);
+
+		REQUIRE(std::as_const(other)[0][0] == 0.0f);
+		REQUIRE(std::as_const(other)[BUFFER_SIZE / 2][1] == static_cast<float>(BUFFER_SIZE / 4));
+
+		AudioBuffer mix(BUFFER_SIZE, 2);
+		mix.crossfade(other.view(), buffer.view(), FadeCurve::LINEAR, BUFFER_SIZE / 2);
+
+		REQUIRE(!mix.isSilent());
+		REQUIRE(std::as_const(mix)[BUFFER_SIZE / 2][0] == static_cast<float>(BUFFER_SIZE / 2));
+	}
+
+	SECTION("test iteration")
+	{
+		SECTION("with std::function")
+		{
+			std::function<void(float&, int)> f = [](float& value, int numSample) {
+				value = static_cast<float>(numSample);
+			};
+			buffer.forEachSample(f);
+
+			for (int i = 0; i < BUFFER_SIZE; i++)
+				REQUIRE(buffer[i][1] == static_cast<float>(i * 2 + 1));
+		}
+
+		SECTION("with raw pointers")
+		{
+			const AudioBuffer& readOnly = buffer;
+
+			REQUIRE(readOnly.getStride() == 2);
+			REQUIRE(readOnly.getData() == readOnly[0]);
+			REQUIRE(readOnly.getFrameUnchecked(10) == readOnly[10]);
+
+			buffer.clear();
+			REQUIRE(buffer.isSilent());
+
+			buffer.getData()[BUFFER_SIZE] = 1.0f; // Marks the whole buffer as dirty
+
+			REQUIRE(!buffer.isSilent());
+			REQUIRE(buffer.getPeak(0, BUFFER_SIZE / 2) == 1.0f);
+		}
+
+		SECTION("with any callable")
+		{
+			int sum = 0;
+			buffer.forEachChannel(3, [&sum](float& value, int) { sum += static_cast<int>(value); });
+
+			REQUIRE(sum == 6);
+		}
+
+		SECTION("by block")
+		{
+			int frames = 0, blocks = 0;
+			buffer.forEachBlock(1000, [&](std::span<float> samples, int firstFrame) {
+				REQUIRE(firstFrame == frames);
+				REQUIRE(samples[0] == static_cast<float>(firstFrame));
+				frames += static_cast<int>(samples.size()) / buffer.countChannels();
+				blocks++;
+			});
+
+			REQUIRE(frames == BUFFER_SIZE);
+			REQUIRE(blocks == 5);
+		}
+	}
+
 	SECTION("test view")
 	{
 		constexpr int bufferSize  = 1024;
@@ -165,5 +423,185 @@ TEST_CASE("AudioBuffer")
 
 		std::unique_ptr<float[]> raw = std::make_unique<float[]>(bufferSize);
 		AudioBuffer              buf(raw.get(), bufferSize, numChannels);
+
+		SECTION("copy owns its data")
+		{
+			AudioBuffer other(buf);
+			other[0][0] = 1.0f;
+
+			REQUIRE(other[0] != raw.get());
+			REQUIRE(raw[0] == 0.0f);
+		}
+
+		SECTION("assignment doesn't free viewed data")
+		{
+			buf = AudioBuffer(bufferSize, numChannels);
+			raw[0] = 1.0f;
+
+			REQUIRE(buf[0][0] == 0.0f);
+		}
+	}
+
+	SECTION("test sum and set from view")
+	{
+		AudioBuffer other(BUFFER_SIZE, 2);
+		other.view().slice(10, 4).set(buffer.view().slice(100), 2.0f);
+		other.sum(buffer.view().channel(1).slice(5, 1));
+
+		REQUIRE(other[0][0] == 5.0f);
+		REQUIRE(other[0][1] == 5.0f);
+		REQUIRE(other[1][0] == 0.0f);
+		REQUIRE(other[9][0] == 0.0f);
+		REQUIRE(other[10][0] == 200.0f);
+		REQUIRE(other[13][1] == 206.0f);
+		REQUIRE(other[14][1] == 0.0f);
+	}
+
+	SECTION("test silence tracking")
+	{
+		/* Reads go through const references, which leave the dirty range 
+		alone. */
+
+		AudioBuffer        silent(BUFFER_SIZE, 2);
+		AudioBuffer        other(buffer);
+		const AudioBuffer& otherRead = other;
+
+		REQUIRE(silent.isSilent());
+		REQUIRE(!other.isSilent());
+
+		other.sum(silent, 1.0f);
+		REQUIRE(otherRead[10][0] == 10.0f);
+
+		other.set(silent, 1.0f);
+		REQUIRE(other.isSilent());
+		REQUIRE(otherRead[10][0] == 0.0f);
+
+		SECTION("partially dirty source")
+		{
+			silent.sum(buffer, 10, 100, 200);
+			REQUIRE(silent.isSilent(0, 200));
+			REQUIRE(!silent.isSilent(200, 210));
+			REQUIRE(silent.isSilent(210));
+
+			AudioBuffer copy(buffer);
+			copy.set(silent, 1.0f);
+			REQUIRE(std::as_const(copy)[199][0] == 0.0f);
+			REQUIRE(std::as_const(copy)[200][0] == 100.0f);
+			REQUIRE(std::as_const(copy)[210][1] == 0.0f);
+			REQUIRE(copy.isSilent(0, 200));
+			REQUIRE(copy.isSilent(210));
+
+			copy.clear(200, 205);
+			REQUIRE(copy.isSilent(0, 205));
+			copy.clear();
+			REQUIRE(copy.isSilent());
+		}
+
+		SECTION("gain, analysis and resize")
+		{
+			other.set(buffer, 1.0f);
+			other.applyGain(0.5f);
+			REQUIRE(otherRead[10][1] == 5.0f);
+			other.applyGain(0.0f);
+			REQUIRE(other.isSilent());
+			REQUIRE(otherRead[10][1] == 0.0f);
+			REQUIRE(other.getPeak(0) == 0.0f);
+
+			std::array<ChannelStats, 2> stats;
+			stats[0].peak = 1.0f;
+			other.analyze(stats);
+			REQUIRE(stats[0].peak == 0.0f);
+
+			other.resize(BUFFER_SIZE * 2);
+			REQUIRE(other.isSilent());
+			other.resize(BUFFER_SIZE * 3, AudioBuffer::Init::UNINITIALIZED);
+			REQUIRE(other.isSilent(0, BUFFER_SIZE * 2));
+			REQUIRE(!other.isSilent());
+		}
+
+		SECTION("untracked writes")
+		{
+			silent.view().slice(5, 1).channel(0).set(buffer.view().slice(1, 1));
+			REQUIRE(!silent.isSilent());
+			silent.clear();
+			REQUIRE(silent.isSilent());
+
+			silent[0][0] = 1.0f;
+			REQUIRE(!silent.isSilent());
+			silent.clear();
+
+			silent[BUFFER_SIZE - 1][1] = 1.0f;
+			REQUIRE(!silent.isSilent());
+			REQUIRE(!silent.isSilent(0, 1)); // Whole buffer, not just the frame written
+			silent.clear();
+
+			/* A ranged view dirties only the frames it covers. */
+
+			AudioBufferView block = silent.view(10, 5);
+			REQUIRE(block.countFrames() == 5);
+			block.getFrameUnchecked(4)[1] = 1.0f;
+			REQUIRE(silent.isSilent(0, 10));
+			REQUIRE(!silent.isSilent(10, 15));
+			REQUIRE(silent.isSilent(15));
+			REQUIRE(std::as_const(silent)[14][1] == 1.0f);
+
+			float       data[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+			AudioBuffer viewing(data, 2, 2);
+			viewing.clear();
+			REQUIRE(!viewing.isSilent()); // Data is owned by someone else
+			REQUIRE(data[3] == 0.0f);
+		}
+	}
+
+	SECTION("test shared storage")
+	{
+		AudioBuffer::reclaimShared(); // Leftovers from other tests
+
+		AudioBuffer shared(buffer);
+		shared.makeShared();
+
+		AudioBuffer a(shared), b;
+		b = shared;
+
+		REQUIRE(a.isShared());
+		REQUIRE(b.isShared());
+		REQUIRE(std::as_const(a)[0] == std::as_const(shared)[0]);
+		REQUIRE(std::as_const(b)[0] == std::as_const(shared)[0]);
+
+		a.applyGain(2.0f); // Copy on write
+		REQUIRE(!a.isShared());
+		REQUIRE(std::as_const(a)[0] != std::as_const(shared)[0]);
+		REQUIRE(std::as_const(a)[10][0] == 20.0f);
+		REQUIRE(std::as_const(b)[10][0] == 10.0f);
+
+		a.set(b, 1.0f); // Reading doesn't detach the source
+		REQUIRE(b.isShared());
+		REQUIRE(std::as_const(a)[10][0] == 10.0f);
+
+		/* The const accessor is read-only: writing goes through the non-const
+		one, which detaches. */
+
+		static_assert(std::is_same_v<decltype(std::as_const(b)[0]), const float*>);
+		static_assert(std::is_same_v<decltype(b[0]), float*>);
+
+		AudioBuffer c(shared);
+		c[10][0] = -1.0f;
+		REQUIRE(!c.isShared());
+		REQUIRE(std::as_const(c)[10][0] == -1.0f);
+		REQUIRE(std::as_const(b)[10][0] == 10.0f);
+		REQUIRE(std::as_const(shared)[10][0] == 10.0f);
+
+		shared.free();
+		REQUIRE(AudioBuffer::reclaimShared() == 0); // Still referenced by 'b'
+
+		const float* data = std::as_const(b)[0];
+		b[1][1]     = 3.0f; // Last holder: takes the memory over
+		REQUIRE(!b.isShared());
+		REQUIRE(std::as_const(b)[0] == data);
+		REQUIRE(data[3] == 3.0f);
+
+		b.makeShared();
+		b.free();
+		REQUIRE(AudioBuffer::reclaimShared() == 2);
 	}
 }
@@ -0,0 +1,101 @@
+#include "src/audioBufferPool.hpp"
+#include <atomic>
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <set>
+#include <thread>
+#include <vector>
+
+using namespace mcl;
+
+TEST_CASE("AudioBufferPool")
+{
+	static const int NUM_BUFFERS = 8;
+	static const int BUFFER_SIZE = 100;
+
+	AudioBufferPool pool(NUM_BUFFERS, BUFFER_SIZE, 2);
+
+	SECTION("test properties")
+	{
+		REQUIRE(pool.countBuffers() == NUM_BUFFERS);
+		REQUIRE(pool.countFrames() == BUFFER_SIZE);
+		REQUIRE(pool.countChannels() == 2);
+		REQUIRE(pool.countAvailable() == NUM_BUFFERS);
+	}
+
+	SECTION("test acquire and release")
+	{
+		std::vector<AudioBufferPool::Lease> leases;
+		std::set<float*>                    pointers;
+
+		for (int i = 0; i < NUM_BUFFERS; i++)
+		{
+			leases.push_back(pool.acquire());
+
+			AudioBufferView view = leases.back().view();
+
+			REQUIRE(leases.back().isValid());
+			REQUIRE(view.countFrames() == BUFFER_SIZE);
+			REQUIRE(view.countChannels() == 2);
+			REQUIRE(view.getPeak(0) == 0.0f);
+			REQUIRE(reinterpret_cast<std::uintptr_t>(view.getData()) % memory::ALIGNMENT == 0);
+
+			pointers.insert(view.getData());
+		}
+
+		REQUIRE(pointers.size() == NUM_BUFFERS);
+		REQUIRE(pool.countAvailable() == 0);
+		REQUIRE(!pool.acquire().isValid());
+
+		leases[3].release();
+
+		REQUIRE(!leases[3].isValid());
+		REQUIRE(pool.countAvailable() == 1);
+
+		leases.clear();
+
+		REQUIRE(pool.countAvailable() == NUM_BUFFERS);
+	}
+
+	SECTION("test lease move")
+	{
+		AudioBufferPool::Lease a = pool.acquire();
+		AudioBufferPool::Lease b = std::move(a);
+
+		REQUIRE(!a.isValid());
+		REQUIRE(b.isValid());
+		REQUIRE(pool.countAvailable() == NUM_BUFFERS - 1);
+
+		b = pool.acquire();
+
+		REQUIRE(pool.countAvailable() == NUM_BUFFERS - 1);
+	}
+
+	SECTION("test concurrent use")
+	{
+		std::atomic<int> errors = 0;
+
+		auto worker = [&pool, &errors](float id) {
+			for (int i = 0; i < 10000; i++)
+			{
+				AudioBufferPool::Lease lease = pool.acquire(AudioBuffer::Init::UNINITIALIZED);
+				if (!lease.isValid())
+					continue;
+				AudioBufferView view = lease.view();
+				view[0][0]           = id;
+				if (view[0][0] != id) // Catch2 assertions are not thread-safe
+					errors++;
+			}
+		};
+
+		std::thread t1(worker, 1.0f);
+		std::thread t2(worker, 2.0f);
+		std::thread t3(worker, 3.0f);
+		t1.join();
+		t2.join();
+		t3.join();
+
+		REQUIRE(errors == 0);
+		REQUIRE(pool.countAvailable() == NUM_BUFFERS);
+	}
+}
@@ -0,0 +1,501 @@
+#include "src/audioBufferView.hpp"
+#include <algorithm>
+#include <array>
+#include <catch2/catch_approx.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+using namespace mcl;
+
+TEST_CASE("AudioBufferView")
+{
+	static const int FRAMES = 256;
+
+	std::vector<float> data(FRAMES * 2);
+	for (int i = 0; i < FRAMES * 2; i++)
+		data[i] = static_cast<float>(i);
+
+	AudioBufferView view(data.data(), FRAMES, 2);
+
+	SECTION("test properties")
+	{
+		REQUIRE(view.countFrames() == FRAMES);
+		REQUIRE(view.countChannels() == 2);
+		REQUIRE(view.getStride() == 2);
+		REQUIRE(view.isContiguous());
+		REQUIRE(!view.isEmpty());
+		REQUIRE(AudioBufferView().isEmpty());
+	}
+
+	SECTION("test raw access")
+	{
+		AudioBufferView right = view.channel(1).slice(4);
+
+		REQUIRE(right.getData() == data.data() + 9);
+		REQUIRE(right.getStride() == 2);
+		REQUIRE(right.getFrameUnchecked(0) == right[0]);
+		REQUIRE(right.getFrameUnchecked(10)[0] == 29.0f);
+	}
+
+	SECTION("test slice")
+	{
+		AudioBufferView s = view.slice(10, 20);
+
+		REQUIRE(s.countFrames() == 20);
+		REQUIRE(s[0][0] == 20.0f);
+		REQUIRE(s[19][1] == 59.0f);
+		REQUIRE(s.slice(5).countFrames() == 15);
+		REQUIRE(view.slice(FRAMES).isEmpty());
+	}
+
+	SECTION("test channel")
+	{
+		AudioBufferView right = view.channel(1);
+
+		REQUIRE(right.countChannels() == 1);
+		REQUIRE(!right.isContiguous());
+		REQUIRE(right[3][0] == 7.0f);
+		REQUIRE(right.getPeak(0) == static_cast<float>(FRAMES * 2 - 1));
+	}
+
+	SECTION("test analyze")
+	{
+		data[6] = -1000.0f;
+
+		std::array<ChannelStats, 2> stats;
+		view.slice(0, 4).analyze(stats, 5.0f);
+
+		REQUIRE(stats[0].min == -1000.0f);
+		REQUIRE(stats[0].max == 4.0f);
+		REQUIRE(stats[0].peak == 1000.0f);
+		REQUIRE(stats[0].sumSquares == 1000020.0);
+		REQUIRE(stats[0].rms == Catch::Approx(std::sqrt(1000020.0 / 4)));
+		REQUIRE(stats[0].clipped == 1);
+		REQUIRE(stats[1].min == 1.0f);
+		REQUIRE(stats[1].peak == 7.0f);
+		REQUIRE(stats[1].clipped == 1);
+
+		view.channel(0).slice(0, 4).analyze(stats, 5.0f);
+
+		REQUIRE(stats[0].peak == 1000.0f);
+		REQUIRE(stats[0].sumSquares == 1000020.0);
+
+		view.slice(0, 0).analyze(stats);
+
+		REQUIRE(stats[0].peak == 0.0f);
+		REQUIRE(stats[1].min == 0.0f);
+		REQUIRE(view.getPeak(0) == 1000.0f);
+	}
+
+	SECTION("test clear")
+	{
+		view.slice(1, 2).clear();
+
+		REQUIRE(data[1] == 1.0f);
+		REQUIRE(data[2] == 0.0f);
+		REQUIRE(data[5] == 0.0f);
+		REQUIRE(data[6] == 6.0f);
+
+		view.channel(0).clear();
+
+		REQUIRE(data[0] == 0.0f);
+		REQUIRE(data[7] == 7.0f);
+	}
+
+	SECTION("test applyGain")
+	{
+		view.channel(1).applyGain(2.0f);
+
+		REQUIRE(data[0] == 0.0f);
+		REQUIRE(data[1] == 2.0f);
+		REQUIRE(data[2] == 2.0f);
+		REQUIRE(data[3] == 6.0f);
+
+		view.slice(0, 1).applyGain(0.0f);
+
+		REQUIRE(data[1] == 0.0f);
+		REQUIRE(data[2] == 2.0f);
+	}
+
+	SECTION("test applyGain with ramp")
+	{
+		std::vector<float> ones(FRAMES * 2, 1.0f);
+		AudioBufferView    v(ones.data(), FRAMES, 2);
+
+		/* Two consecutive blocks must join seamlessly. */
+
+		v.slice(0, FRAMES / 2).applyGain({0.0f, 0.5f});
+		v.slice(FRAMES / 2).applyGain({0.5f, 1.0f});
+
+		for (int i = 0; i < FRAMES; i++)
+			REQUIRE(ones[i * 2] == Catch::Approx(static_cast<float>(i) / FRAMES).margin(1e-6));
+
+		v.channel(1).applyGain({2.0f, 2.0f});
+
+		REQUIRE(ones[0] == 0.0f);
+		REQUIRE(ones[1] == 0.0f);
+		REQUIRE(ones[(FRAMES - 1) * 2 + 1] == Catch::Approx(ones[(FRAMES - 1) * 2] * 2.0f));
+	}
+
+	SECTION("test fades")
+	{
+		std::vector<float> ones(FRAMES * 2, 1.0f);
+		AudioBufferView    v(ones.data(), FRAMES, 2);
+
+		SECTION("fade in, split over blocks")
+		{
+			v.slice(0, 100).fadeIn(FadeCurve::LINEAR, FRAMES);
+			v.slice(100).fadeIn(FadeCurve::LINEAR, FRAMES, 100);
+
+			for (int i = 0; i < FRAMES; i++)
+			{
+				REQUIRE(ones[i * 2] == Catch::Approx(static_cast<float>(i) / FRAMES).margin(1e-6));
+				REQUIRE(ones[i * 2 + 1] == ones[i * 2]);
+			}
+		}
+
+		SECTION("long fade, split over uneven blocks")
+		{
+			const int          length = 10000;
+			std::vector<float> whole(length, 1.0f), split(length, 1.0f);
+
+			AudioBufferView(whole.data(), length, 1).fadeIn(FadeCurve::EXPONENTIAL);
+			for (int f = 0; f < length; f += 333)
+				AudioBufferView(split.data() + f, std::min(333, length - f), 1).fadeIn(FadeCurve::EXPONENTIAL, length, f);
+
+			REQUIRE(split == whole);
+			REQUIRE(whole[0] == 0.0f);
+			REQUIRE(whole[length / 3] == Catch::Approx(0.0091f).margin(1e-4)); // -40 dB
+		}
+
+		SECTION("fade out, shorter than the view")
+		{
+			v.fadeOut(FadeCurve::EXPONENTIAL, 64);
+
+			REQUIRE(ones[0] == 1.0f);
+			REQUIRE(ones[32 * 2] < 0.1f); // 30 dB down halfway
+			REQUIRE(ones[63 * 2] > 0.0f);
+			REQUIRE(std::all_of(ones.begin() + 64 * 2, ones.end(), [](float f) { return f == 0.0f; }));
+		}
+
+		SECTION("strided view")
+		{
+			v.channel(1).fadeIn(FadeCurve::EQUAL_POWER);
+
+			REQUIRE(ones[0] == 1.0f);
+			REQUIRE(ones[1] == 0.0f);
+			REQUIRE(ones[FRAMES] == 1.0f);
+			REQUIRE(ones[FRAMES + 1] == Catch::Approx(std::sqrt(0.5f)).margin(1e-4));
+		}
+
+		SECTION("equal power crossfade")
+		{
+			std::vector<float> zeros(FRAMES * 2, 0.0f), out(FRAMES * 2);
+			AudioBufferView    z(zeros.data(), FRAMES, 2);
+			AudioBufferView    o(out.data(), FRAMES, 2);
+
+			/* With one source silent the output is the gain curve. */
+
+			o.crossfade(v, z, FadeCurve::EQUAL_POWER);
+			std::vector<float> from = out;
+			o.crossfade(z, v, FadeCurve::EQUAL_POWER);
+
+			REQUIRE(from[0] == 1.0f);
+			REQUIRE(out[0] == 0.0f);
+			for (int i = 0; i < FRAMES * 2; i++)
+				REQUIRE(from[i] * from[i] + out[i] * out[i] == Catch::Approx(1.0f).margin(1e-4));
+
+			/* In place, onto one of the sources. */
+
+			o.crossfade(o, v, FadeCurve::LINEAR);
+			REQUIRE(out[0] == 0.0f);
+			REQUIRE(out[FRAMES] == Catch::Approx(0.5f + 0.5f * std::sqrt(0.5f)).margin(1e-4));
+		}
+	}
+
+	SECTION("test PCM")
+	{
+		std::vector<std::int16_t> pcm(FRAMES * 2);
+		for (int i = 0; i < FRAMES * 2; i++)
+			pcm[i] = static_cast<std::int16_t>(i * 100 - 20000);
+
+		SECTION("round trip")
+		{
+			view.setFromPcm(pcm.data(), PcmFormat::INT16, FRAMES, 2);
+
+			REQUIRE(data[0] == -20000.0f / 32768.0f);
+			REQUIRE(data[3] == -19700.0f / 32768.0f);
+
+			std::vector<std::int16_t> out(FRAMES * 2);
+			view.writeToPcm(out.data(), PcmFormat::INT16);
+
+			REQUIRE(out == pcm);
+		}
+
+		SECTION("mono source is spread")
+		{
+			view.setFromPcm(pcm.data(), PcmFormat::INT16, FRAMES * 2, 1);
+
+			REQUIRE(data[2] == -19900.0f / 32768.0f);
+			REQUIRE(data[3] == data[2]);
+		}
+
+		SECTION("strided view, float formats")
+		{
+			std::vector<double> doubles = {0.5, -0.25, 1.5};
+			view.channel(1).setFromPcm(doubles.data(), PcmFormat::FLOAT64, 3, 1);
+
+			REQUIRE(data[1] == 0.5f);
+			REQUIRE(data[5] == 1.5f);
+			REQUIRE(data[2] == 2.0f); // Left channel untouched
+
+			std::vector<float> floats(3);
+			view.channel(1).slice(0, 3).writeToPcm(floats.data(), PcmFormat::FLOAT32);
+
+			REQUIRE(floats == std::vector<float>{0.5f, -0.25f, 1.5f});
+		}
+
+		SECTION("dither")
+		{
+			view.clear();
+
+			Dither                    ditherA(1.0f, 42), ditherB(1.0f, 42);
+			std::vector<std::int16_t> a(FRAMES * 2), b(FRAMES * 2);
+			view.writeToPcm(a.data(), PcmFormat::INT16, &ditherA);
+			view.writeToPcm(b.data(), PcmFormat::INT16, &ditherB);
+
+			int nonZero = 0;
+			for (std::int16_t v : a)
+			{
+				REQUIRE((v >= -1 && v <= 1)); // TPDF noise stays within 1 LSB
+				nonZero += v != 0 ? 1 : 0;
+			}
+
+			REQUIRE(a == b); // Same seed, same noise
+			REQUIRE(nonZero > 0);
+		}
+	}
+
+	SECTION("test sum and set")
+	{
+		std::vector<float> other(FRAMES * 2, 1.0f);
+		AudioBufferView    dest(other.data(), FRAMES, 2);
+
+		SECTION("stereo onto stereo")
+		{
+			dest.sum(view, 0.5f, {1.0f, 0.0f});
+
+			REQUIRE(other[0] == 1.0f);
+			REQUIRE(other[2] == 2.0f);
+			REQUIRE(other[3] == 1.0f);
+		}
+
+		SECTION("mono channel onto stereo")
+		{
+			dest.set(view.channel(1).slice(1));
+
+			REQUIRE(other[0] == 3.0f);
+			REQUIRE(other[1] == 3.0f);
+			REQUIRE(other[(FRAMES - 2) * 2] == static_cast<float>(FRAMES * 2 - 1));
+			REQUIRE(other[(FRAMES - 1) * 2] == 1.0f); // Source is one frame shorter
+		}
+
+		SECTION("multiple sources")
+		{
+			const int          frames = FRAMES * 4; // Spans multiple tiles
+			std::vector<float> mono(frames);
+			for (int i = 0; i < frames; i++)
+				mono[i] = static_cast<float>(i % 17);
+
+			std::vector<float> a(frames * 2, 1.0f), b(frames * 2, 1.0f);
+			AudioBufferView    destA(a.data(), frames, 2);
+			AudioBufferView    destB(b.data(), frames, 2);
+			AudioBufferView    monoView(mono.data(), frames, 1);
+
+			const MixSource sources[] = {
+			    {view, 0.5f, {1.0f, 0.25f}, 0},
+			    {monoView.slice(3), 2.0f, {0.5f, 1.0f}, 0},
+			    {view.slice(0, 10), 1.0f, {1.0f, 1.0f}, 250}, // Crosses a tile boundary
+			    {view.channel(1), 1.0f, {1.0f, 1.0f}, frames - 100}};
+
+			destA.sum(sources);
+
+			destB.sum(view, 0.5f, {1.0f, 0.25f});
+			destB.sum(monoView.slice(3), 2.0f, {0.5f, 1.0f});
+			destB.slice(250).sum(view.slice(0, 10));
+			destB.slice(frames - 100).sum(view.channel(1));
+
+			REQUIRE(a == b);
+		}
+
+		SECTION("with gain ramp")
+		{
+			std::vector<float> ones(FRAMES * 2, 1.0f);
+			AudioBufferView    src(ones.data(), FRAMES, 2);
+
+			dest.set(src, {1.0f, 1.0f}, {{0.0f, 1.0f}, {1.0f, 0.0f}});
+
+			for (int i = 0; i < FRAMES; i++)
+			{
+				const float t = static_cast<float>(i) / FRAMES;
+				REQUIRE(other[i * 2] == Catch::Approx(t).margin(1e-6));
+				REQUIRE(other[i * 2 + 1] == Catch::Approx(1.0f - t).margin(1e-6));
+			}
+
+			dest.sum(src.channel(0), {1.0f, 1.0f});
+
+			REQUIRE(other[0] == 1.0f);
+			REQUIRE(other[1] == 2.0f);
+			REQUIRE(other[(FRAMES - 1) * 2] == Catch::Approx(2.0f - 1.0f / FRAMES));
+		}
+
+		SECTION("stereo onto channel")
+		{
+			dest.channel(0).set(view.channel(1));
+
+			REQUIRE(other[0] == 1.0f);
+			REQUIRE(other[1] == 1.0f);
+			REQUIRE(other[2] == 3.0f);
+		}
+
+		SECTION("multichannel")
+		{
+			const int          channels = 6;
+			std::vector<float> surround(FRAMES * channels, 1.0f);
+			AudioBufferView    dest6(surround.data(), FRAMES, channels);
+
+			AudioBufferView::Pan pan = AudioBufferView::UNITY_PAN;
+			pan[5]                   = 0.5f;
+
+			dest6.sum(view.channel(0), 2.0f, pan); // Mono spread over 6 channels
+
+			REQUIRE(surround[0] == 1.0f);
+			REQUIRE(surround[4] == 1.0f);
+			REQUIRE(surround[5] == 1.0f);
+			REQUIRE(surround[channels] == 5.0f);
+			REQUIRE(surround[channels + 5] == 3.0f);
+
+			std::vector<float> copy(FRAMES * channels);
+			AudioBufferView    copy6(copy.data(), FRAMES, channels);
+
+			copy6.set(dest6, 1.0f, {0.0f, 1.0f}); // Unlisted channels get 0
+
+			REQUIRE(copy[channels + 1] == 5.0f);
+			REQUIRE(copy[channels + 0] == 0.0f);
+			REQUIRE(copy[channels + 2] == 0.0f);
+
+			copy6.set(dest6, {0.0f, 1.0f});
+
+			REQUIRE(copy[channels + 3] == Catch::Approx(5.0f / FRAMES));
+
+			std::array<ChannelStats, channels> stats;
+			dest6.analyze(stats);
+
+			REQUIRE(stats[4].max == static_cast<float>(FRAMES * 4 - 3));
+			REQUIRE(stats[5].min == 1.0f);
+		}
+
+		SECTION("channel conversion")
+		{
+			std::vector<float> mono(FRAMES, 1.0f);
+			AudioBufferView    monoView(mono.data(), FRAMES, 1);
+
+			monoView.sum(view); // Default stereo to mono is (L + R) / 2
+
+			for (int i = 0; i < FRAMES; i++)
+				REQUIRE(mono[i] == Catch::Approx(1.0f + (i * 4 + 1) / 2.0f));
+
+			monoView.set(view, {0.0f, 1.0f}); // Same, with gain ramp
+
+			REQUIRE(mono[0] == 0.0f);
+			REQUIRE(mono[FRAMES / 2] == Catch::Approx((FRAMES * 2 + 1) / 4.0f));
+
+			ChannelMatrix swap = ChannelMatrix::makeZero(2, 2);
+			swap.set(0, 1, 1.0f);
+			swap.set(1, 0, 0.5f);
+
+			dest.set(view, swap, 2.0f);
+
+			REQUIRE(other[0] == 2.0f);
+			REQUIRE(other[1] == 0.0f);
+			REQUIRE(other[2] == 6.0f);
+			REQUIRE(other[3] == 2.0f);
+			REQUIRE(swap.getRow(1)[0] == 0.5f);
+			REQUIRE(swap.getRow(1)[1] == 0.0f);
+
+			std::vector<float> surround(FRAMES * 6);
+			for (int i = 0; i < FRAMES * 6; i++)
+				surround[i] = static_cast<float>(i % 6);
+
+			dest.set(AudioBufferView(surround.data(), FRAMES, 6)); // 6 to 2
+
+			REQUIRE(other[0] == Catch::Approx((0.0f + 2.0f + 4.0f) / 3.0f));
+			REQUIRE(other[1] == Catch::Approx((1.0f + 3.0f + 5.0f) / 3.0f));
+
+			/* Default matrices are cached. Stereo to quad fills the first two
+			channels: set() silences the others, sum() leaves them alone. */
+
+			const ChannelMatrix& cached = ChannelMatrix::getDefault(6, 2);
+			REQUIRE(&cached == &ChannelMatrix::getDefault(6, 2));
+			REQUIRE(cached.get(1, 5) == ChannelMatrix::makeDefault(6, 2).get(1, 5));
+
+			std::vector<float> quad(FRAMES * 4, 7.0f);
+			AudioBufferView    quadView(quad.data(), FRAMES, 4);
+
+			quadView.sum(view);
+			REQUIRE(quad[4 + 0] == 7.0f + view[1][0]);
+			REQUIRE(quad[4 + 3] == 7.0f);
+
+			quadView.set(view);
+			REQUIRE(quad[4 + 1] == view[1][1]);
+			REQUIRE(quad[4 + 2] == 0.0f);
+			REQUIRE(quad[4 + 3] == 0.0f);
+		}
+
+		SECTION("fractional rate")
+		{
+			/* Both channels of 'view' are straight lines: left is 2 * i, right
+			is 2 * i + 1. */
+
+			REQUIRE(dest.set(view, 0.0, 1.0) == FRAMES);
+			REQUIRE(other == data);
+
+			REQUIRE(dest.set(view, 0.0, 0.5) == FRAMES / 2.0);
+			for (int i = 0; i < FRAMES; i++)
+			{
+				REQUIRE(other[i * 2] == static_cast<float>(i));
+				REQUIRE(other[i * 2 + 1] == static_cast<float>(i + 1));
+			}
+
+			dest.set(view, 1.0, 0.25, Interpolation::HERMITE);
+			for (int i = 0; i < FRAMES; i++)
+				REQUIRE(other[i * 2] == Catch::Approx(2.0 + i * 0.5));
+
+			/* Two consecutive blocks match a single one. */
+
+			std::vector<float> whole(FRAMES * 2);
+			AudioBufferView(whole.data(), FRAMES, 2).set(view, 3.0, 0.75, Interpolation::HERMITE);
+			const double next = dest.slice(0, 100).set(view, 3.0, 0.75, Interpolation::HERMITE);
+			REQUIRE(next == 78.0);
+			dest.slice(100).set(view, next, 0.75, Interpolation::HERMITE);
+			REQUIRE(other == whole);
+
+			/* Stops at the end of the source. */
+
+			std::fill(other.begin(), other.end(), 1.0f);
+			REQUIRE(dest.set(view.slice(0, 10), 0.0, 2.0) == 10.0);
+			REQUIRE(other[8] == 16.0f);
+			REQUIRE(other[10] == 1.0f);
+			REQUIRE(dest.set(view.slice(0, 10), 10.0, 2.0) == 10.0);
+
+			/* Gain and channel conversion. */
+
+			std::vector<float> mono(FRAMES, 1.0f);
+			AudioBufferView(mono.data(), FRAMES, 1).sum(view, 0.0, 0.5, Interpolation::LINEAR, 2.0f);
+			for (int i = 0; i < FRAMES; i++)
+				REQUIRE(mono[i] == Catch::Approx(2.0f + i * 2.0f));
+		}
+	}
+}
@@ -0,0 +1,117 @@
+#include "src/audioRingBuffer.hpp"
+#include <atomic>
+#include <catch2/catch_test_macros.hpp>
+#include <thread>
+#include <vector>
+
+using namespace mcl;
+
+TEST_CASE("AudioRingBuffer")
+{
+	static const int BUFFER_SIZE = 100;
+
+	AudioRingBuffer ring(BUFFER_SIZE, 2);
+
+	std::vector<float> data(BUFFER_SIZE * 2 * 2);
+	for (std::size_t i = 0; i < data.size(); i++)
+		data[i] = static_cast<float>(i);
+
+	AudioBufferView src(data.data(), BUFFER_SIZE * 2, 2);
+
+	SECTION("test properties")
+	{
+		REQUIRE(ring.countFrames() == BUFFER_SIZE);
+		REQUIRE(ring.countChannels() == 2);
+		REQUIRE(ring.countReadable() == 0);
+		REQUIRE(ring.countWritable() == BUFFER_SIZE);
+	}
+
+	SECTION("test write and read")
+	{
+		REQUIRE(ring.write(src.slice(0, 30)) == 30);
+		REQUIRE(ring.countReadable() == 30);
+		REQUIRE(ring.countWritable() == BUFFER_SIZE - 30);
+
+		std::vector<float> out(40 * 2);
+		AudioBufferView    dest(out.data(), 40, 2);
+
+		REQUIRE(ring.read(dest) == 30);
+		REQUIRE(out[0] == 0.0f);
+		REQUIRE(out[59] == 59.0f);
+		REQUIRE(ring.countReadable() == 0);
+	}
+
+	SECTION("test full buffer")
+	{
+		REQUIRE(ring.write(src) == BUFFER_SIZE);
+		REQUIRE(ring.countWritable() == 0);
+		REQUIRE(ring.write(src) == 0);
+		REQUIRE(ring.prepareWrite().countFrames() == 0);
+	}
+
+	SECTION("test wrap around")
+	{
+		ring.write(src.slice(0, 70));
+		ring.commitRead(ring.prepareRead(60).countFrames());
+		ring.write(src.slice(70, 50));
+
+		AudioRingBuffer::Region region = ring.prepareRead();
+
+		REQUIRE(region.countFrames() == 60);
+		REQUIRE(region.first.countFrames() == 40);
+		REQUIRE(region.second.countFrames() == 20);
+		REQUIRE(region.first[0][0] == 120.0f);
+		REQUIRE(region.second[0][1] == 201.0f);
+
+		/* Read in place, summing both parts onto a destination. */
+
+		std::vector<float> out(60 * 2, 1.0f);
+		AudioBufferView    dest(out.data(), 60, 2);
+
+		dest.sum(region.first);
+		dest.slice(region.first.countFrames()).sum(region.second);
+		ring.commitRead(region.countFrames());
+
+		REQUIRE(out[0] == 121.0f);
+		REQUIRE(out[119] == 240.0f);
+		REQUIRE(ring.countReadable() == 0);
+	}
+
+	SECTION("test producer and consumer threads")
+	{
+		static const int TOTAL_FRAMES = 50000;
+
+		std::atomic<int> errors = 0;
+
+		std::thread producer([&] {
+			std::vector<float> block(32);
+			int                frame = 0;
+			while (frame < TOTAL_FRAMES)
+			{
+				const int count = std::min(16, TOTAL_FRAMES - frame);
+				for (int i = 0; i < count; i++)
+					block[i * 2] = block[i * 2 + 1] = static_cast<float>(frame + i);
+				frame += ring.write(AudioBufferView(block.data(), count, 2));
+			}
+		});
+
+		std::thread consumer([&] {
+			std::vector<float> block(2 * 23);
+			int                frame = 0;
+			while (frame < TOTAL_FRAMES)
+			{
+				const int count = ring.read(AudioBufferView(block.data(), 23, 2));
+				for (int i = 0; i < count; i++)
+					if (block[i * 2] != static_cast<float>(frame + i) || block[i * 2 + 1] != block[i * 2])
+						errors++;
+				frame += count;
+			}
+		});
+
+		producer.join();
+		consumer.join();
+
+		REQUIRE(errors == 0);
+		REQUIRE(ring.countReadable() == 0);
+	}
+}
@@ -0,0 +1,108 @@
+#include "src/compactAudioBuffer.hpp"
+#include "src/audioBuffer.hpp"
+#include <algorithm>
+#include <catch2/catch_approx.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <limits>
+#include <utility>
+
+using namespace mcl;
+
+TEST_CASE("CompactAudioBuffer")
+{
+	static const int BUFFER_SIZE = 3001; // Beyond a single scratch tile
+
+	AudioBuffer stereo(BUFFER_SIZE, 2), mono(BUFFER_SIZE, 1);
+	stereo.forEachSample([](float& v, int i) {
+		v = static_cast<float>((i * 37 + 11) % 101) / 200.0f - 0.25f;
+	});
+	mono.set(std::as_const(stereo).view().channel(0));
+
+	const AudioBufferView stereoView = std::as_const(stereo).view();
+	const AudioBufferView monoView   = std::as_const(mono).view();
+
+	/* Tolerances: int16 resolution relative to the peak, half has 11 bits of 
+	mantissa. */
+
+	const float int16Margin = stereoView.getPeak(0) / 32767.0f;
+	const float halfMargin  = 0.25f / 2048.0f;
+
+	SECTION("test encoding")
+	{
+		CompactAudioBuffer int16(stereoView, CompactFormat::INT16);
+		CompactAudioBuffer half(stereoView, CompactFormat::FLOAT16);
+
+		REQUIRE(int16.countFrames() == BUFFER_SIZE);
+		REQUIRE(int16.countChannels() == 2);
+		REQUIRE(int16.getBytes() == BUFFER_SIZE * 2 * 2);
+		REQUIRE(int16.getScale() == std::max(stereoView.getPeak(0), stereoView.getPeak(1)));
+		REQUIRE(half.getFormat() == CompactFormat::FLOAT16);
+
+		for (int i = 0; i < BUFFER_SIZE; i++)
+			for (int ch = 0; ch < 2; ch++)
+			{
+				REQUIRE(int16.view().get(i, ch) == Catch::Approx(stereo[i][ch]).margin(int16Margin));
+				REQUIRE(half.view().get(i, ch) == Catch::Approx(stereo[i][ch]).margin(halfMargin));
+			}
+
+		REQUIRE(int16.view().slice(10).get(0, 1) == int16.view().get(10, 1));
+		REQUIRE(int16.view().slice(10, 5).countFrames() == 5);
+		REQUIRE(CompactAudioBuffer(AudioBuffer(16, 1).view(), CompactFormat::INT16).getScale() == 1.0f);
+	}
+
+	SECTION("test non-finite samples")
+	{
+		AudioBuffer broken(stereo);
+		broken[5][0] = std::numeric_limits<float>::quiet_NaN();
+		broken[6][1] = std::numeric_limits<float>::infinity();
+		broken[7][1] = -std::numeric_limits<float>::infinity();
+
+		CompactAudioBuffer int16(std::as_const(broken).view(), CompactFormat::INT16);
+
+		REQUIRE(int16.getScale() == Catch::Approx(std::max(stereoView.getPeak(0), stereoView.getPeak(1))));
+		REQUIRE(int16.view().get(5, 0) == 0.0f);
+		REQUIRE(int16.view().get(6, 1) == 0.0f);
+		REQUIRE(int16.view().get(7, 1) == 0.0f);
+		REQUIRE(int16.view().get(8, 0) == Catch::Approx(stereo[8][0]).margin(int16Margin));
+	}
+
+	SECTION("test sum and set")
+	{
+		const AudioBuffer::Pan pan = {0.5f, 0.75f, 0.25f};
+
+		for (CompactFormat format : {CompactFormat::INT16, CompactFormat::FLOAT16})
+		{
+			const float margin = (format == CompactFormat::INT16 ? int16Margin : halfMargin) * 2.0f;
+
+			/* Layout pairs, covering both the direct kernels and the scratch
+			path with channel conversions and strides. */
+
+			for (auto [srcChannels, destChannels] : {std::pair{1, 1}, std::pair{2, 2}, std::pair{1, 2}, std::pair{2, 1}, std::pair{1, 3}})
+			{
+				const AudioBufferView    src = srcChannels == 1 ? monoView : stereoView;
+				const CompactAudioBuffer compact(src, format);
+
+				AudioBuffer expected(BUFFER_SIZE, destChannels), dest(BUFFER_SIZE, destChannels);
+				expected.set(src, 0.8f, pan);
+				expected.sum(src, 0.5f);
+				dest.set(compact, 0.8f, pan);
+				dest.sum(compact, 0.5f);
+
+				for (int i = 0; i < BUFFER_SIZE; i++)
+					for (int ch = 0; ch < destChannels; ch++)
+						REQUIRE(dest[i][ch] == Catch::Approx(expected[i][ch]).margin(margin));
+			}
+		}
+	}
+
+	SECTION("test strided destination")
+	{
+		CompactAudioBuffer compact(monoView, CompactFormat::FLOAT16);
+		AudioBuffer        dest(BUFFER_SIZE, 2);
+
+		dest.view().channel(1).set(compact.view().slice(1));
+		REQUIRE(dest[0][0] == 0.0f);
+		REQUIRE(dest[0][1] == Catch::Approx(mono[1][0]).margin(halfMargin));
+		REQUIRE(dest[BUFFER_SIZE - 1][1] == 0.0f); // Shorter source
+	}
+}
@@ -0,0 +1,106 @@
+#include "src/denormals.hpp"
+#include "src/audioBuffer.hpp"
+#include "src/audioBufferView.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <cfloat>
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <vector>
+
+using namespace mcl;
+
+namespace
+{
+bool isSubnormal(float f) { return std::fpclassify(f) == FP_SUBNORMAL; }
+
+/* multiply
+Goes through volatiles, so that the compiler can't fold the product at build 
+time, with its own rules. */
+
+float multiply(float a, float b)
+{
+	volatile float x = a, y = b;
+	return x * y;
+}
+} // namespace
+
+TEST_CASE("Denormals")
+{
+	const float NAN_F = std::numeric_limits<float>::quiet_NaN();
+	const float INF_F = std::numeric_limits<float>::infinity();
+
+	SECTION("test flushDenormals")
+	{
+		std::vector<float> data = {FLT_MIN / 2, -FLT_MIN / 4, FLT_MIN, -1.0f, INF_F, NAN_F, 0.0f, FLT_MIN / 8};
+		AudioBufferView    view(data.data(), 4, 2);
+
+		view.channel(1).flushDenormals();
+
+		REQUIRE(data[0] == FLT_MIN / 2); // Left alone
+		REQUIRE(data[1] == 0.0f);
+		REQUIRE(std::signbit(data[1]));
+		REQUIRE(data[7] == 0.0f);
+
+		view.flushDenormals();
+
+		REQUIRE(data[0] == 0.0f);
+		REQUIRE(data[2] == FLT_MIN);
+		REQUIRE(data[3] == -1.0f);
+		REQUIRE(data[4] == INF_F);
+		REQUIRE(std::isnan(data[5]));
+		REQUIRE(data[6] == 0.0f);
+	}
+
+	SECTION("test software mode")
+	{
+		AudioBuffer src(64, 2), dest(64, 2);
+		src.forEachSample([](float& v, int) { v = FLT_MIN; });
+
+		REQUIRE(!denormals::isSoftwareFlushEnabled());
+		{
+			denormals::ScopedFlushToZero guard(denormals::Mode::SOFTWARE);
+			REQUIRE(guard.getMode() == denormals::Mode::SOFTWARE);
+			{
+				denormals::ScopedFlushToZero nested(denormals::Mode::SOFTWARE);
+				REQUIRE(denormals::isSoftwareFlushEnabled());
+			}
+			REQUIRE(denormals::isSoftwareFlushEnabled());
+
+			dest.set(src, 0.5f);
+			REQUIRE(std::as_const(dest)[10][1] == 0.0f);
+
+			AudioBuffer copy(src);
+			copy.applyGain(0.25f);
+			copy.forEachSample([](float& v, int) { REQUIRE(v == 0.0f); });
+
+			copy.set(src, 1.0f);
+			copy.applyGain({1.0f, 0.0f});
+			copy.forEachSample([](float& v, int) { REQUIRE(!isSubnormal(v)); });
+		}
+		REQUIRE(!denormals::isSoftwareFlushEnabled());
+
+		dest.set(src, 0.5f);
+		REQUIRE(isSubnormal(std::as_const(dest)[10][1]));
+	}
+
+	SECTION("test hardware mode")
+	{
+		if (!denormals::isHardwareSupported())
+			return;
+
+		REQUIRE(isSubnormal(multiply(FLT_MIN, 0.5f)));
+		{
+			denormals::ScopedFlushToZero guard;
+			REQUIRE(guard.getMode() == denormals::Mode::HARDWARE);
+			REQUIRE(!denormals::isSoftwareFlushEnabled());
+			REQUIRE(multiply(FLT_MIN, 0.5f) == 0.0f);
+			{
+				denormals::ScopedFlushToZero nested;
+				REQUIRE(multiply(FLT_MIN, 0.5f) == 0.0f);
+			}
+			REQUIRE(multiply(FLT_MIN, 0.5f) == 0.0f); // Nested guard restores the outer state
+		}
+		REQUIRE(isSubnormal(multiply(FLT_MIN, 0.5f)));
+	}
+}
@@ -0,0 +1,69 @@
+#include "src/expression.hpp"
+#include <array>
+#include <catch2/catch_approx.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <vector>
+
+using namespace mcl;
+
+TEST_CASE("Expression")
+{
+	static const int FRAMES = 300;
+
+	std::vector<float> srcData(FRAMES * 2), sendData(FRAMES), destData(FRAMES * 2, 1.0f);
+	for (int i = 0; i < FRAMES * 2; i++)
+		srcData[i] = static_cast<float>((i * 37 + 11) % 101) / 50.0f - 1.0f;
+	for (int i = 0; i < FRAMES; i++)
+		sendData[i] = static_cast<float>(i) / FRAMES;
+
+	AudioBufferView src(srcData.data(), FRAMES, 2);
+	AudioBufferView send(sendData.data(), FRAMES, 1);
+	AudioBufferView dest(destData.data(), FRAMES, 2);
+
+	SECTION("test same result as separate passes")
+	{
+		std::vector<float> refData(FRAMES * 2);
+		AudioBufferView    ref(refData.data(), FRAMES, 2);
+		ref.set(src, 0.5f, {1.0f, 0.25f});
+		ref.applyGain(0.8f);
+		ref.sum(send, 0.3f);
+
+		std::array<float, 2> peaks;
+		assign(dest, expression::Term(src, 0.5f, {1.0f, 0.25f}) * 0.8f + send * 0.3f, peaks);
+
+		for (int i = 0; i < FRAMES * 2; i++)
+			REQUIRE(destData[i] == Catch::Approx(refData[i]));
+		REQUIRE(peaks[0] == Catch::Approx(ref.getPeak(0)));
+		REQUIRE(peaks[1] == Catch::Approx(ref.getPeak(1)));
+	}
+
+	SECTION("test accumulate")
+	{
+		accumulate(dest, src * 2.0f);
+
+		for (int i = 0; i < FRAMES * 2; i++)
+			REQUIRE(destData[i] == Catch::Approx(1.0f + srcData[i] * 2.0f));
+	}
+
+	SECTION("test shortest source wins")
+	{
+		assign(dest, src * 1.0f + send.slice(0, 10) * 1.0f);
+
+		REQUIRE(destData[9 * 2] == Catch::Approx(srcData[9 * 2] + sendData[9]));
+		REQUIRE(destData[10 * 2] == 1.0f);
+	}
+
+	SECTION("test in place and multichannel")
+	{
+		assign(dest, dest * 0.5f);
+		REQUIRE(destData[0] == 0.5f);
+
+		std::vector<float>   multiData(FRAMES * 4, 1.0f);
+		AudioBufferView      multi(multiData.data(), FRAMES, 4);
+		std::array<float, 4> peaks;
+		accumulate(multi, send * 2.0f, peaks);
+
+		REQUIRE(multiData[(FRAMES - 1) * 4 + 3] == Catch::Approx(1.0f + sendData[FRAMES - 1] * 2.0f));
+		REQUIRE(peaks[3] == Catch::Approx(1.0f + sendData[FRAMES - 1] * 2.0f));
+	}
+}
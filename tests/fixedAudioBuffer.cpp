@@ -0,0 +1,136 @@
+#include "src/fixedAudioBuffer.hpp"
+#include "src/audioBuffer.hpp"
+#include "src/denormals.hpp"
+#include "src/memory.hpp"
+#include <catch2/catch_approx.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+
+using namespace mcl;
+
+TEST_CASE("FixedAudioBuffer")
+{
+	static constexpr int BUFFER_SIZE = 128;
+
+	FixedAudioBuffer<BUFFER_SIZE, 2> buffer;
+	FixedAudioBuffer<BUFFER_SIZE, 1> mono;
+
+	for (int i = 0; i < BUFFER_SIZE; i++)
+	{
+		buffer[i][0] = static_cast<float>(i);
+		buffer[i][1] = static_cast<float>(-i);
+		mono[i][0]   = static_cast<float>(i) * 0.5f;
+	}
+
+	SECTION("test layout")
+	{
+		static_assert(FixedAudioBuffer<BUFFER_SIZE, 2>::countFrames() == BUFFER_SIZE);
+		static_assert(FixedAudioBuffer<BUFFER_SIZE, 2>::countChannels() == 2);
+		static_assert(FixedAudioBuffer<BUFFER_SIZE, 2>::countSamples() == BUFFER_SIZE * 2);
+
+		REQUIRE(reinterpret_cast<std::uintptr_t>(buffer[0]) % memory::ALIGNMENT == 0);
+		REQUIRE(buffer.view().countFrames() == BUFFER_SIZE);
+		REQUIRE(buffer.view().countChannels() == 2);
+		REQUIRE(buffer.view().getData() == buffer[0]);
+
+		FixedAudioBuffer<BUFFER_SIZE, 2> zeroed;
+		REQUIRE(zeroed.getPeak(0) == 0.0f);
+		REQUIRE(zeroed.getPeak(1) == 0.0f);
+	}
+
+	SECTION("test sum and set, same result as AudioBuffer")
+	{
+		const AudioBuffer::Pan pan = {0.5f, 0.25f};
+
+		AudioBuffer expected(BUFFER_SIZE, 2);
+		expected.set(buffer.view(), 0.8f);
+		expected.sum(mono.view(), 2.0f, pan);
+
+		FixedAudioBuffer<BUFFER_SIZE, 2> dest;
+		dest.set(buffer, 0.8f);
+		dest.sum(mono, 2.0f, pan);
+
+		for (int i = 0; i < BUFFER_SIZE; i++)
+			for (int ch = 0; ch < 2; ch++)
+				REQUIRE(dest[i][ch] == Catch::Approx(expected[i][ch]));
+	}
+
+	SECTION("test downmix falls back to views")
+	{
+		FixedAudioBuffer<BUFFER_SIZE, 1> dest;
+		dest.set(buffer);
+
+		AudioBuffer expected(BUFFER_SIZE, 1);
+		expected.set(buffer.view());
+
+		for (int i = 0; i < BUFFER_SIZE; i++)
+			REQUIRE(dest[i][0] == Catch::Approx(expected[i][0]));
+	}
+
+	SECTION("test interop with AudioBuffer")
+	{
+		AudioBuffer other(BUFFER_SIZE * 2, 2);
+		other.sum(buffer.view());
+		REQUIRE(other[BUFFER_SIZE - 1][1] == -(BUFFER_SIZE - 1));
+		REQUIRE(other[BUFFER_SIZE][0] == 0.0f);
+
+		FixedAudioBuffer<BUFFER_SIZE, 2> dest;
+		dest.set(std::as_const(other).view().slice(1));
+		REQUIRE(dest[0][0] == 1.0f);
+		REQUIRE(dest[BUFFER_SIZE - 1][0] == 0.0f);
+	}
+
+	SECTION("test clear and gain")
+	{
+		buffer.applyGain(2.0f);
+		REQUIRE(buffer[3][0] == 6.0f);
+		REQUIRE(buffer[3][1] == -6.0f);
+		REQUIRE(buffer.getPeak(0) == (BUFFER_SIZE - 1) * 2.0f);
+
+		buffer.applyGain(Ramp<float>{0.0f, 1.0f});
+		REQUIRE(buffer[0][0] == 0.0f);
+		REQUIRE(buffer[64][0] == Catch::Approx(64.0f * 2.0f * 0.5f));
+
+		buffer.clear();
+		REQUIRE(buffer.getPeak(0) == 0.0f);
+		REQUIRE(buffer.getPeak(1) == 0.0f);
+	}
+
+	SECTION("test denormals in software mode")
+	{
+		FixedAudioBuffer<BUFFER_SIZE, 2> tiny;
+		FixedAudioBuffer<BUFFER_SIZE, 1> tinyMono;
+		for (int i = 0; i < BUFFER_SIZE; i++)
+		{
+			tiny[i][0] = tiny[i][1] = FLT_MIN;
+			tinyMono[i][0]          = FLT_MIN;
+		}
+
+		auto isFlushed = [](const FixedAudioBuffer<BUFFER_SIZE, 2>& b) {
+			for (int i = 0; i < BUFFER_SIZE; i++)
+				for (int ch = 0; ch < 2; ch++)
+					if (std::fpclassify(b[i][ch]) == FP_SUBNORMAL)
+						return false;
+			return true;
+		};
+
+		denormals::ScopedFlushToZero guard(denormals::Mode::SOFTWARE);
+
+		FixedAudioBuffer<BUFFER_SIZE, 2> dest;
+		dest.set(tiny, 0.5f);
+		REQUIRE(isFlushed(dest));
+		REQUIRE(dest[10][1] == 0.0f);
+
+		dest.set(tiny);
+		dest.sum(tinyMono, -0.75f);
+		REQUIRE(isFlushed(dest));
+
+		dest.set(tiny);
+		dest.applyGain(0.25f);
+		REQUIRE(isFlushed(dest));
+		REQUIRE(dest[BUFFER_SIZE - 1][0] == 0.0f);
+	}
+}
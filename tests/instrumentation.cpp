@@ -0,0 +1,65 @@
+#include "src/instrumentation.hpp"
+#include "src/audioBuffer.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <thread>
+
+using namespace mcl;
+using namespace mcl::instrumentation;
+
+TEST_CASE("Instrumentation")
+{
+	registerThread();
+
+	/* Other tests run instrumented code too: only look at the difference 
+	between two snapshots. */
+
+	const Snapshot before = getSnapshot();
+
+	AudioBuffer a(1024, 2);
+	AudioBuffer b(a);
+	b[0][0] = 1.0f;
+	a.sum(b, 1.0f);
+	a.applyGain(0.5f);
+	a.applyGain(Ramp<float>{1.0f, 0.5f});
+
+	std::thread([] {
+		AudioBuffer c(512, 1);
+	}).join();
+
+	const Snapshot after = getSnapshot();
+
+	auto diff = [&](Operation op) {
+		const Counters x = after.getTotal(op), y = before.getTotal(op);
+		return Counters{x.calls - y.calls, x.frames - y.frames, x.bytes - y.bytes, x.nanoseconds - y.nanoseconds};
+	};
+
+	if constexpr (!isEnabled())
+	{
+		REQUIRE(after.threads.empty());
+		REQUIRE(diff(Operation::MIX).calls == 0);
+		return;
+	}
+
+	SECTION("test counters")
+	{
+		REQUIRE(diff(Operation::ALLOC).calls == 3);
+		REQUIRE(diff(Operation::ALLOC).bytes == (2048 + 2048 + 512) * sizeof(float));
+		REQUIRE(diff(Operation::COPY).calls == 1);
+		REQUIRE(diff(Operation::COPY).frames == 1024);
+		REQUIRE(diff(Operation::CLEAR).calls == 2);
+		REQUIRE(diff(Operation::MIX).calls == 1);
+		REQUIRE(diff(Operation::MIX).bytes == 2048 * sizeof(float));
+		REQUIRE(diff(Operation::APPLY_GAIN).calls == 2);
+		REQUIRE(diff(Operation::APPLY_GAIN).frames == 2048);
+	}
+
+	SECTION("test threads")
+	{
+		REQUIRE(after.threads.size() == before.threads.size() + 1);
+
+		bool found = false;
+		for (const ThreadSnapshot& thread : after.threads)
+			found |= thread.thread == std::this_thread::get_id();
+		REQUIRE(found);
+	}
+}
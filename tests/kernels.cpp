@@ -0,0 +1,334 @@
+#include "src/kernels.hpp"
+#include <bit>
+#include <catch2/catch_approx.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+using namespace mcl;
+
+namespace
+{
+/* 
+makeSignal
+Returns 'count' samples of deterministic, non trivial fake data. */
+
+std::vector<float> makeSignal(int count, float seed)
+{
+	std::vector<float> out(count);
+	for (int i = 0; i < count; i++)
+		out[i] = static_cast<float>((i * 37 + 11) % 101) / 50.0f - 1.0f + seed;
+	return out;
+}
+
+void testKernels(const kernels::Table& t, int frames)
+{
+	const kernels::Table& ref = kernels::getTable(kernels::Isa::SCALAR);
+
+	const std::vector<float> stereo = makeSignal(frames * 2, 0.1f);
+	const std::vector<float> mono   = makeSignal(frames, 0.2f);
+	const std::vector<float> dest   = makeSignal(frames * 2, 0.3f);
+
+	auto check = [&](auto kernel, auto refKernel, const std::vector<float>& src) {
+		std::vector<float> a = dest, b = dest;
+		kernel(a.data(), src.data(), frames, 0.5f, 0.25f);
+		refKernel(b.data(), src.data(), frames, 0.5f, 0.25f);
+		for (int i = 0; i < frames * 2; i++)
+			REQUIRE(a[i] == Catch::Approx(b[i]));
+	};
+
+	check(t.sumStereo, ref.sumStereo, stereo);
+	check(t.setStereo, ref.setStereo, stereo);
+	check(t.sumMono, ref.sumMono, mono);
+	check(t.setMono, ref.setMono, mono);
+	check(t.sumDownmix, ref.sumDownmix, stereo);
+	check(t.setDownmix, ref.setDownmix, stereo);
+
+	auto checkRamp = [&](auto kernel, auto refKernel, const std::vector<float>& src) {
+		std::vector<float> a = dest, b = dest;
+		kernel(a.data(), src.data(), frames, 0.5f, 1.0f, 0.001f, -0.002f);
+		refKernel(b.data(), src.data(), frames, 0.5f, 1.0f, 0.001f, -0.002f);
+		for (int i = 0; i < frames * 2; i++)
+			REQUIRE(a[i] == Catch::Approx(b[i]).margin(1e-6));
+	};
+
+	checkRamp(t.sumStereoRamp, ref.sumStereoRamp, stereo);
+	checkRamp(t.setStereoRamp, ref.setStereoRamp, stereo);
+	checkRamp(t.sumMonoRamp, ref.sumMonoRamp, mono);
+	checkRamp(t.setMonoRamp, ref.setMonoRamp, mono);
+
+	{
+		const std::vector<float> right = makeSignal(frames, 0.4f);
+		std::vector<float>       a = dest, b = dest;
+		t.interleaveStereo(a.data(), mono.data(), right.data(), frames);
+		ref.interleaveStereo(b.data(), mono.data(), right.data(), frames);
+		REQUIRE(a == b);
+
+		std::vector<float> la(frames), ra(frames), lb(frames), rb(frames);
+		t.deinterleaveStereo(la.data(), ra.data(), stereo.data(), frames);
+		ref.deinterleaveStereo(lb.data(), rb.data(), stereo.data(), frames);
+		REQUIRE(la == lb);
+		REQUIRE(ra == rb);
+	}
+
+	{
+		const int                 samples = frames * 2;
+		std::vector<std::int16_t> int16(samples);
+		std::vector<std::int32_t> int32(samples);
+		std::vector<double>       float64(samples);
+		std::vector<std::uint8_t> int24(samples * 3);
+		for (int i = 0; i < samples; i++)
+		{
+			int16[i]   = static_cast<std::int16_t>(stereo[i] * 30000.0f);
+			int32[i]   = static_cast<std::int32_t>(stereo[i] * 2000000000.0f);
+			float64[i] = stereo[i];
+			std::memcpy(&int24[i * 3], &int32[i], 3);
+		}
+
+		auto checkDecoder = [&](auto kernel, auto refKernel, const void* src) {
+			std::vector<float> a(samples), b(samples);
+			kernel(a.data(), src, samples);
+			refKernel(b.data(), src, samples);
+			REQUIRE(a == b);
+		};
+
+		checkDecoder(t.decodeInt16, ref.decodeInt16, int16.data());
+		checkDecoder(t.decodeInt24, ref.decodeInt24, int24.data());
+		checkDecoder(t.decodeInt32, ref.decodeInt32, int32.data());
+		checkDecoder(t.decodeFloat64, ref.decodeFloat64, float64.data());
+
+		auto checkEncoder = [&](auto kernel, auto refKernel, int sampleSize) {
+			for (float dither : {0.0f, 1.0f})
+			{
+				std::vector<std::uint8_t> a(samples * sampleSize), b(samples * sampleSize);
+				std::uint32_t             stateA[kernels::DITHER_LANES] = {1, 2, 3, 4, 5, 6, 7, 8};
+				std::uint32_t             stateB[kernels::DITHER_LANES] = {1, 2, 3, 4, 5, 6, 7, 8};
+				kernel(a.data(), dest.data(), samples, dither, stateA); // 'dest' goes beyond [-1.0, 1.0]
+				refKernel(b.data(), dest.data(), samples, dither, stateB);
+				REQUIRE(a == b);
+				REQUIRE(std::memcmp(stateA, stateB, sizeof(stateA)) == 0);
+			}
+		};
+
+		checkEncoder(t.encodeInt16, ref.encodeInt16, 2);
+		checkEncoder(t.encodeInt24, ref.encodeInt24, 3);
+		checkEncoder(t.encodeInt32, ref.encodeInt32, 4);
+		checkEncoder(t.encodeFloat64, ref.encodeFloat64, 8);
+	}
+
+	for (int channels : {1, 2})
+	{
+		kernels::Stats a[2], b[2];
+		t.analyze(stereo.data(), frames * 2 / channels, channels, 0.9f, a);
+		ref.analyze(stereo.data(), frames * 2 / channels, channels, 0.9f, b);
+		for (int ch = 0; ch < channels; ch++)
+		{
+			REQUIRE(a[ch].min == b[ch].min);
+			REQUIRE(a[ch].max == b[ch].max);
+			REQUIRE(a[ch].sumSquares == Catch::Approx(b[ch].sumSquares));
+			REQUIRE(a[ch].clipped == b[ch].clipped);
+		}
+	}
+
+	/* Packed mono and stereo, plus the left channel of 'stereo' (stride 2). */
+
+	for (auto [channels, srcStride] : {std::pair{1, 1}, std::pair{2, 2}, std::pair{1, 2}})
+	{
+		const int srcFrames = frames * 2 / srcStride;
+		for (double step : {0.37, 1.0, 1.73})
+		{
+			const double pos = 0.25;
+			const int    n   = srcFrames > 0 ? static_cast<int>((srcFrames - 1 - pos) / step) + 1 : 0;
+
+			auto checkResampler = [&](auto kernel, auto refKernel) {
+				std::vector<float> a(n * channels), b(n * channels);
+				kernel(a.data(), stereo.data(), srcFrames, srcStride, channels, n, pos, step);
+				refKernel(b.data(), stereo.data(), srcFrames, srcStride, channels, n, pos, step);
+				REQUIRE(a == b);
+			};
+
+			checkResampler(t.resampleLinear, ref.resampleLinear);
+			checkResampler(t.resampleHermite, ref.resampleHermite);
+		}
+	}
+
+	/* Compact formats, over an odd amount of samples too. Half bit patterns 
+	are spread over the whole range, subnormals, infinities and NaNs 
+	included. */
+
+	for (int samples : {frames * 2, frames})
+	{
+		std::vector<std::uint16_t> bits(samples);
+		for (int i = 0; i < samples; i++)
+			bits[i] = static_cast<std::uint16_t>(i * 40503);
+
+		auto checkCompact = [&](auto kernel, auto refKernel, const auto* src) {
+			std::vector<float> a = dest, b = dest;
+			kernel(a.data(), src, samples, 0.5f, -0.25f);
+			refKernel(b.data(), src, samples, 0.5f, -0.25f);
+			for (int i = 0; i < frames * 2; i++)
+				REQUIRE((a[i] == b[i] || (std::isnan(a[i]) && std::isnan(b[i]))));
+		};
+
+		const auto* int16 = reinterpret_cast<const std::int16_t*>(bits.data());
+		checkCompact(t.sumInt16, ref.sumInt16, int16);
+		checkCompact(t.setInt16, ref.setInt16, int16);
+		checkCompact(t.sumHalf, ref.sumHalf, bits.data());
+		checkCompact(t.setHalf, ref.setHalf, bits.data());
+	}
+
+	/* Envelopes, in place too. 'mono' and 'dest' make do as gains. */
+
+	{
+		std::vector<float> a(frames * 2), b(frames * 2);
+		t.applyEnvelope(a.data(), stereo.data(), frames, mono.data());
+		ref.applyEnvelope(b.data(), stereo.data(), frames, mono.data());
+		REQUIRE(a == b);
+
+		t.crossfade(a.data(), a.data(), stereo.data(), frames * 2, dest.data(), stereo.data());
+		ref.crossfade(b.data(), b.data(), stereo.data(), frames * 2, dest.data(), stereo.data());
+		for (int i = 0; i < frames * 2; i++)
+			REQUIRE(a[i] == Catch::Approx(b[i]));
+	}
+
+	/* Denormal flushing, on bit patterns spread over the whole range. */
+
+	{
+		std::vector<float> a(frames * 2), b(frames * 2);
+		for (int i = 0; i < frames * 2; i++)
+			a[i] = b[i] = std::bit_cast<float>(static_cast<std::uint32_t>(i) * 2654435761u >> (i % 9));
+
+		t.flushDenormals(a.data(), frames * 2);
+		ref.flushDenormals(b.data(), frames * 2);
+		for (int i = 0; i < frames * 2; i++)
+			REQUIRE(std::bit_cast<std::uint32_t>(a[i]) == std::bit_cast<std::uint32_t>(b[i])); // NaNs included
+	}
+}
+} // namespace
+
+TEST_CASE("Kernels")
+{
+	REQUIRE(kernels::isSupported(kernels::Isa::SCALAR));
+	REQUIRE(kernels::isSupported(kernels::getBestIsa()));
+
+	SECTION("test scalar reference")
+	{
+		const kernels::Table& t = kernels::getTable(kernels::Isa::SCALAR);
+
+		std::vector<float> dest = {1.0f, 1.0f, 1.0f, 1.0f};
+		std::vector<float> src  = {2.0f, 4.0f};
+
+		t.sumMono(dest.data(), src.data(), 2, 0.5f, 1.0f);
+		REQUIRE(dest == std::vector<float>{2.0f, 3.0f, 3.0f, 5.0f});
+
+		t.setStereo(dest.data(), dest.data(), 2, 2.0f, 0.0f);
+		REQUIRE(dest == std::vector<float>{4.0f, 0.0f, 6.0f, 0.0f});
+
+		kernels::Stats stats[2];
+		t.analyze(dest.data(), 2, 2, 5.0f, stats);
+		REQUIRE(stats[0].min == 4.0f);
+		REQUIRE(stats[0].max == 6.0f);
+		REQUIRE(stats[0].sumSquares == 52.0);
+		REQUIRE(stats[0].clipped == 1);
+		REQUIRE(stats[1].max == 0.0f);
+		REQUIRE(stats[1].clipped == 0);
+
+		std::vector<float> left = {1.0f, 2.0f}, right = {3.0f, 4.0f};
+		t.interleaveStereo(dest.data(), left.data(), right.data(), 2);
+		REQUIRE(dest == std::vector<float>{1.0f, 3.0f, 2.0f, 4.0f});
+
+		t.deinterleaveStereo(right.data(), left.data(), dest.data(), 2);
+		REQUIRE(left == std::vector<float>{3.0f, 4.0f});
+		REQUIRE(right == std::vector<float>{1.0f, 2.0f});
+
+		std::vector<std::int16_t> int16 = {-32768, 0, 16384, 32767};
+		std::vector<float>        decoded(4);
+		t.decodeInt16(decoded.data(), int16.data(), 4);
+		REQUIRE(decoded == std::vector<float>{-1.0f, 0.0f, 0.5f, 32767.0f / 32768.0f});
+
+		std::uint32_t      state[kernels::DITHER_LANES] = {1, 1, 1, 1, 1, 1, 1, 1};
+		std::vector<float> floats                       = {-2.0f, 0.25f, 1.0f, 0.00001f};
+		t.encodeInt16(int16.data(), floats.data(), 4, 0.0f, state);
+		REQUIRE(int16 == std::vector<std::int16_t>{-32768, 8192, 32767, 0}); // Clipped
+
+		std::uint8_t int24[6];
+		floats = {-0.5f, 1.0f / 8388608.0f};
+		t.encodeInt24(int24, floats.data(), 2, 0.0f, state);
+		t.decodeInt24(decoded.data(), int24, 2);
+		REQUIRE(decoded[0] == -0.5f);
+		REQUIRE(decoded[1] == 1.0f / 8388608.0f);
+
+		std::vector<float> ramp = {0.0f, 2.0f, 4.0f}, resampled(6);
+		t.resampleLinear(resampled.data(), ramp.data(), 3, 1, 1, 6, 0.0, 0.5);
+		REQUIRE(resampled == std::vector<float>{0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 4.0f}); // Last frame repeated
+
+		ramp.push_back(6.0f);
+		t.resampleHermite(resampled.data(), ramp.data(), 4, 1, 1, 2, 1.0, 0.5);
+		REQUIRE(resampled[0] == 2.0f);
+		REQUIRE(resampled[1] == 3.0f); // Straight lines stay straight
+
+		const std::vector<std::int16_t> compact = {100, -200, 300};
+		dest                                   = {1.0f, 1.0f, 1.0f, 1.0f};
+		t.sumInt16(dest.data(), compact.data(), 3, 0.5f, 2.0f);
+		REQUIRE(dest == std::vector<float>{51.0f, -399.0f, 151.0f, 1.0f});
+
+		const std::vector<std::uint16_t> halves = {0x3C00, 0xC000, 0x3800};
+		t.setHalf(dest.data(), halves.data(), 3, 1.0f, 0.5f);
+		REQUIRE(dest == std::vector<float>{1.0f, -1.0f, 0.5f, 1.0f});
+
+		const std::vector<float> env = {0.5f, 0.25f, 0.0f, 2.0f};
+		t.applyEnvelope(dest.data(), dest.data(), 4, env.data());
+		REQUIRE(dest == std::vector<float>{0.5f, -0.25f, 0.0f, 2.0f});
+
+		t.crossfade(dest.data(), dest.data(), src.data(), 2, env.data(), env.data() + 2);
+		REQUIRE(dest == std::vector<float>{0.25f, 7.9375f, 0.0f, 2.0f});
+
+		dest = {0x1p-127f, -0x1p-140f, 0x1p-126f, 0.0f};
+		t.flushDenormals(dest.data(), 4);
+		REQUIRE(dest == std::vector<float>{0.0f, 0.0f, 0x1p-126f, 0.0f});
+		REQUIRE(std::signbit(dest[1]));
+	}
+
+	SECTION("test half conversions")
+	{
+		REQUIRE(kernels::halfToFloat(0x0000) == 0.0f);
+		REQUIRE(std::signbit(kernels::halfToFloat(0x8000)));
+		REQUIRE(kernels::halfToFloat(0x0001) == 0x1p-24f); // Smallest subnormal
+		REQUIRE(kernels::halfToFloat(0x03FF) == 1023 * 0x1p-24f);
+		REQUIRE(kernels::halfToFloat(0x0400) == 0x1p-14f);
+		REQUIRE(kernels::halfToFloat(0x7BFF) == 65504.0f);
+		REQUIRE(std::isinf(kernels::halfToFloat(0xFC00)));
+		REQUIRE(std::isnan(kernels::halfToFloat(0x7E00)));
+
+		REQUIRE(kernels::floatToHalf(65519.0f) == 0x7BFF);
+		REQUIRE(kernels::floatToHalf(65520.0f) == 0x7C00); // Overflows
+		REQUIRE(kernels::floatToHalf(1.0f + 0x1p-11f) == 0x3C00); // Ties to even
+		REQUIRE(kernels::floatToHalf(1.0f + 3 * 0x1p-11f) == 0x3C02);
+		REQUIRE(kernels::floatToHalf(0x1p-25f) == 0x0000);
+		REQUIRE(kernels::floatToHalf(0x1p-25f * 3) == 0x0002);
+		REQUIRE(kernels::floatToHalf(-0x1p-30f) == 0x8000);
+
+		/* Every value survives a round trip, NaNs aside. */
+
+		for (int h = 0; h < 0x10000; h++)
+		{
+			const float f = kernels::halfToFloat(static_cast<std::uint16_t>(h));
+			if (!std::isnan(f))
+				REQUIRE(kernels::floatToHalf(f) == h);
+		}
+	}
+
+	SECTION("test each instruction set against the scalar reference")
+	{
+		for (kernels::Isa isa : {kernels::Isa::SSE2, kernels::Isa::AVX2, kernels::Isa::NEON})
+		{
+			if (!kernels::isSupported(isa))
+				continue;
+			for (int frames : {0, 1, 3, 7, 8, 17, 64, 1023})
+				testKernels(kernels::getTable(isa), frames);
+		}
+	}
+}
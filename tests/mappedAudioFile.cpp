@@ -0,0 +1,123 @@
+#include "src/mappedAudioFile.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace mcl;
+
+namespace
+{
+void writeBytes(const std::string& path, const std::vector<char>& bytes)
+{
+	std::ofstream file(path, std::ios::binary);
+	file.write(bytes.data(), bytes.size());
+}
+
+void append(std::vector<char>& out, const void* data, std::size_t size)
+{
+	const char* p = static_cast<const char*>(data);
+	out.insert(out.end(), p, p + size);
+}
+
+void appendU16(std::vector<char>& out, std::uint16_t v) { append(out, &v, 2); }
+void appendU32(std::vector<char>& out, std::uint32_t v) { append(out, &v, 4); }
+
+/* 
+makeWav
+Returns a minimal WAV file with an extra chunk of 'junkSize' bytes before 
+'data'. */
+
+std::vector<char> makeWav(std::uint16_t format, std::uint16_t bits, const std::vector<float>& samples, std::uint32_t junkSize = 4)
+{
+	const std::uint32_t dataSize = static_cast<std::uint32_t>(samples.size() * sizeof(float));
+
+	std::vector<char> out;
+	append(out, "RIFF", 4);
+	appendU32(out, 4 + (8 + 16) + (8 + junkSize) + (8 + dataSize));
+	append(out, "WAVE", 4);
+	append(out, "fmt ", 4);
+	appendU32(out, 16);
+	appendU16(out, format);
+	appendU16(out, 2);         // Channels
+	appendU32(out, 48000);     // Sample rate
+	appendU32(out, 48000 * 8); // Byte rate
+	appendU16(out, 8);         // Block align
+	appendU16(out, bits);
+	append(out, "junk", 4);
+	appendU32(out, junkSize);
+	out.resize(out.size() + junkSize);
+	append(out, "data", 4);
+	appendU32(out, dataSize);
+	append(out, samples.data(), dataSize);
+	return out;
+}
+} // namespace
+
+TEST_CASE("MappedAudioFile")
+{
+	const std::string path = (std::filesystem::temp_directory_path() / "mcl-mapped-audio-file-test.bin").string();
+
+	std::vector<float> samples(64 * 2);
+	for (std::size_t i = 0; i < samples.size(); i++)
+		samples[i] = static_cast<float>(i);
+
+	MappedAudioFile file;
+
+	SECTION("test raw file")
+	{
+		std::vector<char> bytes;
+		append(bytes, samples.data(), samples.size() * sizeof(float));
+		bytes.push_back(0); // Incomplete trailing frame
+		writeBytes(path, bytes);
+
+		REQUIRE(file.openRaw(path, 2));
+		REQUIRE(file.isOpen());
+		REQUIRE(file.countFrames() == 64);
+		REQUIRE(file.countChannels() == 2);
+		REQUIRE(file.getSampleRate() == 0);
+		REQUIRE(file.view()[10][1] == 21.0f);
+
+		file.prefetch(0, 64);
+
+		REQUIRE(file.openRaw(path, 2, 8)); // Skip one frame
+		REQUIRE(file.countFrames() == 63);
+		REQUIRE(file.view()[0][0] == 2.0f);
+	}
+
+	SECTION("test WAV file")
+	{
+		writeBytes(path, makeWav(3, 32, samples));
+
+		REQUIRE(file.openWav(path));
+		REQUIRE(file.countFrames() == 64);
+		REQUIRE(file.countChannels() == 2);
+		REQUIRE(file.getSampleRate() == 48000);
+		REQUIRE(file.view()[63][1] == 127.0f);
+
+		MappedAudioFile moved(std::move(file));
+
+		REQUIRE(!file.isOpen());
+		REQUIRE(moved.view().getPeak(1) == 127.0f);
+	}
+
+	SECTION("test unsupported files")
+	{
+		writeBytes(path, makeWav(1, 16, samples)); // Integer PCM
+
+		REQUIRE(!file.openWav(path));
+		REQUIRE(!file.isOpen());
+
+		writeBytes(path, makeWav(3, 32, samples, 2)); // Misaligned data
+
+		REQUIRE(!file.openWav(path));
+		REQUIRE(!file.openWav(path + ".missing"));
+		REQUIRE(!file.openRaw(path + ".missing", 2));
+	}
+
+	file.close();
+	std::filesystem::remove(path);
+}
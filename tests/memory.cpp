@@ -0,0 +1,29 @@
+#include "src/memory.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+
+using namespace mcl;
+
+TEST_CASE("Memory")
+{
+	SECTION("test padding")
+	{
+		REQUIRE(memory::padSamples(0) == 0);
+		REQUIRE(memory::padSamples(1) == 16);
+		REQUIRE(memory::padSamples(16) == 16);
+		REQUIRE(memory::padSamples(17) == 32);
+	}
+
+	SECTION("test alignment")
+	{
+		for (std::size_t count : {1, 3, 1024, 4097})
+		{
+			float* p = memory::allocAligned(count);
+
+			REQUIRE(reinterpret_cast<std::uintptr_t>(p) % memory::ALIGNMENT == 0);
+
+			p[memory::padSamples(count) - 1] = 0.0f; // Padding must be writable
+			memory::freeAligned(p);
+		}
+	}
+}
@@ -0,0 +1,149 @@
+#include "src/parallel.hpp"
+#include "src/audioBuffer.hpp"
+#include "src/denormals.hpp"
+#include <catch2/catch_approx.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <cfloat>
+#include <cmath>
+#include <utility>
+
+using namespace mcl;
+
+namespace
+{
+/* ReverseScheduler
+Runs tasks serially, from the last one: results must not depend on the 
+order. */
+
+class ReverseScheduler : public parallel::TaskScheduler
+{
+public:
+	void run(int count, const std::function<void(int)>& task) override
+	{
+		for (int i = count - 1; i >= 0; i--)
+			task(i);
+	}
+};
+} // namespace
+
+TEST_CASE("parallel")
+{
+	static const int BUFFER_SIZE = parallel::CHUNK_SAMPLES * 5 + 123;
+
+	parallel::ThreadPool pool(3);
+	parallel::ThreadPool serial(0);
+	ReverseScheduler     reverse;
+
+	AudioBuffer buffer(BUFFER_SIZE, 2);
+	buffer.forEachSample([](float& v, int i) {
+		v = static_cast<float>((i * 37 + 11) % 101) / 50.0f - 1.0f;
+	});
+	const AudioBufferView src = std::as_const(buffer).view();
+
+	SECTION("test chunks")
+	{
+		REQUIRE(pool.countWorkers() == 3);
+		REQUIRE(parallel::countChunks(0, 2) == 0);
+		REQUIRE(parallel::countChunks(BUFFER_SIZE, 1) == 6);
+		REQUIRE(parallel::countChunks(BUFFER_SIZE, 2) == 11);
+	}
+
+	SECTION("test sum, set and applyGain")
+	{
+		AudioBuffer expected(BUFFER_SIZE, 2), dest(BUFFER_SIZE, 2);
+		expected.set(src, 0.5f, {1.0f, 0.25f});
+		expected.applyGain(2.0f);
+		expected.sum(src);
+
+		parallel::set(pool, dest, src, 0.5f, {1.0f, 0.25f});
+		parallel::applyGain(pool, dest, 2.0f);
+		parallel::sum(pool, dest, src);
+
+		for (int i = 0; i < BUFFER_SIZE; i++)
+			for (int ch = 0; ch < 2; ch++)
+				REQUIRE(dest[i][ch] == expected[i][ch]);
+
+		parallel::clear(pool, dest);
+		REQUIRE(dest.view().getPeak(0) == 0.0f);
+		REQUIRE(dest.view().getPeak(1) == 0.0f);
+	}
+
+	SECTION("test mono source")
+	{
+		AudioBuffer mono(BUFFER_SIZE / 2, 1), expected(BUFFER_SIZE, 2), dest(BUFFER_SIZE, 2);
+		mono.set(src.channel(1));
+		expected.set(std::as_const(mono).view());
+
+		parallel::set(pool, dest, std::as_const(mono).view());
+
+		for (int i = 0; i < BUFFER_SIZE; i++)
+			REQUIRE(dest[i][1] == expected[i][1]);
+	}
+
+	SECTION("test reductions")
+	{
+		REQUIRE(parallel::getPeak(pool, src, 0) == src.getPeak(0));
+		REQUIRE(parallel::getPeak(pool, src, 1) == src.getPeak(1));
+
+		std::array<ChannelStats, 2> expected, stats, serialStats, reverseStats;
+		src.analyze(expected, 0.9f);
+		parallel::analyze(pool, src, stats, 0.9f);
+		parallel::analyze(serial, src, serialStats, 0.9f);
+		parallel::analyze(reverse, src, reverseStats, 0.9f);
+
+		for (int ch = 0; ch < 2; ch++)
+		{
+			REQUIRE(stats[ch].peak == expected[ch].peak);
+			REQUIRE(stats[ch].min == expected[ch].min);
+			REQUIRE(stats[ch].max == expected[ch].max);
+			REQUIRE(stats[ch].clipped == expected[ch].clipped);
+			REQUIRE(stats[ch].rms == Catch::Approx(expected[ch].rms));
+
+			/* Deterministic: same bits regardless of threads and order. */
+
+			REQUIRE(stats[ch].sumSquares == serialStats[ch].sumSquares);
+			REQUIRE(stats[ch].sumSquares == reverseStats[ch].sumSquares);
+			REQUIRE(stats[ch].rms == reverseStats[ch].rms);
+		}
+	}
+
+	SECTION("test many batches")
+	{
+		AudioBuffer dest(BUFFER_SIZE, 2);
+		for (int i = 0; i < 200; i++)
+			parallel::set(pool, dest, src, static_cast<float>(i));
+		REQUIRE(dest[BUFFER_SIZE - 1][1] == src[BUFFER_SIZE - 1][1] * 199.0f);
+	}
+
+	SECTION("test denormal guards carry over to workers")
+	{
+		AudioBuffer tiny(BUFFER_SIZE, 2);
+		tiny.forEachSample([](float& v, int) { v = FLT_MIN; });
+
+		auto isFlushed = [](const AudioBuffer& b) {
+			for (int i = 0; i < BUFFER_SIZE; i++)
+				if (b[i][0] != 0.0f || b[i][1] != 0.0f)
+					return false;
+			return true;
+		};
+
+		for (denormals::Mode mode : {denormals::Mode::SOFTWARE, denormals::Mode::HARDWARE})
+		{
+			if (mode == denormals::Mode::HARDWARE && !denormals::isHardwareSupported())
+				continue;
+
+			AudioBuffer dest(BUFFER_SIZE, 2);
+			{
+				denormals::ScopedFlushToZero guard(mode);
+				parallel::set(pool, dest, std::as_const(tiny).view(), 0.5f);
+				REQUIRE(isFlushed(dest));
+
+				dest.set(tiny, 1.0f);
+				parallel::applyGain(pool, dest, 0.25f);
+				REQUIRE(isFlushed(dest));
+			}
+			parallel::set(pool, dest, std::as_const(tiny).view(), 0.5f);
+			REQUIRE(std::fpclassify(std::as_const(dest)[BUFFER_SIZE - 1][1]) == FP_SUBNORMAL);
+		}
+	}
+}
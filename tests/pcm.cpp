@@ -0,0 +1,31 @@
+#include "src/pcm.hpp"
+#include <catch2/catch_test_macros.hpp>
+
+using namespace mcl;
+
+TEST_CASE("Pcm")
+{
+	SECTION("test sample size")
+	{
+		REQUIRE(getPcmSampleSize(PcmFormat::INT16) == 2);
+		REQUIRE(getPcmSampleSize(PcmFormat::INT24) == 3);
+		REQUIRE(getPcmSampleSize(PcmFormat::INT32) == 4);
+		REQUIRE(getPcmSampleSize(PcmFormat::FLOAT32) == 4);
+		REQUIRE(getPcmSampleSize(PcmFormat::FLOAT64) == 8);
+	}
+
+	SECTION("test dither")
+	{
+		Dither a(0.5f, 0), b(0.5f, 0), c(0.5f, 1);
+
+		REQUIRE(a.getAmount() == 0.5f);
+
+		for (int i = 0; i < kernels::DITHER_LANES; i++)
+		{
+			REQUIRE(a.getState()[i] != 0); // Even with a zero seed
+			REQUIRE(a.getState()[i] == b.getState()[i]);
+			REQUIRE(a.getState()[i] != c.getState()[i]);
+		}
+		REQUIRE(a.getState()[0] != a.getState()[1]);
+	}
+}
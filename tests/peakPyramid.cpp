@@ -0,0 +1,239 @@
+#include "src/peakPyramid.hpp"
+#include "src/audioBuffer.hpp"
+#include "src/audioBufferView.hpp"
+#include "src/recordingBuffer.hpp"
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+using namespace mcl;
+
+namespace
+{
+/* scanRange
+Reference: the range of a channel computed frame by frame. */
+
+PeakRange scanRange(AudioBufferView v, int channel, int a, int b)
+{
+	if (a >= b)
+		return {};
+	PeakRange out = {v[a][channel], v[a][channel]};
+	for (int i = a; i < b; i++)
+	{
+		out.min = std::min(out.min, v[i][channel]);
+		out.max = std::max(out.max, v[i][channel]);
+	}
+	return out;
+}
+
+/* checkRanges
+Compares ranges starting and ending anywhere, block boundaries included, 
+against the reference. */
+
+template <typename Signal>
+void checkRanges(const PeakPyramid& pyramid, const Signal& signal, AudioBufferView reference)
+{
+	const int frames = reference.countFrames();
+	for (int ch = 0; ch < reference.countChannels(); ch++)
+		for (int a = 0; a < frames; a = a * 3 + 1)
+			for (int b : {a, a + 1, a + 255, a + 256, frames / 3, frames - 1, frames})
+				if (b >= a && b <= frames)
+					REQUIRE(pyramid.getRange(signal, ch, a, b) == scanRange(reference, ch, a, b));
+}
+} // namespace
+
+TEST_CASE("PeakPyramid")
+{
+	static const int FRAMES = 300000; // 4 levels, last blocks partial
+
+	std::vector<float> data(FRAMES * 2);
+	for (int i = 0; i < FRAMES; i++)
+	{
+		data[i * 2]     = std::sin(i * 0.001f) * (i % 997) / 997.0f;
+		data[i * 2 + 1] = std::cos(i * 0.0003f) * 0.5f;
+	}
+
+	AudioBufferView signal(data.data(), FRAMES, 2);
+	PeakPyramid     pyramid;
+	pyramid.update(signal);
+
+	SECTION("test structure")
+	{
+		REQUIRE(pyramid.countFrames() == FRAMES);
+		REQUIRE(pyramid.countChannels() == 2);
+		REQUIRE(pyramid.countLevels() == 4);
+		REQUIRE(pyramid.countDirtyBlocks() == 0);
+		REQUIRE(pyramid.getRange(signal, 0, 100, 100) == PeakRange{});
+	}
+
+	SECTION("test ranges")
+	{
+		checkRanges(pyramid, signal, signal);
+	}
+
+	SECTION("test invalidation")
+	{
+		data[123456 * 2] = 2.0f;
+		data[290000 * 2] = -3.0f;
+		pyramid.invalidate(123456, 123457);
+		pyramid.invalidate(290000, 290001);
+
+		REQUIRE(pyramid.countDirtyBlocks() == 2);
+
+		pyramid.update(signal);
+
+		REQUIRE(pyramid.countDirtyBlocks() == 0);
+		REQUIRE(pyramid.getRange(signal, 0) == PeakRange{-3.0f, 2.0f});
+		checkRanges(pyramid, signal, signal);
+	}
+
+	SECTION("test repeated invalidation")
+	{
+		/* Ranges already invalid are skipped; the ones sticking out of them, 
+		or far from them, are still flagged. */
+
+		pyramid.invalidate(1000, 2000);
+		pyramid.invalidate(1200, 1300);
+		REQUIRE(pyramid.countDirtyBlocks() == 5);
+
+		pyramid.invalidate(1900, 2600);
+		REQUIRE(pyramid.countDirtyBlocks() == 8);
+
+		pyramid.invalidate(200000, 200001);
+		pyramid.invalidate(1500, 1600);
+		REQUIRE(pyramid.countDirtyBlocks() == 9);
+
+		data[200000 * 2 + 1] = 7.0f;
+		pyramid.invalidate();
+		pyramid.invalidate();
+		REQUIRE(pyramid.countDirtyBlocks() == (FRAMES + 255) / 256);
+
+		pyramid.update(signal);
+		REQUIRE(pyramid.countDirtyBlocks() == 0);
+		REQUIRE(pyramid.getRange(signal, 1).max == 7.0f);
+
+		pyramid.invalidate(0, 10);
+		REQUIRE(pyramid.countDirtyBlocks() == 1);
+	}
+
+	SECTION("test resize")
+	{
+		/* Shrink, then grow back with new content: the pyramid follows. */
+
+		pyramid.update(signal.slice(0, 4000));
+		REQUIRE(pyramid.countLevels() == 2);
+		checkRanges(pyramid, signal.slice(0, 4000), signal.slice(0, 4000));
+
+		std::fill(data.begin() + 4000 * 2, data.end(), 4.0f);
+		pyramid.update(signal);
+		REQUIRE(pyramid.getRange(signal, 1, 3999, 4001).max == 4.0f);
+		checkRanges(pyramid, signal, signal);
+	}
+
+	SECTION("test chunks")
+	{
+		/* Chunk boundaries don't match block boundaries. */
+
+		std::vector<AudioBufferView> chunks;
+		for (int f = 0; f < FRAMES; f += 10000)
+			chunks.push_back(signal.slice(f, std::min(10000, FRAMES - f)));
+
+		PeakPyramid chunked;
+		chunked.update(chunks);
+		checkRanges(chunked, std::span<const AudioBufferView>(chunks), signal);
+	}
+
+	SECTION("test recording")
+	{
+		RecordingBuffer recording(2, FRAMES, 5000);
+		PeakPyramid     live;
+
+		for (int f = 0; f < FRAMES; f += 64000)
+		{
+			recording.reserve(std::min(f + 64000, FRAMES));
+			REQUIRE(recording.append(signal.slice(f, std::min(64000, FRAMES - f))) > 0);
+
+			const std::vector<AudioBufferView> chunks = recording.getChunks();
+			live.update(chunks);
+			REQUIRE(live.getRange(chunks, 0) == scanRange(signal, 0, 0, recording.countFrames()));
+		}
+		checkRanges(live, recording.getChunks(), signal);
+	}
+
+	SECTION("test AudioBuffer")
+	{
+		const int SIZE = 20000;
+
+		AudioBuffer buffer(SIZE, 2);
+		buffer.forEachFrame([](float* frame, int i) {
+			frame[0] = std::sin(i * 0.01f);
+			frame[1] = 0.1f;
+		});
+
+		AudioBuffer reference(buffer);
+		buffer.setPeakPyramid(true);
+
+		REQUIRE(buffer.hasPeakPyramid());
+		REQUIRE(!reference.hasPeakPyramid());
+
+		auto check = [&] {
+			for (int ch = 0; ch < 2; ch++)
+				for (auto [a, b] : {std::pair{0, SIZE}, std::pair{100, 5000}, std::pair{4000, 4100}, std::pair{511, 19999}})
+				{
+					const PeakRange expected = scanRange(std::as_const(buffer).view(), ch, a, b);
+					REQUIRE(buffer.getPeakRange(ch, a, b) == expected);
+					REQUIRE(buffer.getPeak(ch, a, b) == std::max(std::fabs(expected.min), std::fabs(expected.max)));
+				}
+		};
+
+		check();
+
+		buffer.clear(1000, 3000);
+		check();
+
+		buffer.applyGain(0.5f, 8000, 9000); // Samples, not frames
+		check();
+
+		buffer.sum(reference, 500, 0, 4050, 3.0f);
+		check();
+
+		buffer.set(reference.view().slice(10000), -1.0f);
+		buffer.applyGain({1.0f, 2.0f});
+		check();
+
+		buffer[SIZE - 1][1] = -5.0f;
+		check();
+
+		/* Writing frame by frame invalidates the whole buffer each time. */
+
+		for (int i = 0; i < SIZE; i++)
+			buffer[i][0] = (i % 300) * 0.01f;
+		check();
+
+		buffer.resize(SIZE + 1000, AudioBuffer::Init::ZERO);
+		REQUIRE(buffer.getPeakRange(1, SIZE - 1).min == -5.0f);
+		REQUIRE(buffer.getPeakRange(1, SIZE).max == 0.0f);
+
+		/* Without a pyramid, silent frames left out of the scan count as 0.0f. */
+
+		reference.clear(0, 10);
+		REQUIRE(reference.getPeakRange(1).min == 0.0f);
+		REQUIRE(reference.getPeakRange(1, 10).min == 0.1f);
+
+		AudioBuffer copy(buffer);
+		REQUIRE(copy.hasPeakPyramid());
+		REQUIRE(copy.getPeakRange(1, SIZE - 1, SIZE).min == -5.0f);
+
+		/* free() empties the pyramid but keeps it attached. */
+
+		buffer.free();
+		REQUIRE(buffer.hasPeakPyramid());
+
+		buffer.alloc(SIZE, 2);
+		REQUIRE(buffer.getPeakRange(0) == PeakRange{});
+		buffer.set(reference, 0.25f);
+		check();
+	}
+}
@@ -0,0 +1,141 @@
+#include "src/planarAudioBuffer.hpp"
+#include "src/audioBuffer.hpp"
+#include "src/memory.hpp"
+#include <catch2/catch_approx.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+
+using namespace mcl;
+
+TEST_CASE("PlanarAudioBuffer")
+{
+	static const int BUFFER_SIZE = 1027;
+
+	PlanarAudioBuffer buffer(BUFFER_SIZE, 2);
+
+	for (int ch = 0; ch < 2; ch++)
+		for (int i = 0; i < BUFFER_SIZE; i++)
+			buffer.getChannel(ch)[i] = static_cast<float>(i + ch * 10000);
+
+	SECTION("test allocation")
+	{
+		REQUIRE(buffer.isAllocd());
+		REQUIRE(buffer.countFrames() == BUFFER_SIZE);
+		REQUIRE(buffer.countChannels() == 2);
+		REQUIRE(buffer.countSamples() == BUFFER_SIZE * 2);
+
+		for (int ch = 0; ch < 2; ch++)
+		{
+			REQUIRE(buffer.getChannels()[ch] == buffer.getChannel(ch));
+			REQUIRE(reinterpret_cast<std::uintptr_t>(buffer.getChannel(ch)) % memory::ALIGNMENT == 0);
+		}
+
+		PlanarAudioBuffer zeroed(BUFFER_SIZE, 2);
+		REQUIRE(zeroed.getChannelView(0).getPeak(0) == 0.0f);
+		REQUIRE(zeroed.getChannelView(1).getPeak(0) == 0.0f);
+	}
+
+	SECTION("test capacity reuse")
+	{
+		const float* data     = buffer.getChannel(0);
+		const int    capacity = buffer.getCapacity();
+		REQUIRE(capacity >= BUFFER_SIZE * 2);
+
+		buffer.alloc(BUFFER_SIZE / 2, 3);
+		REQUIRE(buffer.getChannel(0) == data);
+		REQUIRE(buffer.getCapacity() == capacity);
+		REQUIRE(buffer.countChannels() == 3);
+		REQUIRE(buffer.getChannelView(2).getPeak(0) == 0.0f);
+		for (int ch = 0; ch < 3; ch++)
+			REQUIRE(reinterpret_cast<std::uintptr_t>(buffer.getChannel(ch)) % memory::ALIGNMENT == 0);
+
+		buffer.alloc(BUFFER_SIZE * 2, 2);
+		REQUIRE(buffer.getCapacity() > capacity);
+		REQUIRE(buffer.getChannelView(1).countFrames() == BUFFER_SIZE * 2);
+
+		buffer.free();
+		REQUIRE(buffer.getCapacity() == 0);
+	}
+
+	SECTION("test channel view")
+	{
+		AudioBufferView view = buffer.getChannelView(1);
+
+		REQUIRE(view.countFrames() == BUFFER_SIZE);
+		REQUIRE(view.countChannels() == 1);
+		REQUIRE(view[5][0] == 10005.0f);
+	}
+
+	SECTION("test clear and gain")
+	{
+		buffer.applyGain(2.0f);
+		REQUIRE(buffer.getChannel(0)[3] == 6.0f);
+		REQUIRE(buffer.getChannel(1)[3] == 20006.0f);
+
+		buffer.clear();
+		REQUIRE(buffer.getChannelView(0).getPeak(0) == 0.0f);
+		REQUIRE(buffer.getChannelView(1).getPeak(0) == 0.0f);
+	}
+
+	SECTION("test copy and move")
+	{
+		PlanarAudioBuffer other(buffer);
+
+		REQUIRE(other.countFrames() == BUFFER_SIZE);
+		REQUIRE(other.getChannel(0) != buffer.getChannel(0));
+		REQUIRE(other.getChannel(1)[7] == 10007.0f);
+
+		PlanarAudioBuffer moved(std::move(other));
+
+		REQUIRE(moved.getChannel(1)[7] == 10007.0f);
+		REQUIRE(!other.isAllocd());
+		REQUIRE(other.countFrames() == 0);
+	}
+
+	SECTION("test interleave and deinterleave")
+	{
+		AudioBuffer interleaved(BUFFER_SIZE, 2, AudioBuffer::Init::UNINITIALIZED);
+
+		interleave(buffer, interleaved);
+
+		for (int i = 0; i < BUFFER_SIZE; i++)
+		{
+			REQUIRE(interleaved[i][0] == static_cast<float>(i));
+			REQUIRE(interleaved[i][1] == static_cast<float>(i + 10000));
+		}
+
+		PlanarAudioBuffer other(BUFFER_SIZE, 2);
+		deinterleave(interleaved, other);
+
+		for (int ch = 0; ch < 2; ch++)
+			for (int i = 0; i < BUFFER_SIZE; i++)
+				REQUIRE(other.getChannel(ch)[i] == buffer.getChannel(ch)[i]);
+	}
+
+	SECTION("test interleave and deinterleave, mono")
+	{
+		PlanarAudioBuffer mono(BUFFER_SIZE, 1);
+		AudioBuffer       interleaved(BUFFER_SIZE, 1);
+
+		mono.getChannel(0)[10] = 3.0f;
+		interleave(mono, interleaved);
+		REQUIRE(interleaved[10][0] == 3.0f);
+
+		interleaved[11][0] = 4.0f;
+		deinterleave(interleaved, mono);
+		REQUIRE(mono.getChannel(0)[11] == 4.0f);
+	}
+
+	SECTION("test interleave and deinterleave, shorter destination")
+	{
+		AudioBuffer interleaved(16, 2);
+
+		interleave(buffer, interleaved);
+		REQUIRE(interleaved[15][1] == 10015.0f);
+
+		interleaved.clear();
+		deinterleave(interleaved, buffer);
+		REQUIRE(buffer.getChannel(1)[15] == 0.0f);
+		REQUIRE(buffer.getChannel(1)[16] == 10016.0f);
+	}
+}
@@ -0,0 +1,129 @@
+#include "src/recordingBuffer.hpp"
+#include "src/audioBuffer.hpp"
+#include <atomic>
+#include <catch2/catch_test_macros.hpp>
+#include <thread>
+
+using namespace mcl;
+
+TEST_CASE("RecordingBuffer")
+{
+	static constexpr int CHUNK_FRAMES = 256;
+	static constexpr int MAX_FRAMES   = CHUNK_FRAMES * 16;
+	static constexpr int BLOCK_SIZE   = 100;
+
+	RecordingBuffer recording(2, MAX_FRAMES, CHUNK_FRAMES, 2);
+
+	/* Blocks carry their absolute frame index, so that any misplaced frame
+	shows up in the final content. */
+
+	AudioBuffer block(BLOCK_SIZE, 2);
+
+	auto fillBlock = [&block](int start) {
+		for (int i = 0; i < BLOCK_SIZE; i++)
+		{
+			block[i][0] = static_cast<float>(start + i);
+			block[i][1] = static_cast<float>(-(start + i));
+		}
+	};
+
+	SECTION("test initial state")
+	{
+		REQUIRE(recording.countFrames() == 0);
+		REQUIRE(recording.countChunks() == 0);
+		REQUIRE(recording.countChannels() == 2);
+		REQUIRE(recording.getMaxFrames() == MAX_FRAMES);
+		REQUIRE(recording.getCapacity() >= CHUNK_FRAMES * 3);
+		REQUIRE(recording.toAudioBuffer().countFrames() == 0);
+	}
+
+	SECTION("test append across chunks")
+	{
+		for (int start = 0; start < BLOCK_SIZE * 10; start += BLOCK_SIZE)
+		{
+			recording.reserve(start + BLOCK_SIZE);
+			fillBlock(start);
+			REQUIRE(recording.append(block) == BLOCK_SIZE);
+		}
+
+		REQUIRE(recording.countFrames() == BLOCK_SIZE * 10);
+		REQUIRE(recording.countChunks() == 4);
+		REQUIRE(recording.getChunk(0).countFrames() == CHUNK_FRAMES);
+		REQUIRE(recording.getChunk(3).countFrames() == BLOCK_SIZE * 10 - CHUNK_FRAMES * 3);
+		REQUIRE(recording.getChunk(1)[0][0] == CHUNK_FRAMES);
+
+		AudioBuffer take = recording.toAudioBuffer();
+		REQUIRE(take.countFrames() == BLOCK_SIZE * 10);
+		for (int i = 0; i < take.countFrames(); i++)
+		{
+			REQUIRE(take[i][0] == static_cast<float>(i));
+			REQUIRE(take[i][1] == static_cast<float>(-i));
+		}
+
+		AudioBuffer part(50, 2);
+		REQUIRE(recording.copyTo(part, 230) == 50);
+		REQUIRE(part[0][0] == 230.0f);
+		REQUIRE(part[49][1] == -279.0f);
+		REQUIRE(recording.copyTo(part, BLOCK_SIZE * 10 - 10) == 10);
+	}
+
+	SECTION("test max frames")
+	{
+		recording.reserve(MAX_FRAMES);
+
+		int appended = 0;
+		for (int start = 0; start < MAX_FRAMES + BLOCK_SIZE; start += BLOCK_SIZE)
+		{
+			fillBlock(start);
+			appended += recording.append(block);
+		}
+		REQUIRE(appended == MAX_FRAMES);
+		REQUIRE(recording.countFrames() == MAX_FRAMES);
+		REQUIRE(recording.append(block) == 0);
+
+		recording.reset();
+		REQUIRE(recording.countFrames() == 0);
+		REQUIRE(recording.getCapacity() == MAX_FRAMES);
+	}
+
+	SECTION("test background growth")
+	{
+		/* The producer never waits: frames dropped while the allocator catches
+		up are simply retried later. */
+
+		std::atomic<bool> done   = false;
+		std::atomic<int>  errors = 0;
+
+		std::thread reader([&] {
+			while (!done.load())
+			{
+				const int frames = recording.countFrames();
+				if (frames > 0 && recording.getChunk((frames - 1) / CHUNK_FRAMES)[(frames - 1) % CHUNK_FRAMES][0] != frames - 1)
+					errors++;
+			}
+		});
+
+		int start = 0;
+		while (start < MAX_FRAMES - BLOCK_SIZE)
+		{
+			fillBlock(start);
+			const int appended = recording.append(block.view().slice(0, BLOCK_SIZE));
+			if (appended < BLOCK_SIZE)
+			{
+				std::this_thread::yield();
+				if (appended > 0)
+					start += appended;
+				continue;
+			}
+			start += BLOCK_SIZE;
+		}
+		done.store(true);
+		reader.join();
+
+		REQUIRE(errors == 0);
+		REQUIRE(recording.countFrames() == start);
+		AudioBuffer take = recording.toAudioBuffer();
+		for (int i = 0; i < take.countFrames(); i++)
+			REQUIRE(take[i][0] == static_cast<float>(i));
+	}
+}